@@ -1,6 +1,6 @@
 #!/usr/bin/env python
 
-# Python script to read the file "blocks.txt", and generate src/blocks.h
+# Python script to read the file "blocks.txt", and generate src/world/block.h
 # if all the block textures exist
 
 def file_exists(path):
@@ -82,12 +82,12 @@ def main():
     blocks = file_str.splitlines()
     block_h = gen_block_h(blocks)
     if block_h is None: return 1
-    with open("src/block.h", "w") as text_file:
+    with open("src/world/block.h", "w") as text_file:
         text_file.write(block_h)
     return 0
 
 if __name__ == "__main__":
     status = main()
     if status != 0:
-        print("Failed to generate src/blocks.h, you're probably missing texture files.");
+        print("Failed to generate src/world/block.h, you're probably missing texture files.");
     exit(status)
@@ -0,0 +1,18 @@
+#version 330 core
+
+out vec4 fragColor;
+
+in vec3 fColour;
+in vec2 fWorldPos;
+in float fFogFactor;
+
+uniform vec3 uInnerMin;
+uniform vec3 uInnerMax;
+
+void main() {
+  // Loaded chunks draw this part of the world
+  if(all(greaterThanEqual(fWorldPos, uInnerMin.xz))
+     && all(lessThanEqual(fWorldPos, uInnerMax.xz))) discard;
+  vec4 fogColor = vec4(0.603,0.761,0.965, 1.f);
+  fragColor = mix(vec4(fColour, 1.f), fogColor, fFogFactor);
+}
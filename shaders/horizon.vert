@@ -0,0 +1,23 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPosition;
+layout(location = 1) in vec3 aColour;
+
+uniform mat4 uMVP;
+uniform vec3 uPlayerPos;
+uniform float uRenderDistance;
+
+out vec3 fColour;
+out vec2 fWorldPos;
+out float fFogFactor;
+
+void main() {
+  gl_Position = uMVP * vec4(aPosition, 1.0);
+  fColour = aColour;
+  fWorldPos = aPosition.xz;
+  float fog_near = uRenderDistance / 2.f;
+  float fog_far = uRenderDistance;
+  float dist = distance(aPosition, uPlayerPos);
+  dist = clamp(dist, fog_near, fog_far);
+  fFogFactor = (dist - fog_near) / (fog_far - fog_near);
+}
@@ -11,11 +11,13 @@
 
 #define VSYNC 0
 
-Game *create_game(void) {
+Game *create_game(uint32_t seed, const char *save_dir) {
   char err_msg[1024]                = {0};
   nu_Window *window                 = NULL;
   SkyRenderer *sky_renderer         = NULL;
   Player *player                    = NULL;
+  Player *view                      = NULL;
+  Sim *sim                          = NULL;
   World *world                      = NULL;
   Game *game                        = NULL;
   UiRenderer *ui_renderer           = NULL;
@@ -49,21 +51,29 @@ Game *create_game(void) {
 
   // Create camera
   player = create_player();
-  if (!player) {
+  view   = create_player();
+  if (!player || !view) {
     sprintf(err_msg,
         "(create_game): Error creating game: create_player() returned NULL\n");
     goto failure;
   }
 
   // Create world
-  uint32_t seed = time(NULL);
-  world         = create_world(seed);
+  world = create_world(seed, save_dir);
   if (!world) {
     sprintf(err_msg,
         "(create_game): Error creating game: create_world() returned NULL\n");
     goto failure;
   }
 
+  // Create the simulation, it ticks the player and world on its own thread
+  sim = create_sim(world, player);
+  if (!sim || !sim_start(sim)) {
+    sprintf(err_msg,
+        "(create_game): Error creating game: couldn't start the sim\n");
+    goto failure;
+  }
+
   // Create ui_renderer
   ui_renderer = create_ui_renderer();
   if (!ui_renderer) {
@@ -120,9 +130,12 @@ Game *create_game(void) {
 
 failure:
   fprintf(stderr, "%.1023s", err_msg);
+  world_stop(world);
+  destroy_sim(&sim);
   nu_destroy_window(&window);
   destroy_sky_renderer(&sky_renderer);
   destroy_player(&player);
+  destroy_player(&view);
   destroy_world(&world);
   destroy_ui_renderer(&ui_renderer);
   destroy_text_renderer(&text_renderer);
@@ -137,6 +150,8 @@ success:
   game->window           = window;
   game->sky_renderer     = sky_renderer;
   game->player           = player;
+  game->view             = view;
+  game->sim              = sim;
   game->world            = world;
   game->ui_renderer      = ui_renderer;
   game->text_renderer    = text_renderer;
@@ -147,15 +162,25 @@ success:
   game->this_time        = glfwGetTime();
   game->delta_time       = 0.f;
   game->frame_count      = 0;
+  game->pending_press    = 0;
+  game->pending_time     = 0.0;
+  game->edit_ms          = 0.0;
+  game->edit_max_ms      = 0.0;
   game->debug            = false;
   return game;
 }
 
 void destroy_game(Game **game) {
   if (!game || !(*game)) { return; }
+  // Stop ticking before anything the ticks use goes away. The render thread
+  // no longer drains the world's render queue, so stop the world first or a
+  // tick waiting on a full queue would never return
+  world_stop((*game)->world);
+  destroy_sim(&(*game)->sim);
   nu_destroy_window(&(*game)->window);
   destroy_sky_renderer(&(*game)->sky_renderer);
   destroy_player(&(*game)->player);
+  destroy_player(&(*game)->view);
   destroy_world(&(*game)->world);
   destroy_ui_renderer(&(*game)->ui_renderer);
   destroy_text_renderer(&(*game)->text_renderer);
@@ -194,44 +219,51 @@ void update_game(Game *game) {
   // Update timings
   game_update_time(game);
 
-  // Update player based on input
-  game->player->dt = game->delta_time;
-  if (nu_get_key_state(game->window, GLFW_KEY_S)) {
-    player_backwards(game->player);
-  }
-  if (nu_get_key_state(game->window, GLFW_KEY_W)) {
-    player_forwards(game->player);
-  }
-  if (nu_get_key_state(game->window, GLFW_KEY_A)) { player_left(game->player); }
-  if (nu_get_key_state(game->window, GLFW_KEY_D)) { player_right(game->player); }
-  player_set_jumping(
-      game->player, nu_get_key_state(game->window, GLFW_KEY_SPACE));
-  player_set_crouching(
-      game->player, nu_get_key_state(game->window, GLFW_KEY_LEFT_SHIFT));
-  player_set_sprinting(game->player,
-      nu_get_key_pressed(game->window, GLFW_KEY_LEFT_CONTROL)
-          || (nu_get_key_pressed(game->window, GLFW_KEY_W)
-              && nu_get_key_state(game->window, GLFW_KEY_LEFT_CONTROL)));
-  player_set_zooming(game->player, nu_get_key_state(game->window, GLFW_KEY_F));
-  player_rotate(game->player,
+  // Mouse look turns the view straight away, the sim picks it up with the
+  // rest of the input
+  player_rotate(game->view,
       nu_get_delta_mouse_x(game->window),
       -nu_get_delta_mouse_y(game->window));
-  player_update(game->player, game->world);
-  if (game->window->mouse_left && !game->window->last_mouse_left) {
-    player_break(game->player, game->world);
+
+  // Queue this frame's input for the sim
+  nu_Window *window = game->window;
+  SimInput input    = {0};
+  input.yaw         = game->view->camera->yaw;
+  input.pitch       = game->view->camera->pitch;
+  if (nu_get_key_state(window, GLFW_KEY_S)) {
+    input.hold |= SIM_HOLD_BACKWARDS;
+  }
+  if (nu_get_key_state(window, GLFW_KEY_W)) { input.hold |= SIM_HOLD_FORWARDS; }
+  if (nu_get_key_state(window, GLFW_KEY_A)) { input.hold |= SIM_HOLD_LEFT; }
+  if (nu_get_key_state(window, GLFW_KEY_D)) { input.hold |= SIM_HOLD_RIGHT; }
+  if (nu_get_key_state(window, GLFW_KEY_SPACE)) {
+    input.hold |= SIM_HOLD_JUMP;
+  }
+  if (nu_get_key_state(window, GLFW_KEY_LEFT_SHIFT)) {
+    input.hold |= SIM_HOLD_CROUCH;
   }
-  if (game->window->mouse_right && !game->window->last_mouse_right) {
-    player_place(game->player, game->world);
+  if (nu_get_key_state(window, GLFW_KEY_F)) { input.hold |= SIM_HOLD_ZOOM; }
+  if (nu_get_key_pressed(window, GLFW_KEY_LEFT_CONTROL)
+      || (nu_get_key_pressed(window, GLFW_KEY_W)
+          && nu_get_key_state(window, GLFW_KEY_LEFT_CONTROL))) {
+    input.press |= SIM_PRESS_SPRINT;
   }
-  if (nu_get_key_pressed(game->window, GLFW_KEY_X)) {
-    game->debug = !game->debug;
+  if (window->mouse_left && !window->last_mouse_left) {
+    input.press |= SIM_PRESS_BREAK;
   }
+  if (window->mouse_right && !window->last_mouse_right) {
+    input.press |= SIM_PRESS_PLACE;
+  }
+  // Presses are kept until a push gets through, so none are lost
+  input.press_time = game->pending_press ? game->pending_time : sim_get_time();
+  input.press |= game->pending_press;
+  game->pending_press = sim_push_input(game->sim, input) ? 0 : input.press;
+  game->pending_time  = input.press_time;
+
+  if (nu_get_key_pressed(window, GLFW_KEY_X)) { game->debug = !game->debug; }
 
-  // Update world so chunks load around player
-  int nx = (int)(floorf(game->player->position[0] / CHUNK_WIDTH));
-  int ny = (int)(floorf(game->player->position[1] / CHUNK_HEIGHT));
-  int nz = (int)(floorf(game->player->position[2] / CHUNK_LENGTH));
-  world_update_centre(game->world, nx, ny, nz);
+  // Move the view to where the sim is now
+  sim_interpolate(game->sim, game->view);
 
   game->frame_count++;
 
@@ -270,34 +302,109 @@ static void render_debug(Game *game) {
   debug_print(game, str, &cur_y);
 
   // Render position
+  Player *view = game->view;
   sprintf(str,
       "pos: %.2f, %.2f, %.2f",
-      game->player->position[0],
-      game->player->position[1] - game->player->hitbox_dims[1] / 2.f,
-      game->player->position[2]);
+      view->position[0],
+      view->position[1] - view->hitbox_dims[1] / 2.f,
+      view->position[2]);
+  debug_print(game, str, &cur_y);
+
+  // Sim info
+  SimState state = sim_latest(game->sim);
+  sprintf(str,
+      "sim: tick %llu, %.3f ms",
+      (unsigned long long)state.tick,
+      state.tick_ms);
+  debug_print(game, str, &cur_y);
+  sprintf(str,
+      "edit: %.1f ms click to visible, worst %.1f ms",
+      game->edit_ms,
+      game->edit_max_ms);
+  debug_print(game, str, &cur_y);
+
+  // Chunk info, from the render list since chunks belong to the sim
+  int coords[3] = {(int)floorf(view->position[0] / CHUNK_WIDTH),
+      (int)floorf(view->position[1] / CHUNK_HEIGHT),
+      (int)floorf(view->position[2] / CHUNK_LENGTH)};
+  sprintf(str, "chunk: %d, %d, %d", coords[0], coords[1], coords[2]);
+  debug_print(game, str, &cur_y);
+  RenderRecord *record = render_list_find(
+      &game->world->render_list, coords[0], coords[1], coords[2]);
+  sprintf(str, "  num vertices: %zu", record ? record->num_vertices : 0);
   debug_print(game, str, &cur_y);
 
-  // Chunk info
-  Chunk *chunk = world_get_chunkf(game->world,
-      game->player->position[0],
-      game->player->position[1],
-      game->player->position[2]);
-  sprintf(str, "chunk: %p", (void *)chunk);
+  // Queue info
+  WorldStats world_stats = world_get_stats(game->world);
+  sprintf(str,
+      "queue: %zu waiting, %zu active",
+      world_stats.queue_depth,
+      world_stats.queue_active);
+  debug_print(game, str, &cur_y);
+  sprintf(str,
+      "  queued: %zu, coalesced: %zu",
+      world_stats.num_pushed,
+      world_stats.num_coalesced);
+  debug_print(game, str, &cur_y);
+
+  // Render list info
+  sprintf(str,
+      "chunks drawn: %zu of %zu",
+      game->world->render_list.num_visible,
+      game->world->render_list.num_records);
+  debug_print(game, str, &cur_y);
+  sprintf(str, "  sort: %.3f ms", game->world->render_list.sort_ms);
+  debug_print(game, str, &cur_y);
+  sprintf(str,
+      "  vertices drawn: %zu, skipped: %zu",
+      game->world->render_list.num_drawn_vertices,
+      game->world->render_list.num_skipped_vertices);
   debug_print(game, str, &cur_y);
 
-  if (chunk) {
+  // Level of detail rings, only the ones holding chunks
+  for (int lod = 0; lod < CHUNK_LOD_LEVELS; lod++) {
+    size_t records  = game->world->render_list.lod_records[lod];
+    size_t vertices = game->world->render_list.lod_vertices[lod];
+    if (records == 0) { continue; }
     sprintf(str,
-        "  coords: %d, %d, %d",
-        chunk->coords[0],
-        chunk->coords[1],
-        chunk->coords[2]);
+        "  lod %dx: %zu chunks, %zu vertices, %.1f mib",
+        1 << lod,
+        records,
+        vertices,
+        vertices * sizeof(Vertex) / (1024.0 * 1024.0));
     debug_print(game, str, &cur_y);
+  }
 
+  // Horizon info
+  Horizon *horizon = game->world->horizon;
+  if (horizon) {
     sprintf(str,
-        "  num vertices: %zu",
-        chunk->mesh ? chunk->mesh->last_send_size / chunk->mesh->stride : 0);
+        "horizon: %zu of %d tiles, %zu drawn, %.1f of %.1f mib",
+        horizon->num_ready,
+        HORIZON_SLOTS,
+        horizon->num_drawn,
+        horizon->num_ready * HORIZON_TILE_VERTICES * sizeof(HorizonVertex)
+            / (1024.0 * 1024.0),
+        HORIZON_SLOTS * HORIZON_TILE_VERTICES * sizeof(HorizonVertex)
+            / (1024.0 * 1024.0));
     debug_print(game, str, &cur_y);
   }
+
+  // Vertex arena info
+  VertexArena *arena  = &game->world->render_list.arena;
+  SubAllocStats stats = suballoc_stats(&arena->alloc);
+  sprintf(str,
+      "arena: %.1f of %.1f mib, frag %.2f",
+      stats.used * sizeof(Vertex) / (1024.0 * 1024.0),
+      stats.capacity * sizeof(Vertex) / (1024.0 * 1024.0),
+      stats.fragmentation);
+  debug_print(game, str, &cur_y);
+  sprintf(str,
+      "  free ranges: %zu, grows: %zu, compactions: %zu",
+      stats.num_free,
+      arena->num_grows,
+      arena->num_compactions);
+  debug_print(game, str, &cur_y);
 }
 
 void render_game(Game *game) {
@@ -313,24 +420,34 @@ void render_game(Game *game) {
   // Render gradient sky background
   render_sky(game->sky_renderer,
       height,
-      game->player->camera->pitch,
-      game->player->camera->fov);
+      game->view->camera->pitch,
+      game->view->camera->fov);
 
   // Render world
-  render_world(game->world, game->player, aspect);
+  render_world(game->world, game->view, aspect);
 
   // Render clouds
-  render_clouds(game->clouds, game->player, game->this_time, aspect);
+  render_clouds(game->clouds, game->view, game->this_time, aspect);
 
   // Render crosshair
   render_crosshair(game->crosshair, game->ui_renderer, width, height);
 
   // Render block outline
-  render_outline(game->outline_renderer, game->player, width, height);
+  render_outline(game->outline_renderer, game->view, width, height);
 
   if (game->debug) { render_debug(game); }
 
   nu_end_frame(game->window);
+
+  // The frame with the edit's mesh is on screen now
+  RenderList *list = &game->world->render_list;
+  if (list->edit_time > 0.0) {
+    game->edit_ms = (sim_get_time() - list->edit_time) * 1000.0;
+    if (game->edit_ms > game->edit_max_ms) {
+      game->edit_max_ms = game->edit_ms;
+    }
+    list->edit_time = 0.0;
+  }
 }
 
 bool game_over(Game *game) {
@@ -8,6 +8,7 @@
 #include "nuGL.h"
 #include "outline.h"
 #include "player.h"
+#include "sim.h"
 #include "sky.h"
 #include "text_renderer.h"
 #include "ui_renderer.h"
@@ -21,7 +22,9 @@
 typedef struct {
   nu_Window *window;
   SkyRenderer *sky_renderer;
-  Player *player;
+  Player *player; // Simulated on the sim thread
+  Player *view;   // Where the player is drawn, interpolated between ticks
+  Sim *sim;
   World *world;
   UiRenderer *ui_renderer;
   TextRenderer *text_renderer;
@@ -31,10 +34,17 @@ typedef struct {
   float this_time, last_time, delta_time;
   size_t frame_count;
   size_t fps;
+  uint32_t pending_press; // SimPress flags that didn't fit in the input queue
+  double pending_time;    // When the pending presses were made
+  // Time from the last break or place being clicked to the frame showing it,
+  // and the worst so far
+  double edit_ms, edit_max_ms;
   bool debug;
 } Game;
 
-Game *create_game(void);
+// Create the window and everything in the game. save_dir may be NULL, see
+// create_world()
+Game *create_game(uint32_t seed, const char *save_dir);
 void destroy_game(Game **game);
 void update_game(Game *game);
 void render_game(Game *game);
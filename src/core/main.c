@@ -1,7 +1,29 @@
 #include "game.h"
 
-int main(void) {
-  Game *game = create_game();
+static void print_usage(const char *name) {
+  fprintf(stderr,
+      "Usage: %s [-s seed] [-d dir]\n"
+      "  -s seed  World seed (default: the current time)\n"
+      "  -d dir   Load chunks saved in dir, e.g. by pregen -o, when they were\n"
+      "           generated with the same seed\n",
+      name);
+}
+
+int main(int argc, char **argv) {
+  uint32_t seed        = (uint32_t)time(NULL);
+  const char *save_dir = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+      save_dir = argv[++i];
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  Game *game = create_game(seed, save_dir);
   if (!game) {
     fprintf(stderr, "(main): Error: create_game() returned NULL.\n");
     return 1;
@@ -184,7 +184,7 @@ static bool pos_collides_specific(
 }
 
 // Check if a position collides with a solid block in the world
-static bool pos_collides(vec3 pos, vec3 hitbox_dims, World *world) {
+static bool pos_collides(vec3 pos, vec3 hitbox_dims, WorldCursor *cursor) {
   int xa = (int)floorf(pos[0] - hitbox_dims[0] / 2.f);
   int ya = (int)floorf(pos[1] - hitbox_dims[1] / 2.f);
   int za = (int)floorf(pos[2] - hitbox_dims[2] / 2.f);
@@ -192,10 +192,16 @@ static bool pos_collides(vec3 pos, vec3 hitbox_dims, World *world) {
   int yb = (int)floorf(pos[1] + hitbox_dims[1] / 2.f);
   int zb = (int)floorf(pos[2] + hitbox_dims[2] / 2.f);
 
+  // Most boxes have nothing solid in them, which the occupancy bits tell
+  // without looking at each block
+  if (!world_cursor_any_solid(
+          cursor, (int[3]){xa, ya, za}, (int[3]){xb, yb, zb})) {
+    return false;
+  }
   for (int x = xa; x <= xb; x++) {
     for (int y = ya; y <= yb; y++) {
       for (int z = za; z <= zb; z++) {
-        Block *block = world_get_block(world, x, y, z);
+        Block *block = world_cursor_get_block(cursor, x, y, z);
         if (!block || block->type == BlockAir) { continue; }
         if (pos_collides_specific(
                 pos, hitbox_dims, (float)x, (float)y, (float)z)) {
@@ -256,8 +262,95 @@ static void player_apply_horizontal_movement(Player *player) {
   player_accelerate(player, player->movement);
 }
 
-// Apply players velocity, with collisions
-static void player_apply_vel(Player *player, World *world) {
+// Cells a sweep keeps along its axis before it has to move its window
+#define SWEEP_CELLS 64
+
+// The solid voxels a hitbox can run into while it moves along one axis. Each
+// cell along the axis is a slab of the voxels the hitbox covers on the other
+// two axes, looked up the first time a step reaches it, so a voxel is read
+// once per sweep instead of once per step
+typedef struct {
+  WorldCursor *cursor;
+  int axis;
+  int lo[3], hi[3];         // Cells the hitbox covers on each axis, inclusive
+  bool edge_stop;           // Whether slabs are also checked for ground
+  int ground_lo, ground_hi; // Cells on y the hitbox covers 0.01 lower
+  int base;                 // Cell of the first window bit
+  uint64_t known;           // Slabs that have been looked up
+  uint64_t blocked;         // Slabs with a solid voxel in the hitbox's way
+  uint64_t ground;          // Slabs with a solid voxel under the lowered box
+} Sweep;
+
+// First and last cells an open interval overlaps, the same cells
+// pos_collides() checks
+static inline void cell_span(float min, float max, int *lo, int *hi) {
+  *lo = (int)floorf(min);
+  *hi = *lo;
+  while ((float)(*hi + 1) < max) { (*hi)++; }
+}
+
+static void sweep_init(Sweep *sweep, WorldCursor *cursor, vec3 pos,
+    vec3 hitbox_dims, int axis, bool edge_stop) {
+  sweep->cursor    = cursor;
+  sweep->axis      = axis;
+  sweep->edge_stop = edge_stop;
+  for (int k = 0; k < 3; k++) {
+    float h = hitbox_dims[k] * 0.5f;
+    cell_span(pos[k] - h, pos[k] + h, &sweep->lo[k], &sweep->hi[k]);
+  }
+  // The crouch check tests the hitbox moved down by 0.01
+  float lowered = pos[1] - 0.01f;
+  float hy      = hitbox_dims[1] * 0.5f;
+  cell_span(lowered - hy, lowered + hy, &sweep->ground_lo, &sweep->ground_hi);
+  sweep->base    = 0;
+  sweep->known   = 0;
+  sweep->blocked = 0;
+  sweep->ground  = 0;
+}
+
+// Look up one slab along the sweep's axis, returning its window bit
+static uint64_t sweep_slab(Sweep *sweep, int cell) {
+  if (cell < sweep->base || cell >= sweep->base + SWEEP_CELLS) {
+    sweep->base  = cell - SWEEP_CELLS / 2;
+    sweep->known = 0;
+  }
+  uint64_t bit = 1ULL << (cell - sweep->base);
+  if (sweep->known & bit) { return bit; }
+
+  int lo[3] = {sweep->lo[0], sweep->lo[1], sweep->lo[2]};
+  int hi[3] = {sweep->hi[0], sweep->hi[1], sweep->hi[2]};
+  lo[sweep->axis] = hi[sweep->axis] = cell;
+  sweep->blocked &= ~bit;
+  sweep->ground &= ~bit;
+  if (world_cursor_any_solid(sweep->cursor, lo, hi)) { sweep->blocked |= bit; }
+  if (sweep->edge_stop) {
+    lo[1] = sweep->ground_lo;
+    hi[1] = sweep->ground_hi;
+    if (world_cursor_any_solid(sweep->cursor, lo, hi)) { sweep->ground |= bit; }
+  }
+  sweep->known |= bit;
+  return bit;
+}
+
+// Check the hitbox at pos along the sweep's axis, for solid voxels in its
+// way, and with edge_stop for ground under it
+static void sweep_test(Sweep *sweep, float pos, float h, bool *blocked,
+    bool *grounded) {
+  int lo, hi;
+  cell_span(pos - h, pos + h, &lo, &hi);
+  *blocked  = false;
+  *grounded = false;
+  for (int cell = lo; cell <= hi; cell++) {
+    uint64_t bit = sweep_slab(sweep, cell);
+    *blocked |= (sweep->blocked & bit) != 0;
+    *grounded |= (sweep->ground & bit) != 0;
+  }
+}
+
+// Apply players velocity, with collisions. Each axis moves in steps of
+// max_step until a step would overlap a solid voxel, and a crouching player
+// on the ground also stops before a step that would leave nothing under them
+static void player_apply_vel(Player *player, WorldCursor *cursor) {
   vec3 new_pos;
   glm_vec3_copy(player->position, new_pos);
 
@@ -265,33 +358,25 @@ static void player_apply_vel(Player *player, World *world) {
     float remaining      = player->velocity[i] * player->dt;
     const float max_step = 0.05f;
     float step           = (remaining > 0) ? max_step : -max_step;
+    float h              = player->hitbox_dims[i] * 0.5f;
+
+    bool edge_stop = player->grounded && player->is_crouching && i != 1;
+    Sweep sweep;
+    sweep_init(&sweep, cursor, new_pos, player->hitbox_dims, i, edge_stop);
 
     while (fabsf(remaining) > 0.f) {
       float move = (fabsf(remaining) < fabsf(step)) ? remaining : step;
-      vec3 test_pos;
-      glm_vec3_copy(new_pos, test_pos);
-      test_pos[i] += move;
-
-      if (!pos_collides(test_pos, player->hitbox_dims, world)) {
-        if (player->grounded && player->is_crouching && i != 1) {
-          vec3 test_pos_minus;
-          glm_vec3_copy(test_pos, test_pos_minus);
-          test_pos_minus[1] -= 0.01f;
-          if (!pos_collides(test_pos_minus, player->hitbox_dims, world)) {
-            break;
-          } else {
-            new_pos[i] = test_pos[i];
-            remaining -= move;
-          }
-        } else {
-          new_pos[i] = test_pos[i];
-          remaining -= move;
-        }
-      } else {
+      float test = new_pos[i] + move;
+      bool blocked, grounded;
+      sweep_test(&sweep, test, h, &blocked, &grounded);
+      if (blocked) {
         player->velocity[i] = 0.f;
         if (i != 1) { player->keep_sprint = false; }
         break;
       }
+      if (edge_stop && !grounded) { break; }
+      new_pos[i] = test;
+      remaining -= move;
     }
   }
 
@@ -324,19 +409,24 @@ static void player_handle_jump(Player *player) {
   }
 }
 
-static void player_check_grounded(Player *player, World *world) {
+static void player_check_grounded(Player *player, WorldCursor *cursor) {
   vec3 pos_under;
   glm_vec3_copy(player->position, pos_under);
   pos_under[1] -= 0.01f;
-  player->grounded = pos_collides(pos_under, player->hitbox_dims, world);
+  player->grounded = pos_collides(pos_under, player->hitbox_dims, cursor);
 }
 
 static RayCastReturn player_eye_raycast(Player *player, World *world);
 
 // Update a player
 void player_update(Player *player, World *world) {
+  // Every collision check this update reads blocks around the player, so they
+  // share one cursor
+  WorldCursor cursor;
+  world_cursor_init(&cursor, world);
+
   // Check if grounded
-  player_check_grounded(player, world);
+  player_check_grounded(player, &cursor);
 
   // If the player is jumping, jump
   player_handle_jump(player);
@@ -346,7 +436,7 @@ void player_update(Player *player, World *world) {
 
   // Apply forces
   player_apply_gravity(player);
-  player_apply_vel(player, world);
+  player_apply_vel(player, &cursor);
   player_apply_friction(player);
 
   // Set camera position
@@ -402,11 +492,12 @@ static RayCastReturn player_eye_raycast(Player *player, World *world) {
 bool player_break(Player *player, World *world) {
   if (!player || !world) { return false; }
   if (!player->selection.hit || !player->selection.block_hit) { return false; }
-  world_set_block(world,
+  world_edit_block(world,
       BlockAir,
       player->selection.hit_x,
       player->selection.hit_y,
-      player->selection.hit_z);
+      player->selection.hit_z,
+      player->edit_time);
   return true;
 }
 
@@ -422,10 +513,11 @@ bool player_place(Player *player, World *world) {
     return false;
   }
 
-  world_set_block(world,
+  world_edit_block(world,
       BlockStone,
       player->selection.last_x,
       player->selection.last_y,
-      player->selection.last_z);
+      player->selection.last_z,
+      player->edit_time);
   return true;
 }
@@ -39,6 +39,7 @@ typedef struct {
   float zoom_interp;
 
   float dt;                // Deltatime, should be set each frame
+  double edit_time; // When the next break or place was asked for, 0 if unknown
   RayCastReturn selection; // The block that the player is looking at
 } Player;
 
@@ -0,0 +1,171 @@
+#include "sim.h"
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+double sim_get_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Copy what rendering needs out of the player
+static void sim_capture(Sim *sim, SimState *state) {
+  Player *player   = sim->player;
+  state->tick      = sim->tick;
+  state->fov       = player->camera->fov;
+  state->selection = player->selection;
+  state->tick_ms   = 0.0;
+  glm_vec3_copy(player->position, state->position);
+  glm_vec3_copy(player->camera->position, state->eye);
+}
+
+Sim *create_sim(World *world, Player *player) {
+  if (!world || !player) { return NULL; }
+  Sim *sim = calloc(1, sizeof(Sim));
+  if (!sim) {
+    fprintf(stderr, "(create_sim): Error creating sim, calloc failed.\n");
+    return NULL;
+  }
+  if (!mpsc_queue_init(&sim->inputs, SIM_INPUT_CAPACITY, sizeof(SimInput))) {
+    fprintf(stderr,
+        "(create_sim): Error creating sim, mpsc_queue_init() failed.\n");
+    free(sim);
+    return NULL;
+  }
+  sim->world  = world;
+  sim->player = player;
+  sim->yaw    = player->camera->yaw;
+  sim->pitch  = player->camera->pitch;
+  sim_capture(sim, &sim->curr);
+  sim->prev      = sim->curr;
+  sim->curr_time = sim_get_time();
+  pthread_mutex_init(&sim->state_mutex, NULL);
+  return sim;
+}
+
+void destroy_sim(Sim **sim) {
+  if (!sim || !(*sim)) { return; }
+  if ((*sim)->running) {
+    (*sim)->kill = true;
+    pthread_join((*sim)->thread, NULL);
+  }
+  mpsc_queue_free(&(*sim)->inputs);
+  pthread_mutex_destroy(&(*sim)->state_mutex);
+  free(*sim);
+  *sim = NULL;
+}
+
+// Tick on a fixed schedule, sleeping between ticks
+static void *sim_routine(void *arg) {
+  Sim *sim    = (Sim *)arg;
+  double next = sim_get_time();
+  while (!sim->kill) {
+    double now = sim_get_time();
+    for (int i = 0; i < SIM_MAX_CATCH_UP && now >= next; i++) {
+      sim_tick(sim);
+      next += SIM_TICK_TIME;
+    }
+    // Give up on ticks that couldn't be caught up
+    if (now >= next) { next = now; }
+    double wait = next - sim_get_time();
+    if (wait > 0.0) { usleep((useconds_t)(wait * 1e6)); }
+  }
+  return NULL;
+}
+
+bool sim_start(Sim *sim) {
+  if (!sim || sim->running) { return false; }
+  if (pthread_create(&sim->thread, NULL, sim_routine, sim) != 0) {
+    fprintf(
+        stderr, "(sim_start): Error starting sim, pthread_create failed.\n");
+    return false;
+  }
+  sim->running = true;
+  return true;
+}
+
+bool sim_push_input(Sim *sim, SimInput input) {
+  if (!sim) { return false; }
+  return mpsc_queue_push(&sim->inputs, &input);
+}
+
+void sim_tick(Sim *sim) {
+  if (!sim) { return; }
+  double start = sim_get_time();
+
+  // Held keys and orientation come from the newest input, presses from every
+  // input since the last tick so none are missed
+  SimInput input;
+  uint32_t press    = 0;
+  double press_time = 0.0; // When the oldest press was made
+  while (mpsc_queue_pop(&sim->inputs, &input)) {
+    sim->hold  = input.hold;
+    sim->yaw   = input.yaw;
+    sim->pitch = input.pitch;
+    press |= input.press;
+    if (input.press && press_time == 0.0) { press_time = input.press_time; }
+  }
+
+  // Update player based on input
+  Player *player        = sim->player;
+  uint32_t hold         = sim->hold;
+  player->dt            = (float)SIM_TICK_TIME;
+  player->camera->yaw   = sim->yaw;
+  player->camera->pitch = sim->pitch;
+  if (hold & SIM_HOLD_BACKWARDS) { player_backwards(player); }
+  if (hold & SIM_HOLD_FORWARDS) { player_forwards(player); }
+  if (hold & SIM_HOLD_LEFT) { player_left(player); }
+  if (hold & SIM_HOLD_RIGHT) { player_right(player); }
+  player_set_jumping(player, hold & SIM_HOLD_JUMP);
+  player_set_crouching(player, hold & SIM_HOLD_CROUCH);
+  player_set_sprinting(player, press & SIM_PRESS_SPRINT);
+  player_set_zooming(player, hold & SIM_HOLD_ZOOM);
+  player_update(player, sim->world);
+  player->edit_time = press_time;
+  if (press & SIM_PRESS_BREAK) { player_break(player, sim->world); }
+  if (press & SIM_PRESS_PLACE) { player_place(player, sim->world); }
+
+  // Update world so chunks load around player
+  int nx = (int)(floorf(player->position[0] / CHUNK_WIDTH));
+  int ny = (int)(floorf(player->position[1] / CHUNK_HEIGHT));
+  int nz = (int)(floorf(player->position[2] / CHUNK_LENGTH));
+  world_update_centre(sim->world, nx, ny, nz);
+
+  sim->tick++;
+  SimState state;
+  sim_capture(sim, &state);
+  state.tick_ms = (sim_get_time() - start) * 1000.0;
+  pthread_mutex_lock(&sim->state_mutex);
+  sim->prev      = sim->curr;
+  sim->curr      = state;
+  sim->curr_time = sim_get_time();
+  pthread_mutex_unlock(&sim->state_mutex);
+}
+
+SimState sim_latest(Sim *sim) {
+  SimState state = {0};
+  if (!sim) { return state; }
+  pthread_mutex_lock(&sim->state_mutex);
+  state = sim->curr;
+  pthread_mutex_unlock(&sim->state_mutex);
+  return state;
+}
+
+void sim_interpolate(Sim *sim, Player *view) {
+  if (!sim || !view) { return; }
+  pthread_mutex_lock(&sim->state_mutex);
+  SimState prev = sim->prev;
+  SimState curr = sim->curr;
+  double since  = sim_get_time() - sim->curr_time;
+  pthread_mutex_unlock(&sim->state_mutex);
+
+  // Show prev at the moment curr was published, and reach curr a tick later
+  float t = (float)(since / SIM_TICK_TIME);
+  t       = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+  glm_vec3_lerp(prev.position, curr.position, t, view->position);
+  glm_vec3_lerp(prev.eye, curr.eye, t, view->camera->position);
+  view->camera->fov = prev.fov + (curr.fov - prev.fov) * t;
+  view->selection   = curr.selection;
+}
@@ -0,0 +1,101 @@
+#ifndef SIM_H
+
+#define SIM_H
+
+// Includes
+#include "mpsc_queue.h"
+#include "player.h"
+#include "world.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Simulation ticks per second. The player and the world's centre only move on
+// ticks, so physics doesn't depend on the frame rate
+#define SIM_TICK_RATE 60
+#define SIM_TICK_TIME (1.0 / SIM_TICK_RATE)
+// Most ticks run back to back to catch up after a stall, the rest are dropped
+#define SIM_MAX_CATCH_UP 5
+// Frames of input that can wait for a tick
+#define SIM_INPUT_CAPACITY 256
+
+// Keys held during a frame
+typedef enum {
+  SIM_HOLD_FORWARDS  = 1 << 0,
+  SIM_HOLD_BACKWARDS = 1 << 1,
+  SIM_HOLD_LEFT      = 1 << 2,
+  SIM_HOLD_RIGHT     = 1 << 3,
+  SIM_HOLD_JUMP      = 1 << 4,
+  SIM_HOLD_CROUCH    = 1 << 5,
+  SIM_HOLD_ZOOM      = 1 << 6,
+} SimHold;
+
+// Actions that happen once per press
+typedef enum {
+  SIM_PRESS_SPRINT = 1 << 0,
+  SIM_PRESS_BREAK  = 1 << 1,
+  SIM_PRESS_PLACE  = 1 << 2,
+} SimPress;
+
+// Structs
+// One frame of input, queued by the window thread
+typedef struct {
+  uint32_t hold;    // SimHold flags
+  uint32_t press;   // SimPress flags
+  float yaw, pitch; // Camera orientation at the end of the frame
+  double press_time; // When the presses were made, on sim_get_time()'s clock
+} SimInput;
+
+// What rendering needs from a tick
+typedef struct {
+  uint64_t tick;
+  vec3 position; // Player position
+  vec3 eye;      // Camera position
+  float fov;
+  RayCastReturn selection;
+  double tick_ms; // Time the tick took
+} SimState;
+
+typedef struct {
+  World *world;
+  Player *player;   // Only touched by ticks
+  MpscQueue inputs; // SimInputs waiting for the next tick
+  uint32_t hold;    // Keys held as of the newest input
+  float yaw, pitch; // Orientation as of the newest input
+  uint64_t tick;    // Ticks run so far
+  SimState prev, curr; // The last two ticks' states, to interpolate between
+  double curr_time;    // When curr was published, in seconds
+  pthread_mutex_t state_mutex; // Protects prev, curr and curr_time
+  pthread_t thread;
+  bool running; // Whether the tick thread was started
+  volatile bool kill;
+} Sim;
+
+// Function prototypes
+// Create a simulation of a player in a world. Ticks only run when sim_tick()
+// is called, until sim_start() starts the tick thread. Doesn't need a GL
+// context, and doesn't take ownership of the player or the world
+Sim *create_sim(World *world, Player *player);
+// Stop the tick thread, free the simulation, and null the pointer
+void destroy_sim(Sim **sim);
+// Start ticking SIM_TICK_RATE times a second on a thread of its own. Returns
+// false if the thread couldn't be started
+bool sim_start(Sim *sim);
+// Queue a frame of input for the next tick, returns false if the queue is
+// full. Can be called from any thread
+bool sim_push_input(Sim *sim, SimInput input);
+// Run one tick now: apply queued input, move the player, move the world's
+// centre after it, and publish the new state. Only the tick thread may call
+// this once sim_start() has been called
+void sim_tick(Sim *sim);
+// Fill a view player with the state between the last two ticks that matches
+// the current time, so motion is smooth at any frame rate. Rendering runs at
+// most one tick behind. The view's orientation is left alone, so mouse look
+// doesn't wait for a tick
+void sim_interpolate(Sim *sim, Player *view);
+// Get a copy of the newest tick's state
+SimState sim_latest(Sim *sim);
+// Seconds on the clock sim_interpolate() uses
+double sim_get_time(void);
+
+#endif // sim.h
@@ -0,0 +1,106 @@
+#include "coord_set.h"
+
+#include <stdlib.h>
+
+static inline size_t coord_set_hash(int x, int y, int z) {
+  return (size_t)(((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u)
+                  ^ ((uint32_t)z * 83492791u));
+}
+
+// Find the slot holding coords, or the empty slot they would go in
+static size_t coord_set_find(const CoordSet *set, int x, int y, int z) {
+  size_t mask = set->capacity - 1;
+  size_t slot = coord_set_hash(x, y, z) & mask;
+  while (set->used[slot]) {
+    const int *c = set->slots[slot];
+    if (c[0] == x && c[1] == y && c[2] == z) { break; }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+// Move every item into storage of a new capacity
+static bool coord_set_resize(CoordSet *set, size_t capacity) {
+  int(*slots)[3] = malloc(sizeof(int[3]) * capacity);
+  uint8_t *used  = calloc(capacity, sizeof(uint8_t));
+  if (!slots || !used) {
+    if (slots) { free(slots); }
+    if (used) { free(used); }
+    return false;
+  }
+
+  CoordSet grown = {
+      .slots = slots, .used = used, .capacity = capacity, .num_items = 0};
+  for (size_t i = 0; i < set->capacity; i++) {
+    if (!set->used[i]) { continue; }
+    const int *c = set->slots[i];
+    size_t slot  = coord_set_find(&grown, c[0], c[1], c[2]);
+    grown.slots[slot][0] = c[0];
+    grown.slots[slot][1] = c[1];
+    grown.slots[slot][2] = c[2];
+    grown.used[slot]     = 1;
+    grown.num_items++;
+  }
+  coord_set_free(set);
+  *set = grown;
+  return true;
+}
+
+void coord_set_init(CoordSet *set) {
+  if (!set) { return; }
+  *set = (CoordSet){0};
+}
+
+void coord_set_free(CoordSet *set) {
+  if (!set) { return; }
+  if (set->slots) { free(set->slots); }
+  if (set->used) { free(set->used); }
+  *set = (CoordSet){0};
+}
+
+bool coord_set_contains(const CoordSet *set, int x, int y, int z) {
+  if (!set || set->capacity == 0) { return false; }
+  return set->used[coord_set_find(set, x, y, z)];
+}
+
+bool coord_set_insert(CoordSet *set, int x, int y, int z) {
+  if (!set) { return false; }
+  // Keep the set at most half full so probes stay short
+  if ((set->num_items + 1) * 2 > set->capacity) {
+    size_t capacity = set->capacity ? set->capacity * 2 : 64;
+    if (!coord_set_resize(set, capacity)) { return false; }
+  }
+  size_t slot = coord_set_find(set, x, y, z);
+  if (set->used[slot]) { return false; }
+  set->slots[slot][0] = x;
+  set->slots[slot][1] = y;
+  set->slots[slot][2] = z;
+  set->used[slot]     = 1;
+  set->num_items++;
+  return true;
+}
+
+bool coord_set_remove(CoordSet *set, int x, int y, int z) {
+  if (!set || set->capacity == 0) { return false; }
+  size_t mask = set->capacity - 1;
+  size_t hole = coord_set_find(set, x, y, z);
+  if (!set->used[hole]) { return false; }
+  set->used[hole] = 0;
+  set->num_items--;
+
+  // Shift back later items in the run that can't be found past the hole
+  for (size_t slot = (hole + 1) & mask; set->used[slot];
+      slot = (slot + 1) & mask) {
+    const int *c = set->slots[slot];
+    size_t home  = coord_set_hash(c[0], c[1], c[2]) & mask;
+    // The item can stay if its home is cyclically in (hole, slot]
+    if (((slot - home) & mask) < ((slot - hole) & mask)) { continue; }
+    set->slots[hole][0] = c[0];
+    set->slots[hole][1] = c[1];
+    set->slots[hole][2] = c[2];
+    set->used[hole]     = 1;
+    set->used[slot]     = 0;
+    hole                = slot;
+  }
+  return true;
+}
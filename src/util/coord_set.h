@@ -0,0 +1,34 @@
+#ifndef COORD_SET_H
+
+#define COORD_SET_H
+
+// Includes
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Structs
+// Set of integer coordinate triples, e.g. chunk coords. Open addressing with
+// linear probing, grown to stay at most half full, and removals shift later
+// entries back so no tombstones build up
+typedef struct {
+  int (*slots)[3];  // Coords in each slot
+  uint8_t *used;    // Whether each slot holds coords
+  size_t capacity;  // Always a power of 2, or 0 before the first insert
+  size_t num_items;
+} CoordSet;
+
+// Function prototypes
+// Set up an empty set, nothing is allocated until the first insert
+void coord_set_init(CoordSet *set);
+// Free the set's storage
+void coord_set_free(CoordSet *set);
+// Check if coords are in the set
+bool coord_set_contains(const CoordSet *set, int x, int y, int z);
+// Add coords, returns false if they were already in the set or allocation
+// failed
+bool coord_set_insert(CoordSet *set, int x, int y, int z);
+// Remove coords, returns false if they weren't in the set
+bool coord_set_remove(CoordSet *set, int x, int y, int z);
+
+#endif // coord_set.h
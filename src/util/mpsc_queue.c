@@ -0,0 +1,89 @@
+#include "mpsc_queue.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool mpsc_queue_init(MpscQueue *queue, size_t capacity, size_t item_size) {
+  if (!queue || item_size == 0) { return false; }
+  size_t size = 2;
+  while (size < capacity) { size *= 2; }
+
+  queue->items     = malloc(size * item_size);
+  queue->sequences = malloc(size * sizeof(atomic_size_t));
+  if (!queue->items || !queue->sequences) {
+    if (queue->items) { free(queue->items); }
+    if (queue->sequences) { free(queue->sequences); }
+    queue->items     = NULL;
+    queue->sequences = NULL;
+    return false;
+  }
+  // Slot i is free for the push that claims position i
+  for (size_t i = 0; i < size; i++) { atomic_init(&queue->sequences[i], i); }
+  queue->capacity  = size;
+  queue->item_size = item_size;
+  atomic_init(&queue->tail, 0);
+  queue->head = 0;
+  return true;
+}
+
+void mpsc_queue_free(MpscQueue *queue) {
+  if (!queue) { return; }
+  if (queue->items) { free(queue->items); }
+  if (queue->sequences) { free(queue->sequences); }
+  queue->items     = NULL;
+  queue->sequences = NULL;
+  queue->capacity  = 0;
+}
+
+bool mpsc_queue_push(MpscQueue *queue, const void *item) {
+  if (!queue || !queue->items || !item) { return false; }
+  size_t mask = queue->capacity - 1;
+  size_t pos  = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  for (;;) {
+    atomic_size_t *sequence = &queue->sequences[pos & mask];
+    size_t seq    = atomic_load_explicit(sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      // The slot is free, try to claim it. On failure pos is reloaded
+      if (atomic_compare_exchange_weak_explicit(&queue->tail,
+              &pos,
+              pos + 1,
+              memory_order_relaxed,
+              memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the item from a lap ago, the queue is full
+      return false;
+    } else {
+      // Another producer claimed this position first
+      pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    }
+  }
+
+  memcpy(queue->items + (pos & mask) * queue->item_size,
+      item,
+      queue->item_size);
+  atomic_store_explicit(
+      &queue->sequences[pos & mask], pos + 1, memory_order_release);
+  return true;
+}
+
+bool mpsc_queue_pop(MpscQueue *queue, void *item) {
+  if (!queue || !queue->items || !item) { return false; }
+  size_t mask             = queue->capacity - 1;
+  size_t pos              = queue->head;
+  atomic_size_t *sequence = &queue->sequences[pos & mask];
+  // The slot is only ready once its producer has bumped the sequence
+  if (atomic_load_explicit(sequence, memory_order_acquire) != pos + 1) {
+    return false;
+  }
+
+  memcpy(item, queue->items + (pos & mask) * queue->item_size,
+      queue->item_size);
+  // Hand the slot to the push one lap ahead
+  atomic_store_explicit(sequence, pos + queue->capacity, memory_order_release);
+  queue->head = pos + 1;
+  return true;
+}
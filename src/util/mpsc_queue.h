@@ -0,0 +1,48 @@
+#ifndef MPSC_QUEUE_H
+
+#define MPSC_QUEUE_H
+
+// Includes
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Assumed cache line size. Fields that are at least this far apart never
+// share a line, wherever the queue lands
+#define MPSC_QUEUE_CACHE_LINE 64
+
+// Structs
+// Bounded queue of fixed size items that any number of threads can push to
+// and one thread pops from, without locks. Each slot has a sequence number
+// that says whose turn it is: producers claim a slot by moving the tail with
+// a compare and swap, then publish it by bumping its sequence, so the
+// consumer never sees a half written item. Pushing fails instead of waiting
+// when the queue is full. The queue is embedded in calloc'd structs, which
+// don't honour over-alignment, so tail and head are kept off the shared
+// fields' cache lines with padding instead
+typedef struct {
+  unsigned char *items;     // capacity items of item_size bytes
+  atomic_size_t *sequences; // One per slot
+  size_t capacity;          // Always a power of 2
+  size_t item_size;
+  char tail_pad[MPSC_QUEUE_CACHE_LINE];
+  atomic_size_t tail; // Next slot to push, shared by producers
+  char head_pad[MPSC_QUEUE_CACHE_LINE];
+  size_t head; // Next slot to pop, consumer only
+  char end_pad[MPSC_QUEUE_CACHE_LINE];
+} MpscQueue;
+
+// Function prototypes
+// Set up an empty queue with room for at least capacity items, returns false
+// if allocation failed
+bool mpsc_queue_init(MpscQueue *queue, size_t capacity, size_t item_size);
+// Free the queue's storage, items still in it are dropped
+void mpsc_queue_free(MpscQueue *queue);
+// Copy an item onto the queue, returns false if it is full. Can be called
+// from any thread
+bool mpsc_queue_push(MpscQueue *queue, const void *item);
+// Copy the oldest item out of the queue, returns false if it is empty. Only
+// one thread may pop
+bool mpsc_queue_pop(MpscQueue *queue, void *item);
+
+#endif // mpsc_queue.h
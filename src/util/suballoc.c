@@ -0,0 +1,128 @@
+#include "suballoc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Make room for one more free range
+static bool suballoc_reserve(SubAllocator *alloc) {
+  if (alloc->num_free < alloc->free_alloced) { return true; }
+  size_t new_alloced = alloc->free_alloced ? alloc->free_alloced * 2 : 64;
+  SubRange *new_free = realloc(alloc->free, sizeof(SubRange) * new_alloced);
+  if (!new_free) { return false; }
+  alloc->free         = new_free;
+  alloc->free_alloced = new_alloced;
+  return true;
+}
+
+bool suballoc_init(SubAllocator *alloc, size_t capacity) {
+  if (!alloc) { return false; }
+  *alloc = (SubAllocator){0};
+  return suballoc_reset(alloc, 0, capacity);
+}
+
+void suballoc_free(SubAllocator *alloc) {
+  if (!alloc) { return; }
+  if (alloc->free) { free(alloc->free); }
+  *alloc = (SubAllocator){0};
+}
+
+bool suballoc_alloc(SubAllocator *alloc, size_t size, size_t *offset) {
+  if (!alloc || !offset || size == 0) { return false; }
+
+  // Best fit, so big ranges are kept for big allocations
+  size_t best = alloc->num_free;
+  for (size_t i = 0; i < alloc->num_free; i++) {
+    if (alloc->free[i].size < size) { continue; }
+    if (best == alloc->num_free
+        || alloc->free[i].size < alloc->free[best].size) {
+      best = i;
+      if (alloc->free[i].size == size) { break; }
+    }
+  }
+  if (best == alloc->num_free) { return false; }
+
+  SubRange *range = &alloc->free[best];
+  *offset         = range->offset;
+  range->offset += size;
+  range->size -= size;
+  if (range->size == 0) {
+    memmove(&alloc->free[best],
+        &alloc->free[best + 1],
+        sizeof(SubRange) * (alloc->num_free - best - 1));
+    alloc->num_free--;
+  }
+  alloc->used += size;
+  return true;
+}
+
+void suballoc_release(SubAllocator *alloc, size_t offset, size_t size) {
+  if (!alloc || size == 0) { return; }
+
+  // Find the first free range after this one
+  size_t lo = 0, hi = alloc->num_free;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (alloc->free[mid].offset < offset) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  bool joins_prev = lo > 0
+                    && alloc->free[lo - 1].offset + alloc->free[lo - 1].size
+                           == offset;
+  bool joins_next = lo < alloc->num_free
+                    && offset + size == alloc->free[lo].offset;
+  if (joins_prev && joins_next) {
+    alloc->free[lo - 1].size += size + alloc->free[lo].size;
+    memmove(&alloc->free[lo],
+        &alloc->free[lo + 1],
+        sizeof(SubRange) * (alloc->num_free - lo - 1));
+    alloc->num_free--;
+  } else if (joins_prev) {
+    alloc->free[lo - 1].size += size;
+  } else if (joins_next) {
+    alloc->free[lo].offset = offset;
+    alloc->free[lo].size += size;
+  } else {
+    // If this fails the range is leaked until the next reset
+    if (!suballoc_reserve(alloc)) { return; }
+    memmove(&alloc->free[lo + 1],
+        &alloc->free[lo],
+        sizeof(SubRange) * (alloc->num_free - lo));
+    alloc->free[lo] = (SubRange){.offset = offset, .size = size};
+    alloc->num_free++;
+  }
+  alloc->used -= size;
+}
+
+bool suballoc_reset(SubAllocator *alloc, size_t used, size_t capacity) {
+  if (!alloc || used > capacity) { return false; }
+  alloc->capacity = capacity;
+  alloc->used     = used;
+  alloc->num_free = 0;
+  if (used == capacity) { return true; }
+  if (!suballoc_reserve(alloc)) { return false; }
+  alloc->free[0]  = (SubRange){.offset = used, .size = capacity - used};
+  alloc->num_free = 1;
+  return true;
+}
+
+SubAllocStats suballoc_stats(const SubAllocator *alloc) {
+  SubAllocStats stats = {0};
+  if (!alloc) { return stats; }
+  stats.capacity = alloc->capacity;
+  stats.used     = alloc->used;
+  stats.free     = alloc->capacity - alloc->used;
+  stats.num_free = alloc->num_free;
+  for (size_t i = 0; i < alloc->num_free; i++) {
+    if (alloc->free[i].size > stats.largest_free) {
+      stats.largest_free = alloc->free[i].size;
+    }
+  }
+  if (stats.free > 0) {
+    stats.fragmentation = 1.f - (float)stats.largest_free / stats.free;
+  }
+  return stats;
+}
@@ -0,0 +1,51 @@
+#ifndef SUBALLOC_H
+
+#define SUBALLOC_H
+
+// Includes
+#include <stdbool.h>
+#include <stddef.h>
+
+// Structs
+// A range of units inside an allocator
+typedef struct {
+  size_t offset;
+  size_t size;
+} SubRange;
+
+// Hands out ranges of a fixed size space (e.g. vertices in a GPU buffer).
+// Doesn't own any memory itself, only tracks which ranges are free
+typedef struct {
+  size_t capacity; // Total units
+  size_t used;     // Units in live allocations
+  SubRange *free;  // Free ranges sorted by offset, never touching
+  size_t free_alloced;
+  size_t num_free;
+} SubAllocator;
+
+typedef struct {
+  size_t capacity;
+  size_t used;
+  size_t free;         // capacity - used
+  size_t largest_free; // Biggest allocation that would currently succeed
+  size_t num_free;     // Number of free ranges
+  // 1 - largest_free / free, 0 when all free space is in one range
+  float fragmentation;
+} SubAllocStats;
+
+// Function prototypes
+// Set up an allocator with every unit free, returns false if allocation failed
+bool suballoc_init(SubAllocator *alloc, size_t capacity);
+// Free the allocator's own storage
+void suballoc_free(SubAllocator *alloc);
+// Allocate size units from the smallest free range that fits. Returns false
+// if no free range is big enough
+bool suballoc_alloc(SubAllocator *alloc, size_t size, size_t *offset);
+// Return a range, merging it with any free ranges it touches
+void suballoc_release(SubAllocator *alloc, size_t offset, size_t size);
+// Reset to a single used range [0, used) followed by free space up to
+// capacity, e.g. after the owner has packed every allocation to the front
+bool suballoc_reset(SubAllocator *alloc, size_t used, size_t capacity);
+SubAllocStats suballoc_stats(const SubAllocator *alloc);
+
+#endif // suballoc.h
@@ -0,0 +1,205 @@
+#include "biome.h"
+
+#include "noise.h"
+#include <pthread.h>
+#include <stdbool.h>
+
+#define BIOME_CORNERS (BIOME_REGION_CELLS + 1) // Grid corners per region side
+#define BIOME_BLEND_RADIUS 3 // Corners averaged either side when blending
+#define BIOME_PADDED (BIOME_CORNERS + BIOME_BLEND_RADIUS * 2)
+#define BIOME_CACHE_SIZE 256 // Regions kept in the cache
+
+static const BiomeInfo biome_infos[NUM_BIOMES] = {
+    [BIOME_PLAINS]    = {50.f, 15.f, BlockGrass, BlockDirt, 0.05f},
+    [BIOME_DESERT]    = {45.f, 10.f, BlockSand, BlockSand, 0.f},
+    [BIOME_FOREST]    = {55.f, 25.f, BlockGrass, BlockDirt, 0.6f},
+    [BIOME_MOUNTAINS] = {75.f, 60.f, BlockStone, BlockStone, 0.f},
+};
+
+// The climate grid of one chunk column
+typedef struct {
+  bool valid;
+  int rx, rz;
+  uint32_t seed;
+  float base[BIOME_CORNERS * BIOME_CORNERS];  // Blended base height per corner
+  float scale[BIOME_CORNERS * BIOME_CORNERS]; // Blended height scale per corner
+  BiomeType biomes[BIOME_REGION_CELLS * BIOME_REGION_CELLS]; // Biome per cell
+} BiomeRegion;
+
+static BiomeRegion biome_cache[BIOME_CACHE_SIZE];
+static pthread_mutex_t biome_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline float lerp(float a, float b, float t) { return a + (b - a) * t; }
+
+const BiomeInfo *biome_info(BiomeType biome) {
+  if (biome >= NUM_BIOMES) { return &biome_infos[BIOME_PLAINS]; }
+  return &biome_infos[biome];
+}
+
+// Pick a biome from temperature and humidity
+static BiomeType biome_from_climate(float temperature, float humidity) {
+  if (temperature > 0.25f && humidity < 0.f) { return BIOME_DESERT; }
+  if (temperature < -0.3f) { return BIOME_MOUNTAINS; }
+  if (humidity > 0.15f) { return BIOME_FOREST; }
+  return BIOME_PLAINS;
+}
+
+// Sample the climate at every corner of a region (plus a border for
+// blending), then box blur the height parameters so biome borders are smooth.
+// Returns false if the noise couldn't be sampled
+static bool biome_build_region(
+    BiomeRegion *region, int rx, int rz, uint32_t seed) {
+  float temperature[BIOME_PADDED * BIOME_PADDED];
+  float humidity[BIOME_PADDED * BIOME_PADDED];
+  BiomeType corners[BIOME_PADDED * BIOME_PADDED];
+  int origin_x = rx * CHUNK_WIDTH - BIOME_BLEND_RADIUS * BIOME_CELL_SIZE;
+  int origin_z = rz * CHUNK_LENGTH - BIOME_BLEND_RADIUS * BIOME_CELL_SIZE;
+  region->valid       = false;
+  bool temperature_ok = octave_noise_2d_grid(temperature,
+      origin_x,
+      origin_z,
+      BIOME_PADDED,
+      BIOME_PADDED,
+      BIOME_CELL_SIZE,
+      2,
+      0.5f,
+      2.f,
+      512,
+      seed + 20);
+  bool humidity_ok = octave_noise_2d_grid(humidity,
+      origin_x,
+      origin_z,
+      BIOME_PADDED,
+      BIOME_PADDED,
+      BIOME_CELL_SIZE,
+      2,
+      0.5f,
+      2.f,
+      512,
+      seed + 30);
+  if (!temperature_ok || !humidity_ok) { return false; }
+  for (int i = 0; i < BIOME_PADDED * BIOME_PADDED; i++) {
+    corners[i] = biome_from_climate(temperature[i], humidity[i]);
+  }
+
+  const int kernel = (BIOME_BLEND_RADIUS * 2 + 1) * (BIOME_BLEND_RADIUS * 2 + 1);
+  for (int i = 0; i < BIOME_CORNERS; i++) {
+    for (int j = 0; j < BIOME_CORNERS; j++) {
+      float base = 0.f, scale = 0.f;
+      for (int di = 0; di <= BIOME_BLEND_RADIUS * 2; di++) {
+        for (int dj = 0; dj <= BIOME_BLEND_RADIUS * 2; dj++) {
+          const BiomeInfo *info = biome_info(
+              corners[(i + di) * BIOME_PADDED + j + dj]);
+          base += info->base_height;
+          scale += info->height_scale;
+        }
+      }
+      region->base[i * BIOME_CORNERS + j]  = base / kernel;
+      region->scale[i * BIOME_CORNERS + j] = scale / kernel;
+    }
+  }
+
+  for (int i = 0; i < BIOME_REGION_CELLS; i++) {
+    for (int j = 0; j < BIOME_REGION_CELLS; j++) {
+      int ci = i + BIOME_BLEND_RADIUS;
+      int cj = j + BIOME_BLEND_RADIUS;
+      region->biomes[i * BIOME_REGION_CELLS + j] =
+          corners[ci * BIOME_PADDED + cj];
+    }
+  }
+
+  region->rx    = rx;
+  region->rz    = rz;
+  region->seed  = seed;
+  region->valid = true;
+  return true;
+}
+
+// Copy a region out of the cache, building it if it isn't there. Returns false
+// if it couldn't be built, failed builds aren't cached
+static bool biome_get_region(int rx, int rz, uint32_t seed, BiomeRegion *out) {
+  uint32_t slot = noise_hash_2d(rx, rz, 0) % BIOME_CACHE_SIZE;
+  pthread_mutex_lock(&biome_cache_mutex);
+  BiomeRegion *cached = &biome_cache[slot];
+  if (cached->valid && cached->rx == rx && cached->rz == rz
+      && cached->seed == seed) {
+    *out = *cached;
+    pthread_mutex_unlock(&biome_cache_mutex);
+    return true;
+  }
+  pthread_mutex_unlock(&biome_cache_mutex);
+
+  // Build outside the lock, other threads can keep using the cache
+  if (!biome_build_region(out, rx, rz, seed)) { return false; }
+
+  pthread_mutex_lock(&biome_cache_mutex);
+  biome_cache[slot] = *out;
+  pthread_mutex_unlock(&biome_cache_mutex);
+  return true;
+}
+
+// Interpolate a region's corner parameters for one column of its chunk
+// column, x and z are block offsets into the chunk column
+static void biome_region_column(const BiomeRegion *region, int x, int z,
+    float *base, float *scale, BiomeType *biome) {
+  int i    = x / BIOME_CELL_SIZE;
+  float tx = (float)(x % BIOME_CELL_SIZE) / BIOME_CELL_SIZE;
+  int j    = z / BIOME_CELL_SIZE;
+  float tz = (float)(z % BIOME_CELL_SIZE) / BIOME_CELL_SIZE;
+
+  int c00  = i * BIOME_CORNERS + j;
+  int c10  = c00 + BIOME_CORNERS;
+  float b0 = lerp(region->base[c00], region->base[c10], tx);
+  float b1 = lerp(region->base[c00 + 1], region->base[c10 + 1], tx);
+  float s0 = lerp(region->scale[c00], region->scale[c10], tx);
+  float s1 = lerp(region->scale[c00 + 1], region->scale[c10 + 1], tx);
+
+  *base  = lerp(b0, b1, tz);
+  *scale = lerp(s0, s1, tz);
+  *biome = region->biomes[i * BIOME_REGION_CELLS + j];
+}
+
+bool biome_fill_columns(int chunk_x, int chunk_z, uint32_t seed, float *base,
+    float *scale, BiomeType *biomes) {
+  BiomeRegion region;
+  if (!biome_get_region(chunk_x, chunk_z, seed, &region)) { return false; }
+
+  // Bilinearly interpolate the corner parameters for every column
+  for (int x = 0; x < CHUNK_WIDTH; x++) {
+    for (int z = 0; z < CHUNK_LENGTH; z++) {
+      size_t idx = CHUNK_INDEX(x, 0, z);
+      biome_region_column(
+          &region, x, z, &base[idx], &scale[idx], &biomes[idx]);
+    }
+  }
+  return true;
+}
+
+static inline int floor_div(int a, int b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+bool biome_fill_grid(int x0, int z0, size_t width, size_t length, int step,
+    uint32_t seed, float *base, float *scale, BiomeType *biomes) {
+  BiomeRegion region = {0};
+  for (size_t i = 0; i < width; i++) {
+    int x  = x0 + (int)i * step;
+    int rx = floor_div(x, CHUNK_WIDTH);
+    for (size_t j = 0; j < length; j++) {
+      int z  = z0 + (int)j * step;
+      int rz = floor_div(z, CHUNK_LENGTH);
+      // Neighbouring samples usually share a region, so only fetch on change
+      if (!region.valid || region.rx != rx || region.rz != rz) {
+        if (!biome_get_region(rx, rz, seed, &region)) { return false; }
+      }
+      size_t idx = i * length + j;
+      biome_region_column(&region,
+          x - rx * CHUNK_WIDTH,
+          z - rz * CHUNK_LENGTH,
+          &base[idx],
+          &scale[idx],
+          &biomes[idx]);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,46 @@
+#ifndef BIOME_H
+#define BIOME_H
+
+// Includes
+#include "block.h"
+#include "chunk.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Biomes are picked on a coarse grid, one per BIOME_CELL_SIZE^2 columns
+#define BIOME_CELL_SIZE 4
+#define BIOME_REGION_CELLS (CHUNK_WIDTH / BIOME_CELL_SIZE)
+
+// Structs
+typedef enum {
+  BIOME_PLAINS,
+  BIOME_DESERT,
+  BIOME_FOREST,
+  BIOME_MOUNTAINS,
+  NUM_BIOMES
+} BiomeType;
+
+typedef struct {
+  float base_height;    // Average surface height
+  float height_scale;   // How far the surface strays from base_height
+  BlockType top_block;  // Block on the surface
+  BlockType fill_block; // Block in the few layers under the surface
+  float tree_chance;    // Chance that a tree cell grows a tree
+} BiomeInfo;
+
+// Function prototypes
+// Get the parameters of a biome
+const BiomeInfo *biome_info(BiomeType biome);
+// Fill per-column biome data for the chunk column at (chunk_x, chunk_z).
+// base, scale and biomes are CHUNK_AREA arrays indexed by CHUNK_INDEX(x, 0, z).
+// Height parameters are blended across biome borders, the climate grid behind
+// them is cached per chunk column. Returns false if allocation failed
+bool biome_fill_columns(int chunk_x, int chunk_z, uint32_t seed, float *base,
+    float *scale, BiomeType *biomes);
+// Fill the same per-column data for a width by length grid of columns, step
+// blocks apart from (x0, z0). Arrays are indexed [i * length + j], like
+// octave_noise_2d_grid(). Returns false if allocation failed
+bool biome_fill_grid(int x0, int z0, size_t width, size_t length, int step,
+    uint32_t seed, float *base, float *scale, BiomeType *biomes);
+
+#endif // biome.h
@@ -2,7 +2,7 @@
 
 #define BLOCK_h
 
-#define NUM_BLOCKS 6
+#define NUM_BLOCKS 7
 
 #define NUM_BLOCK_TEXTURES (NUM_BLOCKS * 3)
 
@@ -15,7 +15,8 @@
       "textures/Sand-bottom.png", "textures/Log-top.png",                        \
       "textures/Log-side.png", "textures/Log-bottom.png",                        \
       "textures/DiamondOre-top.png", "textures/DiamondOre-side.png",             \
-      "textures/DiamondOre-bottom.png"
+      "textures/DiamondOre-bottom.png", "textures/Leaves-top.png",               \
+      "textures/Leaves-side.png", "textures/Leaves-bottom.png"
 
 #include <stdint.h>
 
@@ -29,6 +30,7 @@ enum {
   BlockSand,
   BlockLog,
   BlockDiamondOre,
+  BlockLeaves,
 
 };
 
@@ -1,35 +1,14 @@
 #include "chunk.h"
 
+#include "biome.h"
+#include "decoration.h"
 #include "noise.h"
+#include "ore.h"
 #include "profiler.h"
+#include "visibility.h"
 
-typedef struct {
-  GLfloat pos[3];
-  GLfloat tex[2];
-  GLint side_index;
-  GLint block_type;
-} Vertex;
-
-// 32 * 7 = 224 bytes per vertex
-// thats kinda crazy
-// Could send uniform chunk pos and use only 1 byte for each block offset
-// 3 bytes pos
-// Texcoords could be only one bit (only 0 or 1)
-// 2 bits tex
-// Side index only needs up to 6, so 3 bits
-// 3 bits side index
-// Block type depends how many blocks there are, so could use a byte
-// one byte side index
-// So 4.625 bytes per vertex
-// Or 37 bits per vertex
-// Probably needs to be padded up to 5 bytes
-// Can only pass as low as 4 bytes tho, so 8 bytes
-
-size_t vertex_num     = 4;
-size_t vertex_sizes[] = {
-    sizeof(GLfloat), sizeof(GLfloat), sizeof(GLint), sizeof(GLint)};
-size_t vertex_counts[] = {3, 2, 1, 1};
-GLenum vertex_types[]  = {GL_FLOAT, GL_FLOAT, GL_INT, GL_INT};
+#include <math.h>
+#include <string.h>
 
 Chunk *create_chunk(int chunk_x, int chunk_y, int chunk_z) {
   Chunk *chunk = calloc(1, sizeof(Chunk));
@@ -42,13 +21,14 @@ Chunk *create_chunk(int chunk_x, int chunk_y, int chunk_z) {
         chunk_z);
     return NULL;
   }
-  chunk->coords[0] = chunk_x;
-  chunk->coords[1] = chunk_y;
-  chunk->coords[2] = chunk_z;
-  chunk->blocks    = NULL;
-  chunk->mesh      = nu_create_mesh(
-      vertex_num, vertex_sizes, vertex_counts, vertex_types);
-  chunk->state = STATE_EMPTY;
+  chunk->coords[0]  = chunk_x;
+  chunk->coords[1]  = chunk_y;
+  chunk->coords[2]  = chunk_z;
+  chunk->blocks     = NULL;
+  chunk->state      = STATE_EMPTY;
+  chunk->gen_stage  = GEN_STAGE_NONE;
+  chunk->visibility = VISIBILITY_ALL;
+  chunk->lod        = 0;
   pthread_mutex_init(&chunk->chunk_mutex, NULL);
   return chunk;
 }
@@ -66,26 +46,277 @@ void unlock_chunk(Chunk *chunk) {
 void destroy_chunk(Chunk **chunk) {
   if (!chunk || !(*chunk)) { return; }
   lock_chunk(*chunk);
-  if ((*chunk)->mesh) { nu_destroy_mesh(&(*chunk)->mesh); }
   if ((*chunk)->blocks) {
     free((*chunk)->blocks);
     (*chunk)->blocks = NULL;
   }
+  if ((*chunk)->vertices) {
+    free((*chunk)->vertices);
+    (*chunk)->vertices = NULL;
+  }
   unlock_chunk(*chunk);
   pthread_mutex_destroy(&(*chunk)->chunk_mutex);
+  free(*chunk);
   *chunk = NULL;
 }
 
+// Check if the brick holding a block has anything but air in it, a row of
+// the brick at a time
+static bool chunk_brick_solid(
+    const Chunk *chunk, size_t x, size_t y, size_t z) {
+  size_t x0     = x & ~(size_t)(CHUNK_BRICK - 1);
+  size_t y0     = y & ~(size_t)(CHUNK_BRICK - 1);
+  size_t z0     = z & ~(size_t)(CHUNK_BRICK - 1);
+  uint32_t mask = ((1u << CHUNK_BRICK) - 1) << z0;
+  for (size_t by = y0; by < y0 + CHUNK_BRICK; by++) {
+    for (size_t bx = x0; bx < x0 + CHUNK_BRICK; bx++) {
+      if (chunk_solid_row(chunk, bx, by) & mask) { return true; }
+    }
+  }
+  return false;
+}
+
 bool chunk_set_block(
     Chunk *chunk, BlockType block, size_t x, size_t y, size_t z) {
   if (!chunk || x >= CHUNK_WIDTH || y >= CHUNK_HEIGHT || z >= CHUNK_LENGTH) {
     return false;
   }
   if (!chunk->blocks || chunk->state == STATE_EMPTY) { return false; }
-  chunk->blocks[CHUNK_INDEX(x, y, z)] = (Block){.type = block};
+  Block *target = &chunk->blocks[CHUNK_INDEX(x, y, z)];
+  chunk_count_block(chunk, target->type, block, x, y, z);
+  *target = (Block){.type = block};
+  if (block != BlockAir) {
+    chunk->occupancy[CHUNK_ROW(x, y)] |= 1u << z;
+    chunk->solid_bricks |= CHUNK_BRICK_BIT(x, y, z);
+  } else {
+    chunk->occupancy[CHUNK_ROW(x, y)] &= ~(1u << z);
+    if (!chunk_brick_solid(chunk, x, y, z)) {
+      chunk->solid_bricks &= ~CHUNK_BRICK_BIT(x, y, z);
+    }
+  }
   return true;
 }
 
+_Static_assert(sizeof(Block) == 1 && CHUNK_BRICK == 8,
+    "a brick wide run of blocks must fit in a 64 bit word");
+
+void chunk_update_occupancy(Chunk *chunk) {
+  if (!chunk) { return; }
+  memset(chunk->occupancy, 0, sizeof(chunk->occupancy));
+  chunk->solid_bricks = 0;
+  memset(chunk->type_counts, 0, sizeof(chunk->type_counts));
+  memset(chunk->type_bricks, 0, sizeof(chunk->type_bricks));
+  if (!chunk->blocks) { return; }
+  // Rows are walked a brick wide run at a time. Most runs are one type, and
+  // those are counted with one compare
+  for (size_t y = 0; y < CHUNK_HEIGHT; y++) {
+    for (size_t x = 0; x < CHUNK_WIDTH; x++) {
+      const Block *row = &chunk->blocks[CHUNK_INDEX(x, y, 0)];
+      uint32_t bits    = 0;
+      for (size_t z0 = 0; z0 < CHUNK_LENGTH; z0 += CHUNK_BRICK) {
+        uint64_t brick = CHUNK_BRICK_BIT(x, y, z0);
+        uint64_t run;
+        memcpy(&run, &row[z0], sizeof(run));
+        BlockType first = row[z0].type;
+        if (run == first * 0x0101010101010101ull) {
+          if (first != BlockAir) { bits |= 0xffu << z0; }
+          if (first >= CHUNK_BLOCK_TYPES) {
+            chunk->solid_bricks |= brick;
+            continue;
+          }
+          chunk->type_counts[first] += CHUNK_BRICK;
+          chunk->type_bricks[first] |= brick;
+          continue;
+        }
+        for (size_t z = z0; z < z0 + CHUNK_BRICK; z++) {
+          BlockType type = row[z].type;
+          bits |= (uint32_t)(type != BlockAir) << z;
+          if (type >= CHUNK_BLOCK_TYPES) {
+            chunk->solid_bricks |= brick;
+            continue;
+          }
+          chunk->type_counts[type]++;
+          chunk->type_bricks[type] |= brick;
+        }
+      }
+      chunk->occupancy[CHUNK_ROW(x, y)] = bits;
+    }
+  }
+  // Freshly built brick bits are exact, so a brick is solid if any type but
+  // air is in it. Unknown types were marked solid above
+  for (size_t type = BlockAir + 1; type < CHUNK_BLOCK_TYPES; type++) {
+    chunk->solid_bricks |= chunk->type_bricks[type];
+  }
+}
+
+// Rebuild the solid_bricks bits of every brick overlapping an inclusive box
+// of local coords from the occupancy bits
+static void chunk_update_box_bricks(
+    Chunk *chunk, const int lo[3], const int hi[3]) {
+  int start[3];
+  for (int i = 0; i < 3; i++) { start[i] = lo[i] & ~(CHUNK_BRICK - 1); }
+  for (int y = start[1]; y <= hi[1]; y += CHUNK_BRICK) {
+    for (int x = start[0]; x <= hi[0]; x += CHUNK_BRICK) {
+      for (int z = start[2]; z <= hi[2]; z += CHUNK_BRICK) {
+        if (chunk_brick_solid(chunk, x, y, z)) {
+          chunk->solid_bricks |= CHUNK_BRICK_BIT(x, y, z);
+        } else {
+          chunk->solid_bricks &= ~CHUNK_BRICK_BIT(x, y, z);
+        }
+      }
+    }
+  }
+}
+
+// Write a type to the blocks in a box, or only to the blocks of type from if
+// match is set. Returns the number of blocks that changed
+static size_t chunk_write_box(Chunk *chunk, BlockType block, bool match,
+    BlockType from, const int lo[3], const int hi[3]) {
+  if (!chunk || !chunk->blocks || chunk->state == STATE_EMPTY) { return 0; }
+  int box_lo[3], box_hi[3];
+  for (int i = 0; i < 3; i++) {
+    box_lo[i] = lo[i] < 0 ? 0 : lo[i];
+    box_hi[i] = hi[i] > CHUNK_MASK ? CHUNK_MASK : hi[i];
+    if (box_lo[i] > box_hi[i]) { return 0; }
+  }
+
+  size_t changed = 0;
+  for (int y = box_lo[1]; y <= box_hi[1]; y++) {
+    for (int x = box_lo[0]; x <= box_hi[0]; x++) {
+      Block *row    = &chunk->blocks[CHUNK_INDEX(x, y, 0)];
+      uint32_t bits = 0; // Blocks in the row that were written
+      for (int z = box_lo[2]; z <= box_hi[2]; z++) {
+        if (match && row[z].type != from) { continue; }
+        bits |= 1u << z;
+        if (row[z].type == block) { continue; }
+        chunk_count_block(chunk, row[z].type, block, x, y, z);
+        row[z].type = block;
+        changed++;
+      }
+      if (block != BlockAir) {
+        chunk->occupancy[CHUNK_ROW(x, y)] |= bits;
+      } else {
+        chunk->occupancy[CHUNK_ROW(x, y)] &= ~bits;
+      }
+    }
+  }
+  if (changed > 0) { chunk_update_box_bricks(chunk, box_lo, box_hi); }
+  return changed;
+}
+
+size_t chunk_fill_box(
+    Chunk *chunk, BlockType block, const int lo[3], const int hi[3]) {
+  return chunk_write_box(chunk, block, false, BlockAir, lo, hi);
+}
+
+size_t chunk_replace_box(Chunk *chunk, BlockType from, BlockType to,
+    const int lo[3], const int hi[3]) {
+  if (from == to) { return 0; }
+  return chunk_write_box(chunk, to, true, from, lo, hi);
+}
+
+size_t chunk_apply_edits(Chunk *chunk, const BlockEdit *edits, size_t n) {
+  if (!chunk || !chunk->blocks || chunk->state == STATE_EMPTY || !edits) {
+    return 0;
+  }
+  int ccx          = chunk->coords[0] * CHUNK_WIDTH;
+  int ccy          = chunk->coords[1] * CHUNK_HEIGHT;
+  int ccz          = chunk->coords[2] * CHUNK_LENGTH;
+  size_t changed   = 0;
+  uint64_t emptied = 0; // Bricks that had a block set to air
+  for (size_t i = 0; i < n; i++) {
+    unsigned x = (unsigned)(edits[i].x - ccx);
+    unsigned y = (unsigned)(edits[i].y - ccy);
+    unsigned z = (unsigned)(edits[i].z - ccz);
+    if (x >= CHUNK_WIDTH || y >= CHUNK_HEIGHT || z >= CHUNK_LENGTH) {
+      continue;
+    }
+    Block *block = &chunk->blocks[CHUNK_INDEX(x, y, z)];
+    if (block->type == edits[i].type) { continue; }
+    chunk_count_block(chunk, block->type, edits[i].type, x, y, z);
+    block->type = edits[i].type;
+    changed++;
+    if (block->type != BlockAir) {
+      chunk->occupancy[CHUNK_ROW(x, y)] |= 1u << z;
+      chunk->solid_bricks |= CHUNK_BRICK_BIT(x, y, z);
+    } else {
+      chunk->occupancy[CHUNK_ROW(x, y)] &= ~(1u << z);
+      emptied |= CHUNK_BRICK_BIT(x, y, z);
+    }
+  }
+
+  // Only bricks that lost blocks can have become empty
+  for (int i = 0; emptied; i++, emptied >>= 1) {
+    if (!(emptied & 1)) { continue; }
+    int x = (i / CHUNK_BRICKS % CHUNK_BRICKS) * CHUNK_BRICK;
+    int y = (i / (CHUNK_BRICKS * CHUNK_BRICKS)) * CHUNK_BRICK;
+    int z = (i % CHUNK_BRICKS) * CHUNK_BRICK;
+    if (!chunk_brick_solid(chunk, x, y, z)) {
+      chunk->solid_bricks &= ~CHUNK_BRICK_BIT(x, y, z);
+    }
+  }
+  return changed;
+}
+
+size_t chunk_carve_capsule(
+    Chunk *chunk, const float a[3], const float b[3], float radius) {
+  if (!chunk || !chunk->blocks || chunk->state == STATE_EMPTY || !a || !b) {
+    return 0;
+  }
+  if (!(radius > 0.0f)) { return 0; }
+  // Work relative to a, in the chunk's local coords, and only visit the
+  // blocks whose centres are inside the capsule's bounding box
+  const int size[3] = {CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_LENGTH};
+  float start[3], ab[3];
+  int lo[3], hi[3];
+  for (int i = 0; i < 3; i++) {
+    float base = (float)(chunk->coords[i] * size[i]);
+    start[i]   = a[i] - base;
+    ab[i]      = b[i] - a[i];
+    float min  = ceilf(fminf(a[i], b[i]) - base - radius - 0.5f);
+    float max  = floorf(fmaxf(a[i], b[i]) - base + radius - 0.5f);
+    if (min > CHUNK_MASK || max < 0.0f) { return 0; }
+    lo[i] = min < 0.0f ? 0 : (int)min;
+    hi[i] = max > CHUNK_MASK ? CHUNK_MASK : (int)max;
+  }
+  float length2 = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+  float inv     = length2 > 0.0f ? 1.0f / length2 : 0.0f;
+  float r2      = radius * radius;
+
+  size_t changed = 0;
+  for (int y = lo[1]; y <= hi[1]; y++) {
+    for (int x = lo[0]; x <= hi[0]; x++) {
+      uint32_t *row = &chunk->occupancy[CHUNK_ROW(x, y)];
+      if (!*row) { continue; }
+      float px   = (float)x + 0.5f - start[0];
+      float py   = (float)y + 0.5f - start[1];
+      float proj = px * ab[0] + py * ab[1]; // Part of p.ab that z doesn't move
+      uint32_t mask = 0; // Blocks in the row inside the capsule
+      for (int z = lo[2]; z <= hi[2]; z++) {
+        float pz = (float)z + 0.5f - start[2];
+        float t  = (proj + pz * ab[2]) * inv;
+        t        = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        float dx = px - t * ab[0];
+        float dy = py - t * ab[1];
+        float dz = pz - t * ab[2];
+        if (dx * dx + dy * dy + dz * dz <= r2) { mask |= 1u << z; }
+      }
+      mask &= *row;
+      if (!mask) { continue; }
+      *row &= ~mask;
+      Block *blocks = &chunk->blocks[CHUNK_INDEX(x, y, 0)];
+      for (uint32_t bits = mask; bits; bits &= bits - 1) {
+        int z = __builtin_ctz(bits);
+        chunk_count_block(chunk, blocks[z].type, BlockAir, x, y, z);
+        blocks[z].type = BlockAir;
+        changed++;
+      }
+    }
+  }
+  if (changed > 0) { chunk_update_box_bricks(chunk, lo, hi); }
+  return changed;
+}
+
 Block *chunk_get_block(Chunk *chunk, size_t x, size_t y, size_t z) {
   if (!chunk || x >= CHUNK_WIDTH || y >= CHUNK_HEIGHT || z >= CHUNK_LENGTH) {
     return NULL;
@@ -94,71 +325,203 @@ Block *chunk_get_block(Chunk *chunk, size_t x, size_t y, size_t z) {
   return &chunk->blocks[CHUNK_INDEX(x, y, z)];
 }
 
-void generate_chunk(Chunk *chunk, uint32_t seed) {
-  if (!chunk) { return; }
-  ChunkState state = chunk->state;
-  if (state != STATE_EMPTY) { return; }
-  if (chunk->blocks) { free(chunk->blocks); }
-  chunk->blocks = calloc(CHUNK_VOLUME, sizeof(Block));
-  if (!chunk->blocks) {
-    fprintf(stderr,
-        "(generate_chunk): Couldn't generate chunk at coords (%d, %d, %d), "
-        "calloc failed.\n",
-        chunk->coords[0],
-        chunk->coords[1],
-        chunk->coords[2]);
-    return;
+bool edit_list_push(EditList *list, BlockEdit edit) {
+  if (!list) { return false; }
+  // If list is too small, double size
+  if (list->num_edits >= list->edits_alloced) {
+    size_t new_alloced = list->edits_alloced ? list->edits_alloced * 2 : 64;
+    BlockEdit *new_edits = realloc(list->edits, sizeof(BlockEdit) * new_alloced);
+    if (!new_edits) { return false; }
+    list->edits         = new_edits;
+    list->edits_alloced = new_alloced;
   }
+  list->edits[list->num_edits++] = edit;
+  return true;
+}
 
-  float heightmap[CHUNK_AREA];
-  float sandmap[CHUNK_AREA];
+void edit_list_free(EditList *list) {
+  if (!list) { return; }
+  if (list->edits) { free(list->edits); }
+  list->edits         = NULL;
+  list->edits_alloced = 0;
+  list->num_edits     = 0;
+}
 
+// Noise behind the surface heightmap
+#define HEIGHT_OCTAVES 5
+#define HEIGHT_PERSISTENCE 0.3f
+#define HEIGHT_LACUNARITY 1.7f
+#define HEIGHT_BASE_RES 256
+
+// Per-column data shared between generation passes
+typedef struct {
+  float heightmap[CHUNK_AREA];
+  float base[CHUNK_AREA];
+  float scale[CHUNK_AREA];
+  BiomeType biomes[CHUNK_AREA];
+} GenContext;
+
+// Sample the biome and noise maps every pass reads from, returns false if
+// allocation failed
+static bool gen_fill_context(Chunk *chunk, uint32_t seed, GenContext *ctx) {
   int ccx = chunk->coords[0] * CHUNK_WIDTH;
-  int ccy = chunk->coords[1] * CHUNK_HEIGHT;
   int ccz = chunk->coords[2] * CHUNK_LENGTH;
 
+  // Biome height parameters come from a coarse cached grid, so this is the
+  // only noise that is evaluated per column
+  if (!biome_fill_columns(chunk->coords[0],
+          chunk->coords[2],
+          seed,
+          ctx->base,
+          ctx->scale,
+          ctx->biomes)) {
+    return false;
+  }
+
+  // The heightmap is laid out like CHUNK_INDEX(x, 0, z), so the noise grid
+  // can be written straight into it
+  bool sampled = octave_noise_2d_grid(ctx->heightmap,
+      ccx,
+      ccz,
+      CHUNK_WIDTH,
+      CHUNK_LENGTH,
+      1,
+      HEIGHT_OCTAVES,
+      HEIGHT_PERSISTENCE,
+      HEIGHT_LACUNARITY,
+      HEIGHT_BASE_RES,
+      seed);
+  if (!sampled) { return false; }
+  for (size_t i = 0; i < CHUNK_AREA; i++) {
+    ctx->heightmap[i] = ctx->base[i] + ctx->heightmap[i] * ctx->scale[i];
+  }
+  return true;
+}
+
+bool terrain_surface_grid(int x0, int z0, size_t width, size_t length,
+    int step, uint32_t seed, float *heights, BlockType *tops) {
+  if (!heights || !tops) { return false; }
+  size_t count      = width * length;
+  float *base       = malloc(sizeof(float) * count);
+  float *scale      = malloc(sizeof(float) * count);
+  BiomeType *biomes = malloc(sizeof(BiomeType) * count);
+  bool success      = base && scale && biomes;
+  if (success) {
+    success = biome_fill_grid(
+        x0, z0, width, length, step, seed, base, scale, biomes);
+  }
+  if (success) {
+    success = octave_noise_2d_grid(heights,
+        x0,
+        z0,
+        width,
+        length,
+        step,
+        HEIGHT_OCTAVES,
+        HEIGHT_PERSISTENCE,
+        HEIGHT_LACUNARITY,
+        HEIGHT_BASE_RES,
+        seed);
+  }
+  if (success) {
+    for (size_t i = 0; i < count; i++) {
+      heights[i] = base[i] + heights[i] * scale[i];
+      tops[i]    = biome_info(biomes[i])->top_block;
+    }
+  }
+  if (base) { free(base); }
+  if (scale) { free(scale); }
+  if (biomes) { free(biomes); }
+  return success;
+}
+
+// Pass 1: fill everything under the heightmap with stone
+static void gen_terrain_pass(Chunk *chunk, const GenContext *ctx) {
+  int ccy = chunk->coords[1] * CHUNK_HEIGHT;
   for (size_t x = 0; x < CHUNK_WIDTH; x++) {
-    int gx = ccx + x;
     for (size_t z = 0; z < CHUNK_LENGTH; z++) {
-      int gz           = ccz + z;
-      float height_val = octave_noise_2d(gx, gz, 5, 0.3, 1.7, 256, seed);
-      height_val       = height_val / 2.f + 0.5f;
-      height_val       = height_val * 100;
-      heightmap[CHUNK_INDEX(x, 0, z)] = height_val;
-      float sand_val = octave_noise_2d(gx, gz, 1, 1.f, 1.f, 128, seed + 10);
-      sandmap[CHUNK_INDEX(x, 0, z)] = sand_val;
+      float height_val = ctx->heightmap[CHUNK_INDEX(x, 0, z)];
+      if (ccy > height_val) { continue; }
+      for (size_t y = 0; y < CHUNK_HEIGHT; y++) {
+        int gy = ccy + y;
+        if (gy > height_val) { break; }
+        chunk->blocks[CHUNK_INDEX(x, y, z)] = (Block){.type = BlockStone};
+      }
     }
   }
+  chunk->gen_stage = GEN_STAGE_TERRAIN;
+}
 
+// Pass 2: replace the top layers of stone with the biome's surface blocks
+static void gen_surface_pass(Chunk *chunk, const GenContext *ctx) {
+  int ccy = chunk->coords[1] * CHUNK_HEIGHT;
   for (size_t x = 0; x < CHUNK_WIDTH; x++) {
     for (size_t z = 0; z < CHUNK_LENGTH; z++) {
-      float height_val = heightmap[CHUNK_INDEX(x, 0, z)];
-      float sand_val   = sandmap[CHUNK_INDEX(x, 0, z)];
+      float height_val      = ctx->heightmap[CHUNK_INDEX(x, 0, z)];
+      const BiomeInfo *info = biome_info(ctx->biomes[CHUNK_INDEX(x, 0, z)]);
       if (ccy > height_val) { continue; }
       for (size_t y = 0; y < CHUNK_HEIGHT; y++) {
-        int gy          = ccy + y;
-        BlockType block = BlockAir;
-        if (gy <= height_val) {
-          int dist_from_surface = height_val - gy;
-          if (dist_from_surface == 0) {
-            block = sand_val < 0 ? BlockSand : BlockGrass;
-          } else if (dist_from_surface <= 5) {
-            block = sand_val < 0 ? BlockSand : BlockDirt;
-          } else {
-            block = BlockStone;
-          }
+        int gy = ccy + y;
+        if (gy > height_val) { break; }
+        int dist_from_surface = height_val - gy;
+        BlockType block       = BlockStone;
+        if (dist_from_surface == 0) {
+          block = info->top_block;
+        } else if (dist_from_surface <= 5) {
+          block = info->fill_block;
+        } else {
+          continue;
         }
-        size_t idx         = CHUNK_INDEX(x, y, z);
-        chunk->blocks[idx] = (Block){.type = block};
+        chunk->blocks[CHUNK_INDEX(x, y, z)] = (Block){.type = block};
       }
     }
   }
+  chunk->gen_stage = GEN_STAGE_SURFACE;
+}
 
-  chunk->state = STATE_NEEDS_MESH;
+void generate_chunk(Chunk *chunk, uint32_t seed, EditList *spill) {
+  if (!chunk) { return; }
+  ChunkState state = chunk->state;
+  if (state != STATE_EMPTY) { return; }
+  if (chunk->blocks) { free(chunk->blocks); }
+  chunk->gen_stage = GEN_STAGE_NONE;
+  chunk->blocks    = calloc(CHUNK_VOLUME, sizeof(Block));
+  if (!chunk->blocks) {
+    fprintf(stderr,
+        "(generate_chunk): Couldn't generate chunk at coords (%d, %d, %d), "
+        "calloc failed.\n",
+        chunk->coords[0],
+        chunk->coords[1],
+        chunk->coords[2]);
+    return;
+  }
+
+  GenContext ctx;
+  if (!gen_fill_context(chunk, seed, &ctx)) {
+    fprintf(stderr,
+        "(generate_chunk): Couldn't generate chunk at coords (%d, %d, %d), "
+        "sampling noise failed.\n",
+        chunk->coords[0],
+        chunk->coords[1],
+        chunk->coords[2]);
+    free(chunk->blocks);
+    chunk->blocks = NULL;
+    return;
+  }
+
+  // Generation passes, each one only builds on the ones before it
+  gen_terrain_pass(chunk, &ctx);
+  gen_surface_pass(chunk, &ctx);
+  generate_ores(chunk, seed);
+  chunk->gen_stage = GEN_STAGE_ORES;
+  decorate_chunk(chunk, seed, ctx.heightmap, ctx.biomes, spill);
+  chunk->gen_stage = GEN_STAGE_DECORATED;
+  chunk_update_occupancy(chunk);
+
+  chunk_invalidate_mesh(chunk);
 }
 
 static const int axis_uv[3][2] = {{1, 2}, {0, 2}, {0, 1}};
-static const int dims[3]       = {CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_LENGTH};
 
 // Get the rendering type of a block
 // 0 = Not rendered
@@ -204,26 +567,88 @@ static inline void emit_face(Vertex *target, size_t *count, float p[4][3],
 #undef EMIT
 }
 
-// Greedy meshing
-void mesh_chunk(Chunk *chunk) {
-
-  if (!chunk) { return; }
-  if (!chunk->blocks) { return; }
+// Sort a mesh's quads by the way they face, so the renderer can skip every
+// quad facing away from the camera with one range per face. Counts the
+// vertices facing each way into face_vertices. Takes ownership of verts and
+// returns the grouped vertices, or verts as is with no faces counted if the
+// grouped copy can't be allocated
+static Vertex *mesh_group_faces(
+    Vertex *verts, size_t count, size_t face_vertices[NUM_FACES]) {
+  // Side index of each face, from the mesher's switch below
+  static const ChunkFace side_faces[6] = {
+      FACE_POS_Z, FACE_NEG_Z, FACE_NEG_X, FACE_POS_X, FACE_POS_Y, FACE_NEG_Y};
+
+  Vertex *grouped = malloc(sizeof(Vertex) * count);
+  if (!grouped) { return verts; }
+
+  // Quads are 6 vertices that share a side index
+  for (size_t i = 0; i < count; i += 6) {
+    face_vertices[side_faces[verts[i].side_index]] += 6;
+  }
+  size_t offsets[NUM_FACES];
+  size_t total = 0;
+  for (int f = 0; f < NUM_FACES; f++) {
+    offsets[f] = total;
+    total += face_vertices[f];
+  }
+  for (size_t i = 0; i < count; i += 6) {
+    size_t *offset = &offsets[side_faces[verts[i].side_index]];
+    memcpy(&grouped[*offset], &verts[i], sizeof(Vertex) * 6);
+    *offset += 6;
+  }
+  free(verts);
+  return grouped;
+}
 
-  ChunkState state = chunk->state;
-  if (state != STATE_NEEDS_MESH) { return; }
+// Index into an n^3 grid of cells, laid out like CHUNK_INDEX
+#define GRID_INDEX(x, y, z, n) ((z) + (x) * (n) + (y) * (n) * (n))
+
+// Downsample a chunk's blocks by 2^lod on each axis, into an n^3 grid with
+// n = CHUNK_WIDTH >> lod (chunks are cubes). A cell is solid if at least half
+// its blocks are, so thin features fade out without holes opening in the
+// ground, and takes the type of its highest solid block so the surface keeps
+// its grass and sand
+static void downsample_blocks(const Block *blocks, int lod, BlockType *cells) {
+  int f = 1 << lod;
+  int n = CHUNK_WIDTH >> lod;
+  for (int cy = 0; cy < n; cy++) {
+    for (int cx = 0; cx < n; cx++) {
+      for (int cz = 0; cz < n; cz++) {
+        int solid     = 0;
+        BlockType top = BlockAir;
+        for (int y = f - 1; y >= 0; y--) {
+          for (int x = 0; x < f; x++) {
+            for (int z = 0; z < f; z++) {
+              BlockType t =
+                  blocks[CHUNK_INDEX(cx * f + x, cy * f + y, cz * f + z)].type;
+              if (t == BlockAir) { continue; }
+              if (top == BlockAir) { top = t; }
+              solid++;
+            }
+          }
+        }
+        cells[GRID_INDEX(cx, cy, cz, n)] = solid * 2 >= f * f * f ? top
+                                                                  : BlockAir;
+      }
+    }
+  }
+}
 
-  // Allocate array of mesh vertices
-  size_t max_verts  = CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_LENGTH * 6;
-  Vertex *verts     = malloc(sizeof(Vertex) * max_verts);
-  // Vertex *tverts = malloc(sizeof(Vertex) * max_verts);
+// Greedily merge the faces of an n^3 grid of cells into quads, and return the
+// number of vertices written to verts. Each cell is scale blocks wide, and
+// corner is the global position of the grid's first block. Cells outside the
+// grid count as air, so a chunk's border always gets faces, which also hide
+// cracks against neighbours meshed at another level of detail
+static size_t mesh_grid(const BlockType *cells, int n, int scale,
+    const int corner[3], Vertex *verts) {
+  const int dims[3] = {n, n, n};
   size_t vert_count = 0;
   // size_t tvert_count = 0;
 
-  // Chunk global coordinates
-  int corner_x = chunk->coords[0] * CHUNK_WIDTH;
-  int corner_y = chunk->coords[1] * CHUNK_HEIGHT;
-  int corner_z = chunk->coords[2] * CHUNK_LENGTH;
+  // Grid global coordinates
+  int corner_x = corner[0];
+  int corner_y = corner[1];
+  int corner_z = corner[2];
 
   // For each axis, greedily merge block faces into quads
   for (int axis = 0; axis < 3; axis++) {
@@ -249,15 +674,13 @@ void mesh_chunk(Chunk *chunk) {
           // Get the current, and the next block in this axis
           BlockType blockA =
               (coords[axis] >= 0 && coords[axis] < dims[axis])
-                  ? chunk->blocks[CHUNK_INDEX(coords[0], coords[1], coords[2])]
-                        .type
+                  ? cells[GRID_INDEX(coords[0], coords[1], coords[2], n)]
                   : BlockAir;
 
           coords[axis] = slice + 1;
           BlockType blockB =
               (coords[axis] >= 0 && coords[axis] < dims[axis])
-                  ? chunk->blocks[CHUNK_INDEX(coords[0], coords[1], coords[2])]
-                        .type
+                  ? cells[GRID_INDEX(coords[0], coords[1], coords[2], n)]
                   : BlockAir;
 
           int ra = block_render_type(blockA);
@@ -321,45 +744,49 @@ void mesh_chunk(Chunk *chunk) {
 
           // Quad corners
           float p[4][3] = {
-              {base[0] + corner_x, base[1] + corner_y, base[2] + corner_z},
-              {base[0] + du[0] + corner_x,
-                  base[1] + du[1] + corner_y,
-                  base[2] + du[2] + corner_z},
-              {base[0] + dv[0] + corner_x,
-                  base[1] + dv[1] + corner_y,
-                  base[2] + dv[2] + corner_z},
-              {base[0] + du[0] + dv[0] + corner_x,
-                  base[1] + du[1] + dv[1] + corner_y,
-                  base[2] + du[2] + dv[2] + corner_z}};
+              {base[0] * scale + corner_x,
+                  base[1] * scale + corner_y,
+                  base[2] * scale + corner_z},
+              {(base[0] + du[0]) * scale + corner_x,
+                  (base[1] + du[1]) * scale + corner_y,
+                  (base[2] + du[2]) * scale + corner_z},
+              {(base[0] + dv[0]) * scale + corner_x,
+                  (base[1] + dv[1]) * scale + corner_y,
+                  (base[2] + dv[2]) * scale + corner_z},
+              {(base[0] + du[0] + dv[0]) * scale + corner_x,
+                  (base[1] + du[1] + dv[1]) * scale + corner_y,
+                  (base[2] + du[2] + dv[2]) * scale + corner_z}};
           // Is the face pointing in the positive direction in its axis?
           bool face_positive = face_positive_mask[y * size_u + x];
 
-          // Texcoord calculation + rotation
+          // Texcoord calculation + rotation, textures repeat once per block
+          float quad_w = (float)(width * scale);
+          float quad_h = (float)(height * scale);
           float s[4], t[4];
           if (u_axis == 1 && v_axis != 1) {
             s[0] = 0;
             t[0] = 0;
             s[1] = 0;
-            t[1] = (float)width;
-            s[2] = (float)height;
+            t[1] = quad_w;
+            s[2] = quad_h;
             t[2] = 0;
-            s[3] = (float)height;
-            t[3] = (float)width;
+            s[3] = quad_h;
+            t[3] = quad_w;
           } else {
             s[0] = 0;
             t[0] = 0;
-            s[1] = (float)width;
+            s[1] = quad_w;
             t[1] = 0;
             s[2] = 0;
-            t[2] = (float)height;
-            s[3] = (float)width;
-            t[3] = (float)height;
+            t[2] = quad_h;
+            s[3] = quad_w;
+            t[3] = quad_h;
           }
 
           // Fix texcoords for some faces
           if (!(((u_axis != 1 && face_positive)
                   || (v_axis != 1 && !face_positive)))) {
-            for (int i = 0; i < 4; i++) { s[i] = (float)width - s[i]; }
+            for (int i = 0; i < 4; i++) { s[i] = quad_w - s[i]; }
           }
 
           Vertex *target       = verts;
@@ -403,11 +830,60 @@ void mesh_chunk(Chunk *chunk) {
     free(face_positive_mask);
   }
 
-  // Upload vertices to meshes
+  return vert_count;
+}
+
+// Greedy meshing
+bool mesh_blocks(
+    const Block *blocks, const int coords[3], uint8_t lod, ChunkMesh *mesh) {
+  if (!blocks || !coords || !mesh) { return false; }
+  *mesh = (ChunkMesh){0};
+
+  // Gather the cells to mesh, downsampled for lower levels of detail
+  if (lod >= CHUNK_LOD_LEVELS) { lod = 0; }
+  int n            = CHUNK_WIDTH >> lod;
+  BlockType *cells = malloc(sizeof(BlockType) * n * n * n);
+  // Allocate array of mesh vertices
+  size_t max_verts = (size_t)n * n * n * 6;
+  Vertex *verts    = malloc(sizeof(Vertex) * max_verts);
+  if (!cells || !verts) {
+    fprintf(stderr,
+        "(mesh_blocks): Couldn't mesh chunk at (%d, %d, %d), malloc failed.\n",
+        coords[0],
+        coords[1],
+        coords[2]);
+    if (cells) { free(cells); }
+    if (verts) { free(verts); }
+    return false;
+  }
+  if (lod == 0) {
+    for (size_t i = 0; i < CHUNK_VOLUME; i++) { cells[i] = blocks[i].type; }
+  } else {
+    downsample_blocks(blocks, lod, cells);
+  }
+
+  // Chunk global coordinates
+  int corner[3]     = {coords[0] * CHUNK_WIDTH,
+      coords[1] * CHUNK_HEIGHT,
+      coords[2] * CHUNK_LENGTH};
+  size_t vert_count = mesh_grid(cells, n, 1 << lod, corner, verts);
+  free(cells);
+
   if (vert_count > 0) {
-    nu_mesh_add_bytes(chunk->mesh, vert_count * sizeof(Vertex), verts);
+    mesh->vertices     = mesh_group_faces(verts, vert_count,
+        mesh->face_vertices);
+    mesh->num_vertices = vert_count;
+  } else {
+    free(verts);
   }
-  free(verts);
 
-  chunk->state = STATE_NEEDS_SEND;
+  // Find which faces can see each other, for occlusion culling
+  mesh->visibility = chunk_visibility(blocks);
+  return true;
+}
+
+void chunk_invalidate_mesh(Chunk *chunk) {
+  if (!chunk) { return; }
+  chunk->state = STATE_NEEDS_MESH;
+  chunk->revision++;
 }
@@ -11,37 +11,194 @@
 
 #define CHUNK_INDEX(x, y, z) ((z) + (x) * CHUNK_LENGTH + (y) * CHUNK_AREA)
 
+// Chunks are cubes with a power of 2 side, so block coords split into chunk
+// coords (x >> CHUNK_SHIFT) and local coords (x & CHUNK_MASK)
+#define CHUNK_SHIFT 5
+#define CHUNK_MASK (CHUNK_WIDTH - 1)
+_Static_assert(CHUNK_WIDTH == 1 << CHUNK_SHIFT && CHUNK_HEIGHT == CHUNK_WIDTH
+                   && CHUNK_LENGTH == CHUNK_WIDTH,
+    "chunks must be cubes with a power of 2 side");
+
+// Chunks are split into bricks of CHUNK_BRICK blocks to a side. Each chunk
+// keeps a bit per brick that has anything but air in it, so queries can skip
+// empty space a brick at a time. Takes local block coords
+#define CHUNK_BRICK_SHIFT 3
+#define CHUNK_BRICK (1 << CHUNK_BRICK_SHIFT)
+#define CHUNK_BRICKS (CHUNK_WIDTH / CHUNK_BRICK) // Bricks to a side
+#define CHUNK_BRICK_BIT(x, y, z)                                               \
+  (1ull << (((z) >> CHUNK_BRICK_SHIFT)                                         \
+            + ((x) >> CHUNK_BRICK_SHIFT) * CHUNK_BRICKS                        \
+            + ((y) >> CHUNK_BRICK_SHIFT) * CHUNK_BRICKS * CHUNK_BRICKS))
+_Static_assert(CHUNK_BRICKS * CHUNK_BRICKS * CHUNK_BRICKS <= 64,
+    "a chunk's bricks must fit in a 64 bit mask");
+
+// Each chunk keeps a bit per block that isn't air, a word per row of blocks
+// along z. Bit z of row CHUNK_ROW(x, y) is the block at (x, y, z), so a row's
+// word index is its blocks' CHUNK_INDEX / CHUNK_LENGTH
+#define CHUNK_ROW(x, y) ((x) + (y) * CHUNK_WIDTH)
+_Static_assert(CHUNK_LENGTH == 32, "a row of blocks must fit in a 32 bit word");
+
+// Block types a chunk keeps a summary of, air included
+#define CHUNK_BLOCK_TYPES (NUM_BLOCKS + 1)
+
+// Levels of detail a chunk can be meshed at, level n merges 2^n blocks to a
+// side
+#define CHUNK_LOD_LEVELS 4
+
 // Includes
 #include "block.h"
 #include "nuGL.h"
 #include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 typedef enum {
   STATE_EMPTY,
   STATE_NEEDS_MESH,
-  STATE_NEEDS_SEND,
+  STATE_MESHING,    // A worker is meshing a copy of the blocks
+  STATE_NEEDS_SEND, // Meshed, vertices are waiting to be handed to the renderer
   STATE_DONE
 } ChunkState;
 
+// Generation passes a chunk has completed, in order
+typedef enum {
+  GEN_STAGE_NONE,      // No block data yet
+  GEN_STAGE_TERRAIN,   // Terrain shape (stone / air)
+  GEN_STAGE_SURFACE,   // Surface blocks (grass, dirt, sand)
+  GEN_STAGE_ORES,      // Ore veins
+  GEN_STAGE_DECORATED, // Decorations (trees), ready for pending edits
+} GenStage;
+
 // Structs
+typedef struct {
+  GLfloat pos[3];
+  GLfloat tex[2];
+  GLint side_index;
+  GLint block_type;
+} Vertex;
+
 typedef struct {
   int coords[3];
   Block *blocks;
-  nu_Mesh *mesh;
+  // Which blocks and bricks aren't air, kept up to date with blocks. Read
+  // them through chunk_solid_row() and chunk_is_solid()
+  uint32_t occupancy[CHUNK_AREA]; // Indexed by CHUNK_ROW
+  uint64_t solid_bricks;          // CHUNK_BRICK_BIT of every non-empty brick
+  // How many blocks of each type the chunk holds, and the bricks that may
+  // hold them. A brick keeps its bit until its type's count drops to 0 or the
+  // summary is rebuilt, so the bits can only give false positives. Update
+  // them through chunk_count_block()
+  uint16_t type_counts[CHUNK_BLOCK_TYPES];
+  uint64_t type_bricks[CHUNK_BLOCK_TYPES];
+  Vertex *vertices; // Meshed vertices waiting to be sent
+  size_t num_vertices;
+  // Vertices facing each ChunkFace, stored in that order. All 0 if the mesh
+  // couldn't be grouped
+  size_t face_vertices[6];
+  uint16_t visibility; // Which faces see each other, found when meshing
+  uint8_t lod;         // Level of detail to mesh at
   ChunkState state;
+  GenStage gen_stage;
+  uint32_t revision; // Bumped whenever the mesh goes out of date
+  uint32_t pins;     // Threads using the chunk outside its bucket lock
+  bool orphaned;     // Unloaded while pinned, the last unpin frees it
   pthread_mutex_t chunk_mutex;
 } Chunk;
 
+// A mesh built from a copy of a chunk's blocks
+typedef struct {
+  Vertex *vertices; // Grouped by face when face_vertices adds up to the total
+  size_t num_vertices;
+  size_t face_vertices[6];
+  uint16_t visibility;
+} ChunkMesh;
+
+// A single block write in global block coordinates
+typedef struct {
+  int x, y, z;
+  BlockType type;
+} BlockEdit;
+
+// Growable list of block writes
+typedef struct {
+  BlockEdit *edits;
+  size_t edits_alloced;
+  size_t num_edits;
+} EditList;
+
 // Function prototypes
 Chunk *create_chunk(int chunk_x, int chunk_y, int chunk_z);
 void destroy_chunk(Chunk **chunk);
-void generate_chunk(Chunk *chunk, uint32_t seed);
-void mesh_chunk(Chunk *chunk);
+// Run every generation pass on an empty chunk. Decoration writes that land
+// outside of the chunk are appended to spill instead (spill may be NULL)
+void generate_chunk(Chunk *chunk, uint32_t seed, EditList *spill);
+// Sample the terrain's surface height and top block for a width by length
+// grid of columns, step blocks apart from (x0, z0), into arrays indexed
+// [i * length + j]. These are the surfaces generate_chunk() builds, without
+// decorations. Returns false if allocation failed
+bool terrain_surface_grid(int x0, int z0, size_t width, size_t length,
+    int step, uint32_t seed, float *heights, BlockType *tops);
+// Greedy mesh a chunk's worth of blocks at a level of detail, for the chunk
+// at coords. Only reads blocks, so it can run on a copy without holding the
+// chunk lock, and doesn't need a GL context. Returns false if allocation
+// failed
+bool mesh_blocks(
+    const Block *blocks, const int coords[3], uint8_t lod, ChunkMesh *mesh);
+// Mark a chunk's mesh as out of date, so it is meshed again and any mesh
+// still being built from the old blocks is dropped. The chunk lock must be
+// held
+void chunk_invalidate_mesh(Chunk *chunk);
 bool chunk_set_block(Chunk *chunk, BlockType block, size_t x, size_t y, size_t z);
+// Rebuild a chunk's occupancy, solid_bricks and type summary from its blocks,
+// for code that writes blocks directly instead of through chunk_set_block()
+void chunk_update_occupancy(Chunk *chunk);
+// Move a block from one type to another in a chunk's type summary. Local
+// coords must be in range
+static inline void chunk_count_block(
+    Chunk *chunk, BlockType from, BlockType to, size_t x, size_t y, size_t z) {
+  if (from < CHUNK_BLOCK_TYPES && chunk->type_counts[from] > 0
+      && --chunk->type_counts[from] == 0) {
+    chunk->type_bricks[from] = 0;
+  }
+  if (to < CHUNK_BLOCK_TYPES) {
+    chunk->type_counts[to]++;
+    chunk->type_bricks[to] |= CHUNK_BRICK_BIT(x, y, z);
+  }
+}
+// Get the row of blocks along z at (x, y) as a word, bit z is set if that
+// block isn't air. Coords must be in range
+static inline uint32_t chunk_solid_row(const Chunk *chunk, size_t x, size_t y) {
+  return chunk->occupancy[CHUNK_ROW(x, y)];
+}
+// Check if a block isn't air without reading the block. Coords must be in
+// range
+static inline bool chunk_is_solid(
+    const Chunk *chunk, size_t x, size_t y, size_t z) {
+  return (chunk_solid_row(chunk, x, y) >> z) & 1u;
+}
 Block *chunk_get_block(Chunk *chunk, size_t x, size_t y, size_t z);
+// Set every block in an inclusive box of local coords, clamped to the chunk.
+// Returns the number of blocks that changed, 0 if the chunk isn't generated
+size_t chunk_fill_box(
+    Chunk *chunk, BlockType block, const int lo[3], const int hi[3]);
+// Like chunk_fill_box(), but only changes blocks of type from
+size_t chunk_replace_box(Chunk *chunk, BlockType from, BlockType to,
+    const int lo[3], const int hi[3]);
+// Apply the edits that land in a chunk, skipping the rest. Edits are in
+// global coords and applied in order. Returns the number of blocks that
+// changed, 0 if the chunk isn't generated
+size_t chunk_apply_edits(Chunk *chunk, const BlockEdit *edits, size_t n);
+// Set every solid block whose centre is within radius of the segment a-b to
+// air. The segment is in global block coords, and can be a point for a
+// sphere. Returns the number of blocks that changed
+size_t chunk_carve_capsule(
+    Chunk *chunk, const float a[3], const float b[3], float radius);
 void lock_chunk(Chunk *chunk);
 void unlock_chunk(Chunk *chunk);
+// Append an edit to an edit list, returns false if allocation failed
+bool edit_list_push(EditList *list, BlockEdit edit);
+// Free an edit list's storage and reset it
+void edit_list_free(EditList *list);
 
 #endif
@@ -0,0 +1,122 @@
+#include "decoration.h"
+
+#include "noise.h"
+
+#define TREE_CELL_SIZE 8      // At most one tree per 8x8 column cell
+#define TREE_MIN_TRUNK 4      // Shortest trunk, in blocks
+#define TREE_TRUNK_VARIANCE 3 // Trunks are up to this many blocks taller
+#define TREE_SEED_OFFSET 0x7ee5
+
+// Decorations only grow into air, and logs win over leaves, so overlapping
+// decorations end up the same no matter which order they are applied in
+static inline int decoration_priority(BlockType type) {
+  switch (type) {
+  case BlockAir: return 0;
+  case BlockLeaves: return 1;
+  case BlockLog: return 2;
+  default: return 3;
+  }
+}
+
+bool decoration_apply(
+    Chunk *chunk, BlockType type, size_t x, size_t y, size_t z) {
+  if (!chunk || !chunk->blocks) { return false; }
+  if (x >= CHUNK_WIDTH || y >= CHUNK_HEIGHT || z >= CHUNK_LENGTH) {
+    return false;
+  }
+  Block *block = &chunk->blocks[CHUNK_INDEX(x, y, z)];
+  if (decoration_priority(type) <= decoration_priority(block->type)) {
+    return false;
+  }
+  // Decorations never write air, so they can only fill blocks and bricks
+  chunk_count_block(chunk, block->type, type, x, y, z);
+  block->type = type;
+  chunk->occupancy[CHUNK_ROW(x, y)] |= 1u << z;
+  chunk->solid_bricks |= CHUNK_BRICK_BIT(x, y, z);
+  return true;
+}
+
+size_t decoration_apply_edits(Chunk *chunk, const EditList *edits) {
+  if (!chunk || !edits) { return 0; }
+  int ccx        = chunk->coords[0] * CHUNK_WIDTH;
+  int ccy        = chunk->coords[1] * CHUNK_HEIGHT;
+  int ccz        = chunk->coords[2] * CHUNK_LENGTH;
+  size_t changed = 0;
+  for (size_t i = 0; i < edits->num_edits; i++) {
+    BlockEdit edit = edits->edits[i];
+    int x          = edit.x - ccx;
+    int y          = edit.y - ccy;
+    int z          = edit.z - ccz;
+    if (x < 0 || y < 0 || z < 0) { continue; }
+    if (decoration_apply(chunk, edit.type, x, y, z)) { changed++; }
+  }
+  return changed;
+}
+
+// Write a block in global coords, either into the chunk or into spill
+static void place_block(
+    Chunk *chunk, EditList *spill, BlockType type, int gx, int gy, int gz) {
+  int x = gx - chunk->coords[0] * CHUNK_WIDTH;
+  int y = gy - chunk->coords[1] * CHUNK_HEIGHT;
+  int z = gz - chunk->coords[2] * CHUNK_LENGTH;
+  if (x >= 0 && x < CHUNK_WIDTH && y >= 0 && y < CHUNK_HEIGHT && z >= 0
+      && z < CHUNK_LENGTH) {
+    decoration_apply(chunk, type, x, y, z);
+  } else if (spill) {
+    edit_list_push(spill, (BlockEdit){.x = gx, .y = gy, .z = gz, .type = type});
+  }
+}
+
+// Place a tree with its trunk starting at (gx, gy, gz)
+static void place_tree(
+    Chunk *chunk, EditList *spill, int gx, int gy, int gz, int trunk) {
+  // Leaves, two wide layers then two narrow ones around the top of the trunk
+  for (int dy = trunk - 2; dy <= trunk + 1; dy++) {
+    int radius = dy < trunk ? 2 : 1;
+    for (int dx = -radius; dx <= radius; dx++) {
+      for (int dz = -radius; dz <= radius; dz++) {
+        bool corner = abs(dx) == radius && abs(dz) == radius;
+        if (corner && (radius == 2 || dy == trunk + 1)) { continue; }
+        place_block(chunk, spill, BlockLeaves, gx + dx, gy + dy, gz + dz);
+      }
+    }
+  }
+  // Trunk
+  for (int dy = 0; dy < trunk; dy++) {
+    place_block(chunk, spill, BlockLog, gx, gy + dy, gz);
+  }
+}
+
+void decorate_chunk(Chunk *chunk, uint32_t seed, const float *heightmap,
+    const BiomeType *biomes, EditList *spill) {
+  if (!chunk || !chunk->blocks || !heightmap || !biomes) { return; }
+  int ccx = chunk->coords[0] * CHUNK_WIDTH;
+  int ccy = chunk->coords[1] * CHUNK_HEIGHT;
+  int ccz = chunk->coords[2] * CHUNK_LENGTH;
+
+  // Each cell hashes to at most one tree, so placement only depends on the
+  // seed and the cell, never on which chunks are loaded
+  for (int cx = 0; cx < CHUNK_WIDTH; cx += TREE_CELL_SIZE) {
+    for (int cz = 0; cz < CHUNK_LENGTH; cz += TREE_CELL_SIZE) {
+      uint32_t hash = noise_hash_2d((ccx + cx) / TREE_CELL_SIZE,
+          (ccz + cz) / TREE_CELL_SIZE,
+          seed + TREE_SEED_OFFSET);
+      int x     = cx + (int)((hash >> 16) % TREE_CELL_SIZE);
+      int z     = cz + (int)((hash >> 20) % TREE_CELL_SIZE);
+      int trunk = TREE_MIN_TRUNK + (int)((hash >> 24) % TREE_TRUNK_VARIANCE);
+
+      // The biome decides how dense trees are, and they only grow on grass
+      const BiomeInfo *info = biome_info(biomes[CHUNK_INDEX(x, 0, z)]);
+      if ((hash & 0xffff) >= (uint32_t)(info->tree_chance * 0xffff)) {
+        continue;
+      }
+      if (info->top_block != BlockGrass) { continue; }
+
+      // The chunk holding the block above the surface owns the tree
+      int root_y = (int)floorf(heightmap[CHUNK_INDEX(x, 0, z)]) + 1;
+      if (root_y < ccy || root_y >= ccy + CHUNK_HEIGHT) { continue; }
+
+      place_tree(chunk, spill, ccx + x, root_y, ccz + z, trunk);
+    }
+  }
+}
@@ -0,0 +1,21 @@
+#ifndef DECORATION_H
+#define DECORATION_H
+
+// Includes
+#include "biome.h"
+#include "chunk.h"
+#include <stdint.h>
+
+// Function prototypes
+// Place the trees rooted in a chunk. Blocks that land outside of the chunk are
+// appended to spill, so the neighbour can pick them up without regenerating
+void decorate_chunk(Chunk *chunk, uint32_t seed, const float *heightmap,
+    const BiomeType *biomes, EditList *spill);
+// Write a decoration block at chunk-relative coords, if it is allowed to
+// replace the block already there. Returns true if the block changed
+bool decoration_apply(Chunk *chunk, BlockType type, size_t x, size_t y, size_t z);
+// Apply every edit in a list that falls inside a chunk, returns the number of
+// blocks that changed
+size_t decoration_apply_edits(Chunk *chunk, const EditList *edits);
+
+#endif // decoration.h
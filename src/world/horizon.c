@@ -0,0 +1,399 @@
+#include "horizon.h"
+
+#include "block.h"
+#include "chunk.h"
+#include <limits.h>
+#include <unistd.h>
+
+// Near plane used for the horizon, it never starts closer than the loaded box
+#define HORIZON_NEAR 8.f
+
+// Rough average colour of each block's top texture
+static const float block_colours[NUM_BLOCKS + 1][3] = {
+    [BlockAir]        = {0.36f, 0.60f, 0.25f},
+    [BlockDirt]       = {0.45f, 0.32f, 0.20f},
+    [BlockGrass]      = {0.36f, 0.60f, 0.25f},
+    [BlockStone]      = {0.50f, 0.50f, 0.50f},
+    [BlockSand]       = {0.86f, 0.80f, 0.55f},
+    [BlockLog]        = {0.40f, 0.30f, 0.18f},
+    [BlockDiamondOre] = {0.50f, 0.50f, 0.50f},
+    [BlockLeaves]     = {0.24f, 0.45f, 0.18f},
+};
+
+static inline int floor_div(int a, int b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+static inline int tile_distance(const int a[2], const int b[2]) {
+  int dx = abs(a[0] - b[0]);
+  int dz = abs(a[1] - b[1]);
+  return dx > dz ? dx : dz;
+}
+
+bool horizon_build_tile(const int coords[2], uint32_t seed,
+    HorizonVertex *vertices, vec3 box[2]) {
+  if (!coords || !vertices || !box) { return false; }
+
+  // Sample one extra ring around the tile, so normals on its edges match the
+  // neighbouring tiles
+  const size_t padded = HORIZON_TILE_SAMPLES + 2;
+  int x0              = coords[0] * HORIZON_TILE_SIZE;
+  int z0              = coords[1] * HORIZON_TILE_SIZE;
+  float *heights      = malloc(sizeof(float) * padded * padded);
+  BlockType *tops     = malloc(sizeof(BlockType) * padded * padded);
+  if (!heights || !tops
+      || !terrain_surface_grid(x0 - HORIZON_TILE_STEP,
+          z0 - HORIZON_TILE_STEP,
+          padded,
+          padded,
+          HORIZON_TILE_STEP,
+          seed,
+          heights,
+          tops)) {
+    if (heights) { free(heights); }
+    if (tops) { free(tops); }
+    return false;
+  }
+
+  float min_y = INFINITY, max_y = -INFINITY;
+  for (size_t i = 0; i < HORIZON_TILE_SAMPLES; i++) {
+    for (size_t j = 0; j < HORIZON_TILE_SAMPLES; j++) {
+      size_t p = (i + 1) * padded + j + 1;
+      // Columns are filled up to floor(height), so their top is one above
+      float y = floorf(heights[p]) + 1.f;
+
+      // Shade slopes like the block shader shades sides, darker the steeper
+      float dx = (heights[p + padded] - heights[p - padded])
+                 / (2.f * HORIZON_TILE_STEP);
+      float dz = (heights[p + 1] - heights[p - 1]) / (2.f * HORIZON_TILE_STEP);
+      float ny = 1.f / sqrtf(dx * dx + 1.f + dz * dz);
+      float brightness = 0.6f + 0.4f * ny;
+      const float *colour = block_colours[tops[p] <= NUM_BLOCKS ? tops[p] : 0];
+
+      vertices[i * HORIZON_TILE_SAMPLES + j] = (HorizonVertex){
+          {x0 + (float)(i * HORIZON_TILE_STEP),
+              y,
+              z0 + (float)(j * HORIZON_TILE_STEP)},
+          {colour[0] * brightness,
+              colour[1] * brightness,
+              colour[2] * brightness}};
+      if (y < min_y) { min_y = y; }
+      if (y > max_y) { max_y = y; }
+    }
+  }
+  box[0][0] = (float)x0;
+  box[0][1] = min_y;
+  box[0][2] = (float)z0;
+  box[1][0] = (float)(x0 + HORIZON_TILE_SIZE);
+  box[1][1] = max_y;
+  box[1][2] = (float)(z0 + HORIZON_TILE_SIZE);
+
+  free(heights);
+  free(tops);
+  return true;
+}
+
+// Build the queued tile nearest the centre, returns false if there was none
+static bool horizon_build_next(Horizon *horizon) {
+  pthread_mutex_lock(&horizon->mutex);
+  HorizonTile *tile = NULL;
+  int best          = INT_MAX;
+  for (size_t i = 0; i < HORIZON_SLOTS; i++) {
+    HorizonTile *t = &horizon->tiles[i];
+    if (t->state != TILE_QUEUED) { continue; }
+    int dist = tile_distance(t->coords, horizon->centre);
+    if (dist < best) {
+      best = dist;
+      tile = t;
+    }
+  }
+  if (!tile) {
+    pthread_mutex_unlock(&horizon->mutex);
+    return false;
+  }
+  tile->state   = TILE_BUILDING;
+  int coords[2] = {tile->coords[0], tile->coords[1]};
+  pthread_mutex_unlock(&horizon->mutex);
+
+  // Build without the lock, the slot is left alone while it is building
+  vec3 box[2];
+  HorizonVertex *vertices = malloc(
+      sizeof(HorizonVertex) * HORIZON_TILE_VERTICES);
+  bool built = vertices
+               && horizon_build_tile(coords, horizon->seed, vertices, box);
+  if (!built) {
+    fprintf(stderr,
+        "(horizon_build_next): Couldn't build horizon tile (%d, %d), "
+        "allocation failed.\n",
+        coords[0],
+        coords[1]);
+  }
+
+  pthread_mutex_lock(&horizon->mutex);
+  if (built && tile->wanted) {
+    tile->vertices = vertices;
+    glm_vec3_copy(box[0], tile->box[0]);
+    glm_vec3_copy(box[1], tile->box[1]);
+    tile->state = TILE_BUILT;
+    vertices    = NULL;
+  } else {
+    tile->state = TILE_FREE;
+  }
+  pthread_mutex_unlock(&horizon->mutex);
+  if (vertices) { free(vertices); }
+  return true;
+}
+
+static void *horizon_thread_routine(void *arg) {
+  Horizon *horizon = (Horizon *)arg;
+  if (!horizon) { return NULL; }
+  while (!horizon->kill) {
+    if (!horizon_build_next(horizon)) { usleep(1000); }
+  }
+  return NULL;
+}
+
+// Recycle tiles outside the radius, then queue missing tiles ring by ring
+// from the centre until the budget runs out. Must hold the mutex
+static void horizon_queue_tiles(Horizon *horizon) {
+  for (size_t i = 0; i < HORIZON_SLOTS; i++) {
+    HorizonTile *tile = &horizon->tiles[i];
+    if (tile->state == TILE_FREE) { continue; }
+    bool in_range = tile_distance(tile->coords, horizon->centre)
+                    <= HORIZON_RADIUS;
+    if (tile->state == TILE_BUILDING) {
+      tile->wanted = in_range;
+      continue;
+    }
+    if (in_range) { continue; }
+    if (tile->state == TILE_READY) { horizon->num_ready--; }
+    if (tile->vertices) { free(tile->vertices); }
+    tile->vertices = NULL;
+    tile->state    = TILE_FREE;
+  }
+
+  size_t next_free = 0;
+  for (int ring = 0; ring <= HORIZON_RADIUS; ring++) {
+    for (int dx = -ring; dx <= ring; dx++) {
+      for (int dz = -ring; dz <= ring; dz++) {
+        if (abs(dx) != ring && abs(dz) != ring) { continue; }
+        int coords[2] = {horizon->centre[0] + dx, horizon->centre[1] + dz};
+
+        bool present = false;
+        for (size_t i = 0; i < HORIZON_SLOTS && !present; i++) {
+          HorizonTile *tile = &horizon->tiles[i];
+          present = tile->state != TILE_FREE && tile->coords[0] == coords[0]
+                    && tile->coords[1] == coords[1];
+        }
+        if (present) { continue; }
+
+        while (next_free < HORIZON_SLOTS
+               && horizon->tiles[next_free].state != TILE_FREE) {
+          next_free++;
+        }
+        if (next_free == HORIZON_SLOTS) { return; }
+        horizon->tiles[next_free] = (HorizonTile){
+            .coords = {coords[0], coords[1]},
+            .state  = TILE_QUEUED,
+            .wanted = true,
+        };
+      }
+    }
+  }
+}
+
+Horizon *create_horizon(uint32_t seed) {
+  nu_Program *program = nu_create_program(
+      2, "shaders/horizon.vert", "shaders/horizon.frag");
+  if (!program) {
+    fprintf(stderr,
+        "(create_horizon): Error creating horizon, nu_create_program() "
+        "returned NULL.\n");
+    return NULL;
+  }
+  nu_register_uniform(program, "uMVP", GL_FLOAT_MAT4);
+  nu_register_uniform(program, "uPlayerPos", GL_FLOAT_VEC3);
+  nu_register_uniform(program, "uRenderDistance", GL_FLOAT);
+  nu_register_uniform(program, "uInnerMin", GL_FLOAT_VEC3);
+  nu_register_uniform(program, "uInnerMax", GL_FLOAT_VEC3);
+
+  Horizon *horizon = calloc(1, sizeof(Horizon));
+  if (!horizon) {
+    fprintf(stderr,
+        "(create_horizon): Error creating horizon, calloc failed.\n");
+    nu_destroy_program(&program);
+    return NULL;
+  }
+  horizon->program = program;
+  horizon->seed    = seed;
+
+  // Every tile shares one grid of indices, drawn with its slot's base vertex
+  GLushort *indices = malloc(sizeof(GLushort) * HORIZON_TILE_INDICES);
+  if (!indices) {
+    fprintf(stderr,
+        "(create_horizon): Error creating horizon, malloc failed.\n");
+    nu_destroy_program(&horizon->program);
+    free(horizon);
+    return NULL;
+  }
+  size_t n = 0;
+  for (GLushort i = 0; i + 1 < HORIZON_TILE_SAMPLES; i++) {
+    for (GLushort j = 0; j + 1 < HORIZON_TILE_SAMPLES; j++) {
+      GLushort v00 = i * HORIZON_TILE_SAMPLES + j;
+      GLushort v10 = v00 + HORIZON_TILE_SAMPLES;
+      indices[n++] = v00;
+      indices[n++] = v10;
+      indices[n++] = v00 + 1;
+      indices[n++] = v00 + 1;
+      indices[n++] = v10;
+      indices[n++] = v10 + 1;
+    }
+  }
+
+  glGenVertexArrays(1, &horizon->vao);
+  glGenBuffers(1, &horizon->vbo);
+  glGenBuffers(1, &horizon->ebo);
+  glBindVertexArray(horizon->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, horizon->vbo);
+  glBufferData(GL_ARRAY_BUFFER,
+      sizeof(HorizonVertex) * HORIZON_TILE_VERTICES * HORIZON_SLOTS,
+      NULL,
+      GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, horizon->ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+      sizeof(GLushort) * HORIZON_TILE_INDICES,
+      indices,
+      GL_STATIC_DRAW);
+  GLsizei stride = sizeof(HorizonVertex);
+  glVertexAttribPointer(0,
+      3,
+      GL_FLOAT,
+      GL_FALSE,
+      stride,
+      (void *)offsetof(HorizonVertex, pos));
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1,
+      3,
+      GL_FLOAT,
+      GL_FALSE,
+      stride,
+      (void *)offsetof(HorizonVertex, colour));
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  free(indices);
+
+  // Queue the tiles around the origin, then start building them
+  pthread_mutex_init(&horizon->mutex, NULL);
+  horizon_queue_tiles(horizon);
+  horizon->kill = false;
+  pthread_create(
+      &horizon->thread, NULL, horizon_thread_routine, (void *)horizon);
+
+  return horizon;
+}
+
+void destroy_horizon(Horizon **horizon) {
+  if (!horizon || !(*horizon)) { return; }
+  (*horizon)->kill = true;
+  pthread_join((*horizon)->thread, NULL);
+  pthread_mutex_destroy(&(*horizon)->mutex);
+  for (size_t i = 0; i < HORIZON_SLOTS; i++) {
+    if ((*horizon)->tiles[i].vertices) { free((*horizon)->tiles[i].vertices); }
+  }
+  if ((*horizon)->vbo) { glDeleteBuffers(1, &(*horizon)->vbo); }
+  if ((*horizon)->ebo) { glDeleteBuffers(1, &(*horizon)->ebo); }
+  if ((*horizon)->vao) { glDeleteVertexArrays(1, &(*horizon)->vao); }
+  nu_destroy_program(&(*horizon)->program);
+  free(*horizon);
+  *horizon = NULL;
+}
+
+void horizon_update_centre(Horizon *horizon, int x, int z) {
+  if (!horizon) { return; }
+  int centre[2] = {
+      floor_div(x, HORIZON_TILE_SIZE), floor_div(z, HORIZON_TILE_SIZE)};
+  pthread_mutex_lock(&horizon->mutex);
+  if (centre[0] != horizon->centre[0] || centre[1] != horizon->centre[1]) {
+    horizon->centre[0] = centre[0];
+    horizon->centre[1] = centre[1];
+    horizon_queue_tiles(horizon);
+  }
+  pthread_mutex_unlock(&horizon->mutex);
+}
+
+float horizon_distance(void) {
+  return (float)(HORIZON_RADIUS * HORIZON_TILE_SIZE);
+}
+
+void render_horizon(Horizon *horizon, Camera *camera, float aspect,
+    const float inner_min[2], const float inner_max[2]) {
+  if (!horizon || !camera || !inner_min || !inner_max) { return; }
+
+  // Upload tiles the worker has finished. The lock is held until drawing is
+  // done, the worker only needs it between tiles
+  pthread_mutex_lock(&horizon->mutex);
+  glBindBuffer(GL_ARRAY_BUFFER, horizon->vbo);
+  for (size_t i = 0; i < HORIZON_SLOTS; i++) {
+    HorizonTile *tile = &horizon->tiles[i];
+    if (tile->state != TILE_BUILT) { continue; }
+    glBufferSubData(GL_ARRAY_BUFFER,
+        sizeof(HorizonVertex) * HORIZON_TILE_VERTICES * i,
+        sizeof(HorizonVertex) * HORIZON_TILE_VERTICES,
+        tile->vertices);
+    free(tile->vertices);
+    tile->vertices = NULL;
+    tile->state    = TILE_READY;
+    horizon->num_ready++;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // The horizon is further than the camera's far plane, so it gets its own
+  // projection and depth range
+  float old_near = camera->near;
+  float old_far  = camera->far;
+  camera->near   = HORIZON_NEAR;
+  camera->far    = horizon_distance() * 1.415f;
+  mat4 vp;
+  camera_calculate_vp_matrix(camera, vp, aspect);
+  camera->near = old_near;
+  camera->far  = old_far;
+  vec4 planes[6];
+  glm_frustum_planes(vp, planes);
+
+  float render_dist = horizon_distance();
+  float inner_lo[3] = {inner_min[0], 0.f, inner_min[1]};
+  float inner_hi[3] = {inner_max[0], 0.f, inner_max[1]};
+  nu_set_uniform(horizon->program, "uMVP", &vp[0][0]);
+  nu_set_uniform(horizon->program, "uPlayerPos", camera->position);
+  nu_set_uniform(horizon->program, "uRenderDistance", &render_dist);
+  nu_set_uniform(horizon->program, "uInnerMin", inner_lo);
+  nu_set_uniform(horizon->program, "uInnerMax", inner_hi);
+  nu_use_program(horizon->program);
+
+  glDisable(GL_CULL_FACE);
+  glEnable(GL_DEPTH_TEST);
+  glBindVertexArray(horizon->vao);
+  horizon->num_drawn = 0;
+  for (size_t i = 0; i < HORIZON_SLOTS; i++) {
+    HorizonTile *tile = &horizon->tiles[i];
+    if (tile->state != TILE_READY) { continue; }
+    // Skip tiles the loaded chunks cover completely, and tiles out of view
+    if (tile->box[0][0] >= inner_min[0] && tile->box[1][0] <= inner_max[0]
+        && tile->box[0][2] >= inner_min[1] && tile->box[1][2] <= inner_max[1]) {
+      continue;
+    }
+    if (!glm_aabb_frustum(tile->box, planes)) { continue; }
+    glDrawElementsBaseVertex(GL_TRIANGLES,
+        HORIZON_TILE_INDICES,
+        GL_UNSIGNED_SHORT,
+        NULL,
+        (GLint)(HORIZON_TILE_VERTICES * i));
+    horizon->num_drawn++;
+  }
+  glBindVertexArray(0);
+  pthread_mutex_unlock(&horizon->mutex);
+
+  // Chunks are always nearer than the horizon, so they draw over it
+  glClear(GL_DEPTH_BUFFER_BIT);
+}
@@ -0,0 +1,84 @@
+#ifndef HORIZON_H
+
+#define HORIZON_H
+
+// Includes
+#include "camera.h"
+#include "nuGL.h"
+#include <cglm/cglm.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Far terrain is drawn as square heightfield tiles, each HORIZON_TILE_SIZE
+// blocks across with a height sample every HORIZON_TILE_STEP blocks
+#define HORIZON_TILE_SIZE 256
+#define HORIZON_TILE_STEP 8
+#define HORIZON_TILE_SAMPLES (HORIZON_TILE_SIZE / HORIZON_TILE_STEP + 1)
+#define HORIZON_TILE_VERTICES (HORIZON_TILE_SAMPLES * HORIZON_TILE_SAMPLES)
+#define HORIZON_TILE_INDICES \
+  ((HORIZON_TILE_SAMPLES - 1) * (HORIZON_TILE_SAMPLES - 1) * 6)
+// Tiles loaded either side of the centre's tile
+#define HORIZON_RADIUS 6
+// Tile budget, the vertex buffer has room for exactly this many tiles. Tiles
+// nearest the centre get slots first if the radius needs more
+#define HORIZON_SLOTS 192
+
+// Structs
+typedef struct {
+  GLfloat pos[3];
+  GLfloat colour[3];
+} HorizonVertex;
+
+typedef enum {
+  TILE_FREE,     // Slot is unused
+  TILE_QUEUED,   // Waiting for the worker
+  TILE_BUILDING, // Being built by the worker
+  TILE_BUILT,    // Vertices are waiting to be uploaded
+  TILE_READY     // In the vertex buffer, ready to draw
+} HorizonTileState;
+
+// One slot of the tile budget
+typedef struct {
+  int coords[2]; // Tile coords, block x and z / HORIZON_TILE_SIZE
+  HorizonTileState state;
+  bool wanted; // Cleared if the tile leaves the radius while it is building
+  HorizonVertex *vertices; // Built vertices, owned until uploaded
+  vec3 box[2];             // World space AABB of the tile
+} HorizonTile;
+
+typedef struct {
+  nu_Program *program;
+  GLuint vao, vbo, ebo; // Every slot's vertices, and the indices they share
+  HorizonTile tiles[HORIZON_SLOTS];
+  int centre[2]; // Tile the centre is in
+  uint32_t seed;
+  pthread_t thread;      // Builds queued tiles
+  pthread_mutex_t mutex; // Protects tile states, vertices and the centre
+  volatile bool kill;
+  size_t num_ready; // Tiles in the vertex buffer
+  size_t num_drawn; // Tiles drawn last frame
+} Horizon;
+
+// Function prototypes
+// Create a horizon and start its worker, needs a GL context
+Horizon *create_horizon(uint32_t seed);
+// Stop the worker and free every resource, and null the pointer
+void destroy_horizon(Horizon **horizon);
+// Set the block position that tiles stream around. Tiles that leave the
+// radius are recycled, and new ones are queued nearest first
+void horizon_update_centre(Horizon *horizon, int x, int z);
+// Distance in blocks the horizon is guaranteed to reach from the centre
+float horizon_distance(void);
+// Upload finished tiles and draw the ones in view, then clear the depth
+// buffer so chunks draw over it. Fragments inside the inclusive box of block
+// x and z from inner_min to inner_max are left to the loaded chunks
+void render_horizon(Horizon *horizon, Camera *camera, float aspect,
+    const float inner_min[2], const float inner_max[2]);
+// Build the vertices of one tile and find its bounds, false if allocation
+// failed. Doesn't need a GL context
+bool horizon_build_tile(const int coords[2], uint32_t seed,
+    HorizonVertex *vertices, vec3 box[2]);
+
+#endif // horizon.h
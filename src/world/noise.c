@@ -1,5 +1,18 @@
 #include "noise.h"
 
+#include <stdio.h>
+
+// Build with -DNOISE_STATS to count lattice hashes, e.g. for benchmarking the
+// grid path against per-sample noise
+#ifdef NOISE_STATS
+#include <stdatomic.h>
+static atomic_size_t hash_count;
+#define COUNT_HASH() \
+  atomic_fetch_add_explicit(&hash_count, 1, memory_order_relaxed)
+#else
+#define COUNT_HASH()
+#endif
+
 // https://gist.github.com/badboy/6267743
 static inline uint32_t hash6432shift(uint64_t key, uint32_t seed) {
   key += (uint64_t)seed * 0x9e3779b97f4a7c15ULL;
@@ -15,6 +28,7 @@ static inline uint32_t hash6432shift(uint64_t key, uint32_t seed) {
 
 // Hash a pair of coordinates
 static inline int hash_coords_2d(int x, int y, uint32_t seed) {
+  COUNT_HASH();
   uint64_t lx = (uint64_t)(uint32_t)x;
   uint64_t ly = (uint64_t)(uint32_t)y;
   uint64_t n  = (lx << 32) | ly;
@@ -23,11 +37,28 @@ static inline int hash_coords_2d(int x, int y, uint32_t seed) {
 
 // Hash 3 coordinates
 static inline int hash_coords_3d(int x, int y, int z, uint32_t seed) {
+  COUNT_HASH();
   uint64_t n = (uint64_t)x * 73856093ULL ^ (uint64_t)y * 19349663ULL
                ^ (uint64_t)z * 83492791ULL;
   return (int)hash6432shift(n, seed);
 }
 
+size_t noise_hash_count(void) {
+#ifdef NOISE_STATS
+  return atomic_load(&hash_count);
+#else
+  return 0;
+#endif
+}
+
+uint32_t noise_hash_2d(int x, int z, uint32_t seed) {
+  return (uint32_t)hash_coords_2d(x, z, seed);
+}
+
+uint32_t noise_hash_3d(int x, int y, int z, uint32_t seed) {
+  return (uint32_t)hash_coords_3d(x, y, z, seed);
+}
+
 static inline float lerp(float a, float b, float t) { return a + (b - a) * t; }
 
 // Generate a single 2D noise value at a resolution
@@ -69,6 +100,107 @@ float octave_noise_2d(float x, float z, int octaves, float persistence,
   return total / maxValue;
 }
 
+// Find the lattice cell and offset into it of every sample along one axis
+static void grid_axis_cells(int start, size_t count, int step, float frequency,
+    int octave, int offset, int res, int *cells, float *ts, int *min_cell,
+    int *max_cell) {
+  for (size_t i = 0; i < count; i++) {
+    // Same arithmetic as octave_noise_2d + noise_2d, so results are identical
+    float p  = (float)(start + (int)i * step) * frequency + octave * offset;
+    cells[i] = (int)floorf(p / res);
+    ts[i]    = (p - cells[i] * res) / res;
+    if (i == 0 || cells[i] < *min_cell) { *min_cell = cells[i]; }
+    if (i == 0 || cells[i] > *max_cell) { *max_cell = cells[i]; }
+  }
+}
+
+bool octave_noise_2d_grid(float *out, int x0, int z0, size_t width,
+    size_t length, int step, int octaves, float persistence, float lacunarity,
+    int base_res, uint32_t seed) {
+  if (!out || width == 0 || length == 0) { return true; }
+  size_t count = width * length;
+  for (size_t i = 0; i < count; i++) { out[i] = 0.f; }
+
+  int *xas    = malloc(sizeof(int) * width);
+  float *txs  = malloc(sizeof(float) * width);
+  int *zas    = malloc(sizeof(int) * length);
+  float *tzs  = malloc(sizeof(float) * length);
+  float *row  = NULL; // Lattice values interpolated along x for one row
+  float *grid = NULL; // Lattice values, one hash per lattice point
+  size_t grid_alloced = 0, row_alloced = 0;
+  bool success        = false;
+  if (!xas || !txs || !zas || !tzs) { goto cleanup; }
+
+  const float inv_int_max = 1.0f / (float)INT32_MAX;
+  float frequency = 1.0f, amplitude = 1.0f, max_value = 0.0f;
+  for (int o = 0; o < octaves; o++) {
+    int res = (int)fmaxf(1.0f, base_res / frequency);
+    int xa_min = 0, xa_max = 0, za_min = 0, za_max = 0;
+    grid_axis_cells(
+        x0, width, step, frequency, o, 54209, res, xas, txs, &xa_min, &xa_max);
+    grid_axis_cells(
+        z0, length, step, frequency, o, 82731, res, zas, tzs, &za_min, &za_max);
+
+    // Hash each lattice point the samples touch once
+    size_t nx     = (size_t)(xa_max - xa_min) + 2;
+    size_t nz     = (size_t)(za_max - za_min) + 2;
+    size_t points = nx * nz;
+    if (points > grid_alloced) {
+      float *new_grid = realloc(grid, sizeof(float) * points);
+      if (!new_grid) { goto cleanup; }
+      grid         = new_grid;
+      grid_alloced = points;
+    }
+    if (nz > row_alloced) {
+      float *new_row = realloc(row, sizeof(float) * nz);
+      if (!new_row) { goto cleanup; }
+      row         = new_row;
+      row_alloced = nz;
+    }
+    for (size_t i = 0; i < nx; i++) {
+      for (size_t j = 0; j < nz; j++) {
+        int hash = hash_coords_2d(xa_min + (int)i, za_min + (int)j, seed);
+        grid[i * nz + j] = (hash & 0x7fffffff) * inv_int_max;
+      }
+    }
+
+    for (size_t i = 0; i < width; i++) {
+      // Interpolate the row's lattice values along x once, then every sample
+      // in the row only has to interpolate along z
+      size_t xi     = (size_t)(xas[i] - xa_min);
+      const float *a = &grid[xi * nz];
+      const float *b = &grid[(xi + 1) * nz];
+      for (size_t j = 0; j < nz; j++) { row[j] = lerp(a[j], b[j], txs[i]); }
+
+      for (size_t j = 0; j < length; j++) {
+        size_t zi = (size_t)(zas[j] - za_min);
+        float n   = lerp(row[zi], row[zi + 1], tzs[j]) * 2 - 1;
+        out[i * length + j] += n * amplitude;
+      }
+    }
+
+    max_value += amplitude;
+    amplitude *= persistence;
+    frequency *= lacunarity;
+  }
+
+  for (size_t i = 0; i < count; i++) { out[i] /= max_value; }
+  success = true;
+
+cleanup:
+  if (xas) { free(xas); }
+  if (txs) { free(txs); }
+  if (zas) { free(zas); }
+  if (tzs) { free(tzs); }
+  if (row) { free(row); }
+  if (grid) { free(grid); }
+  if (!success) {
+    fprintf(stderr,
+        "(octave_noise_2d_grid): Couldn't sample noise, malloc failed.\n");
+  }
+  return success;
+}
+
 // Generate a single 3D noise value at a resolution
 float noise_3d(float x, float y, float z, int res, uint32_t seed) {
   int xa = (int)floorf(x / res);
@@ -3,17 +3,31 @@
 
 // Includes
 #include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 // Structs
 
 // Function prototypes
+// Hash integer coordinates into a pseudo-random 32 bit value
+uint32_t noise_hash_2d(int x, int z, uint32_t seed);
+uint32_t noise_hash_3d(int x, int y, int z, uint32_t seed);
+// Number of lattice hashes computed so far, only counted when built with
+// -DNOISE_STATS, otherwise always 0
+size_t noise_hash_count(void);
 // Generate a single 2D noise value at a resolution
 float noise_2d(float x, float z, int res, uint32_t seed);
 // Layer 2D noise with varying amplitudes and frequencies
 float octave_noise_2d(float x, float z, int octaves, float persistence,
     float lacunarity, int base_res, uint32_t seed);
+// Fill out[i * length + j] with octave_noise_2d(x0 + i * step, z0 + j * step,
+// ...) for a width by length grid of samples. Gives identical results, but
+// each lattice point is only hashed once per octave instead of 4 times per
+// sample. Returns false if allocation failed, out is undefined then
+bool octave_noise_2d_grid(float *out, int x0, int z0, size_t width,
+    size_t length, int step, int octaves, float persistence, float lacunarity,
+    int base_res, uint32_t seed);
 // Generate a single 3D noise value at a resolution
 float noise_3d(float x, float y, float z, int res, uint32_t seed);
 // Layer 3D noise with varying amplitudes and frequencies
@@ -0,0 +1,78 @@
+#include "ore.h"
+
+#include "noise.h"
+
+#define ORE_SEED_OFFSET 0x0be5
+
+// Ore density per block type and depth band, add rows to add ores
+static const OreConfig ore_configs[] = {
+    {BlockDiamondOre, -64, 16, 1.5f, 5},
+    {BlockDiamondOre, INT32_MIN, -65, 4.f, 8},
+};
+
+#define NUM_ORE_CONFIGS (sizeof(ore_configs) / sizeof(ore_configs[0]))
+
+// Small xorshift RNG, so veins only depend on the seed they start from
+static inline uint32_t ore_rand(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static inline float ore_randf(uint32_t *state) {
+  return (float)(ore_rand(state) & 0xffffff) / (float)0x1000000;
+}
+
+void generate_ores(Chunk *chunk, uint32_t seed) {
+  if (!chunk || !chunk->blocks) { return; }
+  int ccy = chunk->coords[1] * CHUNK_HEIGHT;
+
+  for (size_t i = 0; i < NUM_ORE_CONFIGS; i++) {
+    const OreConfig *ore = &ore_configs[i];
+
+    // Skip bands that don't overlap this chunk
+    int min_y = ore->min_y > ccy ? ore->min_y - ccy : 0;
+    int max_y = ore->max_y < ccy + CHUNK_HEIGHT - 1 ? ore->max_y - ccy
+                                                    : CHUNK_HEIGHT - 1;
+    if (min_y > max_y) { continue; }
+
+    // Every ore type gets its own stream, so adding one doesn't move another
+    uint32_t state = noise_hash_3d(chunk->coords[0],
+        chunk->coords[1],
+        chunk->coords[2],
+        seed + ORE_SEED_OFFSET + (uint32_t)i);
+    if (state == 0) { state = 1; }
+
+    // A chunk that only partly overlaps the band gets its share of the veins,
+    // so ore isn't denser in the chunks at the band's edges
+    float veins   = ore->veins_per_chunk * (float)(max_y - min_y + 1)
+                  / (float)CHUNK_HEIGHT;
+    int num_veins = (int)veins;
+    if (ore_randf(&state) < veins - num_veins) { num_veins++; }
+
+    for (int v = 0; v < num_veins; v++) {
+      int x = ore_rand(&state) % CHUNK_WIDTH;
+      int y = min_y + ore_rand(&state) % (max_y - min_y + 1);
+      int z = ore_rand(&state) % CHUNK_LENGTH;
+
+      // Random walk from the start, only touching the vein's own blocks
+      for (int b = 0; b < ore->vein_size; b++) {
+        if (x >= 0 && x < CHUNK_WIDTH && y >= 0 && y < CHUNK_HEIGHT && z >= 0
+            && z < CHUNK_LENGTH) {
+          Block *block = &chunk->blocks[CHUNK_INDEX(x, y, z)];
+          if (block->type == BlockStone) { block->type = ore->block; }
+        }
+        uint32_t step = ore_rand(&state);
+        int dir       = (step & 1) ? 1 : -1;
+        switch ((step >> 1) % 3) {
+        case 0: x += dir; break;
+        case 1: y += dir; break;
+        default: z += dir; break;
+        }
+      }
+    }
+  }
+}
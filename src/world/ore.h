@@ -0,0 +1,23 @@
+#ifndef ORE_H
+#define ORE_H
+
+// Includes
+#include "block.h"
+#include "chunk.h"
+#include <stdint.h>
+
+// Structs
+typedef struct {
+  BlockType block;       // Ore block to place
+  int min_y, max_y;      // Depth band veins can start in, in block coords
+  float veins_per_chunk; // Average number of veins per chunk in the band
+  int vein_size;         // Number of blocks in a vein
+} OreConfig;
+
+// Function prototypes
+// Place ore veins into the stone of a chunk. Veins come from an RNG seeded by
+// the world seed and the chunk's coords, and never leave the chunk, so the
+// result doesn't depend on which thread or in what order chunks generate
+void generate_ores(Chunk *chunk, uint32_t seed);
+
+#endif // ore.h
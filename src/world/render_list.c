@@ -0,0 +1,639 @@
+#include "render_list.h"
+
+#include <string.h>
+#include <time.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+static inline uint32_t hash_coords(const int coords[3]) {
+  return (uint32_t)(coords[0] * 73856093) ^ (coords[1] * 19349663)
+         ^ (coords[2] * 83492791);
+}
+
+static inline bool coords_equal(const int a[3], const int b[3]) {
+  return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+static inline int floor_div(int a, int b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+// Split chunk coords into group coords and an index inside the group
+static inline size_t group_split(const int coords[3], int group[3]) {
+  int local[3];
+  for (int i = 0; i < 3; i++) {
+    group[i] = floor_div(coords[i], RENDER_GROUP_SIZE);
+    local[i] = coords[i] - group[i] * RENDER_GROUP_SIZE;
+  }
+  return local[0]
+         + (local[1] + local[2] * RENDER_GROUP_SIZE) * RENDER_GROUP_SIZE;
+}
+
+// Find the slot holding a group's index, or the empty slot where it would go
+static size_t render_list_slot(const RenderList *list, const int group[3]) {
+  size_t mask = list->num_slots - 1;
+  size_t slot = hash_coords(group) & mask;
+  while (list->slots[slot] >= 0
+         && !coords_equal(list->groups[list->slots[slot]].coords, group)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+// Resize the slot table and reinsert every group
+static bool render_list_rehash(RenderList *list, size_t num_slots) {
+  int *slots = malloc(sizeof(int) * num_slots);
+  if (!slots) { return false; }
+  for (size_t i = 0; i < num_slots; i++) { slots[i] = -1; }
+  if (list->slots) { free(list->slots); }
+  list->slots     = slots;
+  list->num_slots = num_slots;
+  for (size_t i = 0; i < list->num_groups; i++) {
+    list->slots[render_list_slot(list, list->groups[i].coords)] = (int)i;
+  }
+  return true;
+}
+
+// Find a group's index, -1 if it has no records
+static int render_list_group(const RenderList *list, const int group[3]) {
+  if (list->num_groups == 0) { return -1; }
+  return list->slots[render_list_slot(list, group)];
+}
+
+void render_list_init(RenderList *list) {
+  if (!list) { return; }
+  *list = (RenderList){0};
+}
+
+void render_list_free(RenderList *list) {
+  if (!list) { return; }
+  vertex_arena_free(&list->arena);
+  if (list->groups) { free(list->groups); }
+  if (list->records) { free(list->records); }
+  if (list->min_x) { free(list->min_x); }
+  if (list->min_y) { free(list->min_y); }
+  if (list->min_z) { free(list->min_z); }
+  if (list->slots) { free(list->slots); }
+  if (list->visible) { free(list->visible); }
+  if (list->draw_firsts) { free(list->draw_firsts); }
+  if (list->draw_counts) { free(list->draw_counts); }
+  if (list->sort_visible) { free(list->sort_visible); }
+  if (list->sort_keys) { free(list->sort_keys); }
+  occlusion_walk_free(&list->walk);
+  *list = (RenderList){0};
+}
+
+RenderRecord *render_list_find(RenderList *list, int x, int y, int z) {
+  if (!list) { return NULL; }
+  int coords[3] = {x, y, z};
+  int group[3];
+  size_t local = group_split(coords, group);
+  int g        = render_list_group(list, group);
+  if (g < 0 || !(list->groups[g].mask & (1ULL << local))) { return NULL; }
+  return &list->records[(size_t)g * RENDER_GROUP_CHUNKS + local];
+}
+
+// Grow every per group array to hold at least one more group
+static bool render_list_reserve_group(RenderList *list) {
+  if (list->num_groups < list->groups_alloced) { return true; }
+  size_t new_alloced = list->groups_alloced ? list->groups_alloced * 2 : 64;
+  size_t chunks      = new_alloced * RENDER_GROUP_CHUNKS;
+
+  RenderGroup *new_groups = realloc(
+      list->groups, sizeof(RenderGroup) * new_alloced);
+  if (new_groups) { list->groups = new_groups; }
+  RenderRecord *new_records = realloc(
+      list->records, sizeof(RenderRecord) * chunks);
+  if (new_records) { list->records = new_records; }
+  float *new_min_x = realloc(list->min_x, sizeof(float) * chunks);
+  if (new_min_x) { list->min_x = new_min_x; }
+  float *new_min_y = realloc(list->min_y, sizeof(float) * chunks);
+  if (new_min_y) { list->min_y = new_min_y; }
+  float *new_min_z = realloc(list->min_z, sizeof(float) * chunks);
+  if (new_min_z) { list->min_z = new_min_z; }
+  if (!new_groups || !new_records || !new_min_x || !new_min_y || !new_min_z) {
+    return false;
+  }
+  list->groups_alloced = new_alloced;
+  return true;
+}
+
+// Add an empty group, returns its index or -1 if allocation failed
+static int render_list_add_group(RenderList *list, const int group[3]) {
+  // Keep the slot table at most half full
+  if ((list->num_groups + 1) * 2 > list->num_slots) {
+    size_t num_slots = list->num_slots ? list->num_slots * 2 : 256;
+    if (!render_list_rehash(list, num_slots)) { return -1; }
+  }
+  if (!render_list_reserve_group(list)) { return -1; }
+
+  size_t g            = list->num_groups;
+  float size[3]       = {RENDER_GROUP_SIZE * CHUNK_WIDTH,
+      RENDER_GROUP_SIZE * CHUNK_HEIGHT,
+      RENDER_GROUP_SIZE * CHUNK_LENGTH};
+  RenderGroup *groups = list->groups;
+  groups[g]           = (RenderGroup){
+      .coords    = {group[0], group[1], group[2]},
+      .mask      = 0,
+      .reachable = 0,
+  };
+  for (int i = 0; i < 3; i++) {
+    groups[g].box[0][i] = group[i] * size[i];
+    groups[g].box[1][i] = group[i] * size[i] + size[i];
+  }
+
+  // The chunk boxes of a group never change, so fill them in now
+  size_t first = g * RENDER_GROUP_CHUNKS;
+  for (size_t i = 0; i < RENDER_GROUP_CHUNKS; i++) {
+    size_t lx                = i % RENDER_GROUP_SIZE;
+    size_t ly                = (i / RENDER_GROUP_SIZE) % RENDER_GROUP_SIZE;
+    size_t lz                = i / (RENDER_GROUP_SIZE * RENDER_GROUP_SIZE);
+    list->records[first + i] = (RenderRecord){0};
+    list->min_x[first + i]   = groups[g].box[0][0] + lx * CHUNK_WIDTH;
+    list->min_y[first + i]   = groups[g].box[0][1] + ly * CHUNK_HEIGHT;
+    list->min_z[first + i]   = groups[g].box[0][2] + lz * CHUNK_LENGTH;
+  }
+
+  list->slots[render_list_slot(list, group)] = (int)g;
+  list->num_groups++;
+  return (int)g;
+}
+
+// Remove an empty group, moving the last group into its place
+static void render_list_remove_group(RenderList *list, int g) {
+  size_t mask = list->num_slots - 1;
+  size_t slot = render_list_slot(list, list->groups[g].coords);
+
+  // Empty the slot, then shift back any later slot in the same probe run
+  // that could no longer be reached past the gap
+  list->slots[slot] = -1;
+  size_t next       = (slot + 1) & mask;
+  while (list->slots[next] >= 0) {
+    int moved    = list->slots[next];
+    size_t ideal = hash_coords(list->groups[moved].coords) & mask;
+    // Can the entry at next stay put? Only if its ideal slot is cyclically
+    // in (slot, next]
+    bool stays = slot < next ? (ideal > slot && ideal <= next)
+                             : (ideal > slot || ideal <= next);
+    if (!stays) {
+      list->slots[slot] = moved;
+      list->slots[next] = -1;
+      slot              = next;
+    }
+    next = (next + 1) & mask;
+  }
+
+  // Move the last group into the gap, so the arrays stay packed
+  size_t last = list->num_groups - 1;
+  if ((size_t)g != last) {
+    list->slots[render_list_slot(list, list->groups[last].coords)] = g;
+    list->groups[g] = list->groups[last];
+    size_t to       = (size_t)g * RENDER_GROUP_CHUNKS;
+    size_t from     = last * RENDER_GROUP_CHUNKS;
+    size_t count    = RENDER_GROUP_CHUNKS;
+    memcpy(&list->records[to],
+        &list->records[from],
+        sizeof(RenderRecord) * count);
+    memcpy(&list->min_x[to], &list->min_x[from], sizeof(float) * count);
+    memcpy(&list->min_y[to], &list->min_y[from], sizeof(float) * count);
+    memcpy(&list->min_z[to], &list->min_z[from], sizeof(float) * count);
+  }
+  list->num_groups--;
+}
+
+// Create the vertex arena the first time a mesh is published, so the list
+// can be set up before there is a GL context
+static bool render_list_init_arena(RenderList *list) {
+  if (list->arena.vbo) { return true; }
+  return vertex_arena_init(&list->arena, VERTEX_ARENA_INITIAL_CAPACITY);
+}
+
+// Pack every record's vertices to the front of a new arena buffer, with room
+// for at least extra more vertices. The buffer only grows if packing alone
+// wouldn't leave a quarter of it free
+static bool render_list_relocate(RenderList *list, size_t extra) {
+  VertexArena *arena = &list->arena;
+  size_t needed      = arena->alloc.used + extra;
+  size_t capacity    = arena->alloc.capacity;
+  while (needed > capacity - capacity / 4) { capacity *= 2; }
+  if (!vertex_arena_begin_move(arena, capacity)) { return false; }
+
+  size_t cursor = 0;
+  for (size_t g = 0; g < list->num_groups; g++) {
+    uint64_t mask = list->groups[g].mask;
+    while (mask) {
+      int i                = __builtin_ctzll(mask);
+      RenderRecord *record = &list->records[g * RENDER_GROUP_CHUNKS + i];
+      mask &= mask - 1;
+      if (record->num_vertices == 0) { continue; }
+      vertex_arena_move(arena, record->first, cursor, record->num_vertices);
+      record->first = cursor;
+      cursor += record->num_vertices;
+    }
+  }
+  vertex_arena_end_move(arena, cursor);
+  return true;
+}
+
+void render_list_publish(RenderList *list, const int coords[3],
+    Vertex *vertices, size_t num_vertices, const size_t *face_vertices,
+    uint16_t visibility, uint8_t lod) {
+  if (!list || !coords) { return; }
+  if (num_vertices == 0) {
+    render_list_retire(list, coords);
+    return;
+  }
+
+  int group[3];
+  size_t local = group_split(coords, group);
+  int g        = render_list_group(list, group);
+  if (g < 0) { g = render_list_add_group(list, group); }
+  if (g < 0 || !render_list_init_arena(list)) {
+    fprintf(stderr,
+        "(render_list_publish): Couldn't add chunk at (%d, %d, %d), "
+        "allocation failed.\n",
+        coords[0],
+        coords[1],
+        coords[2]);
+    return;
+  }
+
+  size_t index         = (size_t)g * RENDER_GROUP_CHUNKS + local;
+  RenderRecord *record = &list->records[index];
+  if (!(list->groups[g].mask & (1ULL << local))) {
+    *record = (RenderRecord){.coords = {coords[0], coords[1], coords[2]}};
+    list->groups[g].mask |= 1ULL << local;
+    list->num_records++;
+  }
+  // Upload the new mesh before letting go of the old one, so a chunk always
+  // has something to draw. If the upload fails the old mesh stays
+  size_t first = 0;
+  if (!vertex_arena_upload(&list->arena, vertices, num_vertices, &first)
+      && (!render_list_relocate(list, num_vertices)
+          || !vertex_arena_upload(
+              &list->arena, vertices, num_vertices, &first))) {
+    fprintf(stderr,
+        "(render_list_publish): Couldn't send chunk at (%d, %d, %d), "
+        "vertex_arena_upload() failed.\n",
+        coords[0],
+        coords[1],
+        coords[2]);
+    if (record->num_vertices == 0) { render_list_retire(list, coords); }
+    return;
+  }
+  if (record->num_vertices > 0) {
+    vertex_arena_release(&list->arena, record->first, record->num_vertices);
+    list->lod_records[record->lod]--;
+    list->lod_vertices[record->lod] -= record->num_vertices;
+  }
+  record->first        = first;
+  record->num_vertices = num_vertices;
+  record->visibility   = visibility;
+  record->lod          = lod < CHUNK_LOD_LEVELS ? lod : 0;
+  list->lod_records[record->lod]++;
+  list->lod_vertices[record->lod] += num_vertices;
+
+  // Only trust face counts that cover the whole mesh
+  size_t face_total = 0;
+  for (int f = 0; f < NUM_FACES; f++) {
+    record->face_vertices[f] = face_vertices ? face_vertices[f] : 0;
+    face_total += record->face_vertices[f];
+  }
+  record->faces_grouped = face_total == num_vertices;
+}
+
+void render_list_retire(RenderList *list, const int coords[3]) {
+  if (!list || !coords) { return; }
+  int group[3];
+  size_t local = group_split(coords, group);
+  int g        = render_list_group(list, group);
+  if (g < 0 || !(list->groups[g].mask & (1ULL << local))) { return; }
+
+  size_t index         = (size_t)g * RENDER_GROUP_CHUNKS + local;
+  RenderRecord *record = &list->records[index];
+  if (record->num_vertices > 0) {
+    vertex_arena_release(&list->arena, record->first, record->num_vertices);
+    list->lod_records[record->lod]--;
+    list->lod_vertices[record->lod] -= record->num_vertices;
+  }
+  *record = (RenderRecord){0};
+  list->groups[g].mask &= ~(1ULL << local);
+  list->num_records--;
+  if (list->groups[g].mask == 0) { render_list_remove_group(list, g); }
+}
+
+// Per plane constants for testing boxes of one size. A box with minimum
+// corner m is outside a plane if dot(plane.xyz, m) + far < 0, and fully
+// inside it if dot(plane.xyz, m) + near >= 0
+static void cull_plane_offsets(
+    vec4 planes[6], const float size[3], float far[6], float near[6]) {
+  for (int p = 0; p < 6; p++) {
+    far[p]  = planes[p][3];
+    near[p] = planes[p][3];
+    for (int i = 0; i < 3; i++) {
+      if (planes[p][i] > 0) {
+        far[p] += planes[p][i] * size[i];
+      } else {
+        near[p] += planes[p][i] * size[i];
+      }
+    }
+  }
+}
+
+// Test every chunk box of a group against the frustum, returns a bit per
+// chunk that is at least partly inside
+static uint64_t cull_group_chunks(const float *min_x, const float *min_y,
+    const float *min_z, vec4 planes[6], const float far[6]) {
+  uint64_t inside = 0;
+#ifdef __SSE__
+  // 4 chunks at a time, one plane at a time
+  __m128 px[6], py[6], pz[6], pw[6];
+  for (int p = 0; p < 6; p++) {
+    px[p] = _mm_set1_ps(planes[p][0]);
+    py[p] = _mm_set1_ps(planes[p][1]);
+    pz[p] = _mm_set1_ps(planes[p][2]);
+    pw[p] = _mm_set1_ps(far[p]);
+  }
+  const __m128 zero = _mm_setzero_ps();
+  for (size_t i = 0; i < RENDER_GROUP_CHUNKS; i += 4) {
+    __m128 x   = _mm_loadu_ps(&min_x[i]);
+    __m128 y   = _mm_loadu_ps(&min_y[i]);
+    __m128 z   = _mm_loadu_ps(&min_z[i]);
+    __m128 all = _mm_cmpeq_ps(zero, zero);
+    for (int p = 0; p < 6; p++) {
+      __m128 xy = _mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y));
+      __m128 d  = _mm_add_ps(xy, _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+      all = _mm_and_ps(all, _mm_cmpge_ps(d, zero));
+    }
+    inside |= (uint64_t)_mm_movemask_ps(all) << i;
+  }
+#else
+  for (size_t i = 0; i < RENDER_GROUP_CHUNKS; i++) {
+    bool in = true;
+    for (int p = 0; p < 6 && in; p++) {
+      float d = planes[p][0] * min_x[i] + planes[p][1] * min_y[i]
+                + planes[p][2] * min_z[i] + far[p];
+      in = d >= 0;
+    }
+    if (in) { inside |= 1ULL << i; }
+  }
+#endif
+  return inside;
+}
+
+// Mark a chunk the occlusion walk reached, returns its visibility set
+static uint16_t render_list_visit(void *data, const int coords[3]) {
+  RenderList *list = data;
+  int group[3];
+  size_t local = group_split(coords, group);
+  int g        = render_list_group(list, group);
+  if (g < 0 || !(list->groups[g].mask & (1ULL << local))) {
+    return VISIBILITY_ALL;
+  }
+  list->groups[g].reachable |= 1ULL << local;
+  return list->records[g * RENDER_GROUP_CHUNKS + local].visibility;
+}
+
+void render_list_occlude(RenderList *list, const int camera[3],
+    const int min[3], const int max[3], vec4 planes[6]) {
+  if (!list || !camera || !min || !max) { return; }
+  for (size_t g = 0; g < list->num_groups; g++) {
+    list->groups[g].reachable = 0;
+  }
+  // If the walk can't start, because the camera is outside the box or
+  // allocation failed, let everything through rather than hide it
+  if (!occlusion_walk(
+          &list->walk, camera, min, max, planes, render_list_visit, list)) {
+    for (size_t g = 0; g < list->num_groups; g++) {
+      list->groups[g].reachable = list->groups[g].mask;
+    }
+  }
+}
+
+void render_list_cull(RenderList *list, vec4 planes[6]) {
+  if (!list) { return; }
+  list->num_visible = 0;
+  if (list->num_records > list->visible_alloced) {
+    size_t new_alloced = list->visible_alloced ? list->visible_alloced : 1024;
+    while (new_alloced < list->num_records) { new_alloced *= 2; }
+    uint32_t *new_visible = realloc(
+        list->visible, sizeof(uint32_t) * new_alloced);
+    if (new_visible) { list->visible = new_visible; }
+    GLint *new_firsts = realloc(list->draw_firsts,
+        sizeof(GLint) * new_alloced * RENDER_RECORD_RANGES);
+    if (new_firsts) { list->draw_firsts = new_firsts; }
+    GLsizei *new_counts = realloc(list->draw_counts,
+        sizeof(GLsizei) * new_alloced * RENDER_RECORD_RANGES);
+    if (new_counts) { list->draw_counts = new_counts; }
+    uint32_t *new_sort_visible = realloc(
+        list->sort_visible, sizeof(uint32_t) * new_alloced);
+    if (new_sort_visible) { list->sort_visible = new_sort_visible; }
+    uint16_t *new_sort_keys = realloc(
+        list->sort_keys, sizeof(uint16_t) * new_alloced * 2);
+    if (new_sort_keys) { list->sort_keys = new_sort_keys; }
+    if (!new_visible || !new_firsts || !new_counts || !new_sort_visible
+        || !new_sort_keys) {
+      return;
+    }
+    list->visible_alloced = new_alloced;
+  }
+
+  const float chunk_size[3] = {CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_LENGTH};
+  const float group_size[3] = {RENDER_GROUP_SIZE * CHUNK_WIDTH,
+      RENDER_GROUP_SIZE * CHUNK_HEIGHT,
+      RENDER_GROUP_SIZE * CHUNK_LENGTH};
+  float chunk_far[6], chunk_near[6], group_far[6], group_near[6];
+  cull_plane_offsets(planes, chunk_size, chunk_far, chunk_near);
+  cull_plane_offsets(planes, group_size, group_far, group_near);
+
+  for (size_t g = 0; g < list->num_groups; g++) {
+    RenderGroup *group = &list->groups[g];
+    const float *m     = group->box[0];
+
+    // Skip groups fully outside any plane, and accept groups fully inside
+    // every plane without testing their chunks
+    bool outside = false, contained = true;
+    for (int p = 0; p < 6 && !outside; p++) {
+      float d = planes[p][0] * m[0] + planes[p][1] * m[1] + planes[p][2] * m[2];
+      outside   = d + group_far[p] < 0;
+      contained = contained && d + group_near[p] >= 0;
+    }
+    if (outside) { continue; }
+
+    size_t first     = g * RENDER_GROUP_CHUNKS;
+    uint64_t visible = group->mask;
+    if (list->occlusion) { visible &= group->reachable; }
+    if (!visible) { continue; }
+    if (!contained) {
+      visible &= cull_group_chunks(&list->min_x[first],
+          &list->min_y[first],
+          &list->min_z[first],
+          planes,
+          chunk_far);
+    }
+    while (visible) {
+      int i = __builtin_ctzll(visible);
+      list->visible[list->num_visible++] = (uint32_t)(first + i);
+      visible &= visible - 1;
+    }
+  }
+}
+
+// Sort keys are distances in blocks times this, so 16 bits covers 512 chunks
+#define SORT_KEY_SCALE 4.0f
+
+static double get_time_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+void render_list_sort(RenderList *list, const vec3 eye, bool back_to_front) {
+  if (!list || !eye || list->num_visible < 2) { return; }
+  double start = get_time_ms();
+  size_t n     = list->num_visible;
+  uint16_t *keys     = list->sort_keys;
+  uint16_t *keys_tmp = list->sort_keys + list->visible_alloced;
+  uint32_t *vals     = list->visible;
+  uint32_t *vals_tmp = list->sort_visible;
+
+  // Quantize each chunk's distance, and count both key bytes in one pass
+  const vec3 half = {CHUNK_WIDTH / 2.f, CHUNK_HEIGHT / 2.f, CHUNK_LENGTH / 2.f};
+  size_t counts[2][256] = {0};
+  for (size_t i = 0; i < n; i++) {
+    uint32_t r = vals[i];
+    float dx   = list->min_x[r] + half[0] - eye[0];
+    float dy   = list->min_y[r] + half[1] - eye[1];
+    float dz   = list->min_z[r] + half[2] - eye[2];
+    float d    = sqrtf(dx * dx + dy * dy + dz * dz) * SORT_KEY_SCALE;
+    uint16_t key = d < 65535.f ? (uint16_t)d : 65535;
+    if (back_to_front) { key = 65535 - key; }
+    keys[i] = key;
+    counts[0][key & 0xff]++;
+    counts[1][key >> 8]++;
+  }
+
+  // LSD radix sort, one pass per byte. A byte every key shares is skipped,
+  // which is usually the high byte when everything is close
+  for (int pass = 0; pass < 2; pass++) {
+    int shift = pass * 8;
+    if (counts[pass][(keys[0] >> shift) & 0xff] == n) { continue; }
+    size_t offsets[256];
+    size_t total = 0;
+    for (int b = 0; b < 256; b++) {
+      offsets[b] = total;
+      total += counts[pass][b];
+    }
+    for (size_t i = 0; i < n; i++) {
+      size_t dst    = offsets[(keys[i] >> shift) & 0xff]++;
+      keys_tmp[dst] = keys[i];
+      vals_tmp[dst] = vals[i];
+    }
+    uint16_t *swap_keys = keys;
+    keys                = keys_tmp;
+    keys_tmp            = swap_keys;
+    uint32_t *swap_vals = vals;
+    vals                = vals_tmp;
+    vals_tmp            = swap_vals;
+  }
+
+  // After an odd number of passes the result is in the scratch buffer, so the
+  // buffers trade places instead of copying it back
+  if (vals != list->visible) {
+    list->sort_visible = list->visible;
+    list->visible      = vals;
+  }
+  list->sort_ms = get_time_ms() - start;
+}
+
+// Find which ways a record's faces can point and still face the eye, one bit
+// per face. A +x face is only seen from above its plane, and a chunk's +x
+// faces all lie above its minimum x, so an eye at or below that sees none
+static inline uint8_t record_facing(
+    const RenderList *list, uint32_t index, const vec3 eye) {
+  const float min[3]  = {list->min_x[index], list->min_y[index],
+      list->min_z[index]};
+  const float size[3] = {CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_LENGTH};
+  uint8_t facing      = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    if (eye[axis] < min[axis] + size[axis]) { facing |= 1 << (axis * 2); }
+    if (eye[axis] > min[axis]) { facing |= 1 << (axis * 2 + 1); }
+  }
+  return facing;
+}
+
+void render_list_draw(RenderList *list, const vec3 eye) {
+  if (!list || !eye) { return; }
+  list->num_drawn_vertices   = 0;
+  list->num_skipped_vertices = 0;
+  if (list->num_visible == 0) { return; }
+
+  size_t num_ranges = 0;
+  for (size_t i = 0; i < list->num_visible; i++) {
+    RenderRecord *record = &list->records[list->visible[i]];
+    if (!record->faces_grouped) {
+      list->draw_firsts[num_ranges]   = (GLint)record->first;
+      list->draw_counts[num_ranges++] = (GLsizei)record->num_vertices;
+      list->num_drawn_vertices += record->num_vertices;
+      continue;
+    }
+
+    // Merge neighbouring faces that are drawn into one range
+    uint8_t facing = record_facing(list, list->visible[i], eye);
+    size_t offset  = record->first, run_first = 0, run_count = 0;
+    for (int f = 0; f < NUM_FACES; f++) {
+      size_t count = record->face_vertices[f];
+      if (facing & (1 << f)) {
+        if (run_count == 0) { run_first = offset; }
+        run_count += count;
+      } else {
+        if (run_count > 0) {
+          list->draw_firsts[num_ranges]   = (GLint)run_first;
+          list->draw_counts[num_ranges++] = (GLsizei)run_count;
+          list->num_drawn_vertices += run_count;
+          run_count = 0;
+        }
+        list->num_skipped_vertices += count;
+      }
+      offset += count;
+    }
+    if (run_count > 0) {
+      list->draw_firsts[num_ranges]   = (GLint)run_first;
+      list->draw_counts[num_ranges++] = (GLsizei)run_count;
+      list->num_drawn_vertices += run_count;
+    }
+  }
+  vertex_arena_draw(
+      &list->arena, list->draw_firsts, list->draw_counts, num_ranges);
+}
+
+size_t render_queue_drain(RenderUpdateQueue *queue, RenderList *list) {
+  if (!queue || !list) { return 0; }
+
+  // Stop after one queue's worth, so busy workers can't keep the render
+  // thread here forever
+  size_t count = 0;
+  RenderUpdate update;
+  while (count < queue->updates.capacity
+         && mpsc_queue_pop(&queue->updates, &update)) {
+    if (update.retire) {
+      render_list_retire(list, update.coords);
+    } else {
+      render_list_publish(list,
+          update.coords,
+          update.vertices,
+          update.num_vertices,
+          update.face_vertices,
+          update.visibility,
+          update.lod);
+    }
+    if (update.edit_time > 0.0
+        && (list->edit_time == 0.0 || update.edit_time < list->edit_time)) {
+      list->edit_time = update.edit_time;
+    }
+    if (update.vertices) { free(update.vertices); }
+    count++;
+  }
+  return count;
+}
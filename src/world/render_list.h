@@ -0,0 +1,114 @@
+#ifndef RENDER_LIST_H
+
+#define RENDER_LIST_H
+
+// Includes
+#include "chunk.h"
+#include "nuGL.h"
+#include "render_queue.h"
+#include "vertex_arena.h"
+#include "visibility.h"
+#include <cglm/cglm.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Chunks are culled in groups of RENDER_GROUP_SIZE^3, so whole groups can be
+// skipped or accepted with one test
+#define RENDER_GROUP_SIZE 4
+#define RENDER_GROUP_CHUNKS \
+  (RENDER_GROUP_SIZE * RENDER_GROUP_SIZE * RENDER_GROUP_SIZE)
+// Most multi-draw ranges one record needs. Faces are stored -x, +x, -y, +y,
+// -z, +z, and at most one of each pair is skipped, leaving 3 runs at worst
+#define RENDER_RECORD_RANGES 3
+
+// Structs
+// A chunk mesh that is on the GPU and ready to draw
+typedef struct {
+  int coords[3];
+  size_t first; // First vertex of the mesh in the vertex arena
+  size_t num_vertices;
+  size_t face_vertices[NUM_FACES]; // Vertices facing each way, in face order
+  bool faces_grouped; // False if the mesh isn't grouped, so it's drawn whole
+  uint16_t visibility; // Which of the chunk's faces see each other
+  uint8_t lod;         // Level of detail the mesh was made at
+} RenderRecord;
+
+// A group of chunks that is culled as one box before its chunks are
+typedef struct {
+  int coords[3]; // Group coords, chunk coords / RENDER_GROUP_SIZE
+  vec3 box[2];   // World space AABB of the whole group
+  uint64_t mask;      // Which of the group's chunks have a record
+  uint64_t reachable; // Which chunks the occlusion walk reached last frame
+} RenderGroup;
+
+// Every drawable chunk, stored by group so a frame is a linear scan. Each
+// group owns RENDER_GROUP_CHUNKS consecutive entries of the per chunk arrays.
+// Only ever touched by the render thread, so it needs no locks
+typedef struct {
+  RenderGroup *groups; // Packed, in no particular order
+  size_t groups_alloced;
+  size_t num_groups;
+  RenderRecord *records; // Per chunk, only valid where the group mask is set
+  float *min_x, *min_y, *min_z; // Per chunk AABB minimum corners, for culling
+  size_t num_records;           // Records holding a mesh
+  size_t lod_records[CHUNK_LOD_LEVELS];  // Records at each level of detail
+  size_t lod_vertices[CHUNK_LOD_LEVELS]; // and the vertices they hold
+  int *slots;       // Open addressing map of group coords to group index
+  size_t num_slots; // Always a power of 2, -1 marks an empty slot
+  VertexArena arena;  // Holds every record's vertices
+  uint32_t *visible;  // Indices of the records that passed culling
+  GLint *draw_firsts; // Multi-draw ranges of the visible records, up to
+  GLsizei *draw_counts; // RENDER_RECORD_RANGES per record
+  size_t visible_alloced;
+  size_t num_visible;
+  uint32_t *sort_visible; // Radix sort scratch, same size as visible
+  uint16_t *sort_keys;    // Quantized camera distances, two halves of
+                          // visible_alloced for the sort to swap between
+  double sort_ms;         // Time the last sort took
+  double edit_time; // Oldest edit drained since it was last cleared, 0 if none
+  size_t num_drawn_vertices;   // Vertices the last draw submitted
+  size_t num_skipped_vertices; // Vertices it skipped as facing away
+  bool occlusion;     // Whether culling also drops unreachable records
+  OcclusionWalk walk; // Scratch space for render_list_occlude()
+} RenderList;
+
+// Function prototypes
+void render_list_init(RenderList *list);
+// Free the list and its vertex arena, must be called on the GL thread
+void render_list_free(RenderList *list);
+// Find the record for a chunk, NULL if it has nothing to draw
+RenderRecord *render_list_find(RenderList *list, int x, int y, int z);
+// Upload a chunk's vertices into the arena, adding a record for it if needed.
+// A chunk with no vertices is removed instead, so the list only holds chunks
+// worth drawing. The arena is packed or grown when it runs out of room.
+// face_vertices counts the vertices facing each way if the mesh is grouped by
+// face, otherwise it is NULL and the mesh is always drawn whole. lod is the
+// level of detail the mesh was made at, only used for stats
+void render_list_publish(RenderList *list, const int coords[3],
+    Vertex *vertices, size_t num_vertices, const size_t *face_vertices,
+    uint16_t visibility, uint8_t lod);
+// Free a chunk's vertices and remove its record
+void render_list_retire(RenderList *list, const int coords[3]);
+// Mark the records an occlusion walk from the camera's chunk reaches, see
+// occlusion_walk(). Records it never reaches are hidden behind terrain.
+// Chunks without a record are treated as open air. If the walk can't run,
+// every record is marked reachable
+void render_list_occlude(RenderList *list, const int camera[3],
+    const int min[3], const int max[3], vec4 planes[6]);
+// Fill the visible list with every record inside the frustum, and reached by
+// the last occlusion walk if occlusion is on
+void render_list_cull(RenderList *list, vec4 planes[6]);
+// Sort the visible list by distance from the eye to each chunk's centre, near
+// to far so early depth testing rejects hidden fragments, or far to near for
+// blended passes. Distances are quantized to 16 bits and radix sorted
+void render_list_sort(RenderList *list, const vec3 eye, bool back_to_front);
+// Draw every record in the visible list with one multi-draw call, in order.
+// Faces of a record that point away from the eye are left out
+void render_list_draw(RenderList *list, const vec3 eye);
+
+// Apply every queued update to a render list, in the order they were queued.
+// Only the render thread may drain. Returns the number applied
+size_t render_queue_drain(RenderUpdateQueue *queue, RenderList *list);
+
+#endif // render_list.h
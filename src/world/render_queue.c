@@ -0,0 +1,23 @@
+#include "render_queue.h"
+
+#include <stdlib.h>
+
+bool render_queue_init(RenderUpdateQueue *queue) {
+  if (!queue) { return false; }
+  return mpsc_queue_init(
+      &queue->updates, RENDER_QUEUE_CAPACITY, sizeof(RenderUpdate));
+}
+
+void render_queue_free(RenderUpdateQueue *queue) {
+  if (!queue) { return; }
+  RenderUpdate update;
+  while (mpsc_queue_pop(&queue->updates, &update)) {
+    if (update.vertices) { free(update.vertices); }
+  }
+  mpsc_queue_free(&queue->updates);
+}
+
+bool render_queue_push(RenderUpdateQueue *queue, RenderUpdate update) {
+  if (!queue) { return false; }
+  return mpsc_queue_push(&queue->updates, &update);
+}
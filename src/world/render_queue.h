@@ -0,0 +1,48 @@
+#ifndef RENDER_QUEUE_H
+
+#define RENDER_QUEUE_H
+
+// Includes
+#include "chunk.h"
+#include "mpsc_queue.h"
+#include "visibility.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Updates that can wait between two drains before pushes start failing
+#define RENDER_QUEUE_CAPACITY 4096
+
+// Structs
+// A mesh published by a worker thread, or a chunk retired on unload
+typedef struct {
+  int coords[3];
+  Vertex *vertices; // Owned by the update until it is applied
+  size_t num_vertices;
+  size_t face_vertices[NUM_FACES];
+  uint16_t visibility;
+  uint8_t lod;
+  bool retire;
+  // When the edit this mesh shows was asked for, in seconds on
+  // CLOCK_MONOTONIC. 0 for meshes nobody is waiting on
+  double edit_time;
+} RenderUpdate;
+
+// Updates waiting for the render thread to apply them. Workers push and the
+// render thread drains without either taking a lock. Nothing here touches GL,
+// so headless worlds can publish meshes too
+typedef struct {
+  MpscQueue updates;
+} RenderUpdateQueue;
+
+// Function prototypes
+// Returns false if allocation failed
+bool render_queue_init(RenderUpdateQueue *queue);
+// Free the queue and any vertices still waiting in it
+void render_queue_free(RenderUpdateQueue *queue);
+// Queue an update, the queue takes ownership of its vertices. Can be called
+// from any thread. Returns false if the queue is full, the caller keeps the
+// vertices and has to try again after the render thread drains it
+bool render_queue_push(RenderUpdateQueue *queue, RenderUpdate update);
+
+#endif // render_queue.h
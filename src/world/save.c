@@ -0,0 +1,127 @@
+#include "save.h"
+
+#include <string.h>
+
+static const char save_magic[4] = {'V', 'X', 'C', 'H'};
+
+static void chunk_save_path(Chunk *chunk, const char *dir, char *out, size_t n) {
+  snprintf(out,
+      n,
+      "%s/c.%d.%d.%d.bin",
+      dir,
+      chunk->coords[0],
+      chunk->coords[1],
+      chunk->coords[2]);
+}
+
+bool chunk_save(Chunk *chunk, uint32_t seed, const char *dir) {
+  if (!chunk || !dir || !chunk->blocks
+      || chunk->gen_stage != GEN_STAGE_DECORATED) {
+    return false;
+  }
+
+  // Run length encode the blocks, worst case is one run per block
+  uint8_t *runs = malloc(CHUNK_VOLUME * 2);
+  if (!runs) {
+    fprintf(stderr, "(chunk_save): Couldn't save chunk, malloc failed.\n");
+    return false;
+  }
+  uint32_t num_runs = 0;
+  size_t i          = 0;
+  while (i < CHUNK_VOLUME) {
+    BlockType type = chunk->blocks[i].type;
+    size_t length  = 1;
+    while (i + length < CHUNK_VOLUME && length < UINT8_MAX
+           && chunk->blocks[i + length].type == type) {
+      length++;
+    }
+    runs[num_runs * 2]     = (uint8_t)length;
+    runs[num_runs * 2 + 1] = type;
+    num_runs++;
+    i += length;
+  }
+
+  char path[1024];
+  chunk_save_path(chunk, dir, path, sizeof(path));
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    fprintf(stderr, "(chunk_save): Couldn't open %s for writing.\n", path);
+    free(runs);
+    return false;
+  }
+  uint32_t version  = SAVE_VERSION;
+  int32_t coords[3] = {chunk->coords[0], chunk->coords[1], chunk->coords[2]};
+  bool ok = fwrite(save_magic, sizeof(save_magic), 1, file) == 1
+            && fwrite(&version, sizeof(version), 1, file) == 1
+            && fwrite(&seed, sizeof(seed), 1, file) == 1
+            && fwrite(coords, sizeof(coords), 1, file) == 1
+            && fwrite(&num_runs, sizeof(num_runs), 1, file) == 1
+            && fwrite(runs, 2, num_runs, file) == num_runs;
+  fclose(file);
+  free(runs);
+  if (!ok) { fprintf(stderr, "(chunk_save): Couldn't write %s.\n", path); }
+  return ok;
+}
+
+bool chunk_load(Chunk *chunk, uint32_t seed, const char *dir) {
+  if (!chunk || !dir || chunk->state != STATE_EMPTY) { return false; }
+
+  char path[1024];
+  chunk_save_path(chunk, dir, path, sizeof(path));
+  FILE *file = fopen(path, "rb");
+  if (!file) { return false; }
+
+  char magic[4];
+  uint32_t version;
+  uint32_t file_seed;
+  int32_t coords[3];
+  uint32_t num_runs;
+  bool ok = fread(magic, sizeof(magic), 1, file) == 1
+            && memcmp(magic, save_magic, sizeof(magic)) == 0
+            && fread(&version, sizeof(version), 1, file) == 1
+            && version == SAVE_VERSION
+            && fread(&file_seed, sizeof(file_seed), 1, file) == 1
+            && fread(coords, sizeof(coords), 1, file) == 1
+            && coords[0] == chunk->coords[0] && coords[1] == chunk->coords[1]
+            && coords[2] == chunk->coords[2]
+            && fread(&num_runs, sizeof(num_runs), 1, file) == 1
+            && num_runs <= CHUNK_VOLUME;
+
+  // A chunk generated with another seed wouldn't line up with its neighbours
+  if (ok && file_seed != seed) {
+    fprintf(stderr,
+        "(chunk_load): Ignoring %s, it was saved with seed %u, not %u.\n",
+        path,
+        file_seed,
+        seed);
+    fclose(file);
+    return false;
+  }
+
+  Block *blocks = ok ? calloc(CHUNK_VOLUME, sizeof(Block)) : NULL;
+  size_t i      = 0;
+  for (uint32_t r = 0; blocks && r < num_runs; r++) {
+    uint8_t run[2];
+    if (fread(run, sizeof(run), 1, file) != 1 || i + run[0] > CHUNK_VOLUME) {
+      break;
+    }
+    for (uint8_t j = 0; j < run[0]; j++) {
+      blocks[i++] = (Block){.type = run[1]};
+    }
+  }
+  fclose(file);
+
+  // Files that don't cover the whole chunk are treated as missing
+  if (!blocks || i != CHUNK_VOLUME) {
+    if (blocks) { free(blocks); }
+    fprintf(stderr, "(chunk_load): Ignoring invalid chunk file %s.\n", path);
+    return false;
+  }
+
+  if (chunk->blocks) { free(chunk->blocks); }
+  chunk->blocks    = blocks;
+  chunk->gen_stage = GEN_STAGE_DECORATED;
+  chunk_update_occupancy(chunk);
+  chunk_invalidate_mesh(chunk);
+  return true;
+}
@@ -0,0 +1,28 @@
+#ifndef SAVE_H
+#define SAVE_H
+
+// Includes
+#include "chunk.h"
+#include <stdbool.h>
+
+// Chunks are saved one file per chunk, as <dir>/c.<x>.<y>.<z>.bin:
+//   char magic[4]   "VXCH"
+//   uint32_t version
+//   uint32_t seed   World seed the chunk was generated with
+//   int32_t coords[3]
+//   uint32_t num_runs
+//   num_runs * {uint8_t length, uint8_t type}, run length encoded blocks in
+//   CHUNK_INDEX order
+// Integers are stored in native byte order
+
+#define SAVE_VERSION 2
+
+// Function prototypes
+// Write a generated chunk's blocks to dir, returns false on failure
+bool chunk_save(Chunk *chunk, uint32_t seed, const char *dir);
+// Read a chunk's blocks from dir, returns false if there was no valid file.
+// Files saved with another seed are rejected, so they aren't stitched onto
+// different terrain. On success the chunk is fully generated and needs meshing
+bool chunk_load(Chunk *chunk, uint32_t seed, const char *dir);
+
+#endif // save.h
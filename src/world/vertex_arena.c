@@ -0,0 +1,144 @@
+#include "vertex_arena.h"
+
+// Create a vertex buffer with room for capacity vertices
+static GLuint create_vbo(size_t capacity) {
+  GLuint vbo = 0;
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(
+      GL_ARRAY_BUFFER, capacity * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return vbo;
+}
+
+// 32 * 7 = 224 bytes per vertex
+// thats kinda crazy
+// Could send uniform chunk pos and use only 1 byte for each block offset
+// 3 bytes pos
+// Texcoords could be only one bit (only 0 or 1)
+// 2 bits tex
+// Side index only needs up to 6, so 3 bits
+// 3 bits side index
+// Block type depends how many blocks there are, so could use a byte
+// one byte side index
+// So 4.625 bytes per vertex
+// Or 37 bits per vertex
+// Probably needs to be padded up to 5 bytes
+// Can only pass as low as 4 bytes tho, so 8 bytes
+
+// Point the VAO's attributes at the arena's buffer
+static void bind_attributes(VertexArena *arena) {
+  glBindVertexArray(arena->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, arena->vbo);
+  GLsizei stride = sizeof(Vertex);
+  glVertexAttribPointer(
+      0, 3, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, pos));
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(
+      1, 2, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, tex));
+  glEnableVertexAttribArray(1);
+  glVertexAttribIPointer(
+      2, 1, GL_INT, stride, (void *)offsetof(Vertex, side_index));
+  glEnableVertexAttribArray(2);
+  glVertexAttribIPointer(
+      3, 1, GL_INT, stride, (void *)offsetof(Vertex, block_type));
+  glEnableVertexAttribArray(3);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool vertex_arena_init(VertexArena *arena, size_t capacity) {
+  if (!arena) { return false; }
+  *arena = (VertexArena){0};
+  if (!suballoc_init(&arena->alloc, capacity)) {
+    fprintf(stderr,
+        "(vertex_arena_init): Error creating vertex arena, suballoc_init() "
+        "failed.\n");
+    return false;
+  }
+  glGenVertexArrays(1, &arena->vao);
+  arena->vbo = create_vbo(capacity);
+  if (!arena->vao || !arena->vbo) {
+    fprintf(stderr,
+        "(vertex_arena_init): Error creating vertex arena, couldn't create "
+        "buffers.\n");
+    vertex_arena_free(arena);
+    return false;
+  }
+  bind_attributes(arena);
+  return true;
+}
+
+void vertex_arena_free(VertexArena *arena) {
+  if (!arena) { return; }
+  if (arena->vbo) { glDeleteBuffers(1, &arena->vbo); }
+  if (arena->move_vbo) { glDeleteBuffers(1, &arena->move_vbo); }
+  if (arena->vao) { glDeleteVertexArrays(1, &arena->vao); }
+  suballoc_free(&arena->alloc);
+  *arena = (VertexArena){0};
+}
+
+bool vertex_arena_upload(
+    VertexArena *arena, const Vertex *vertices, size_t count, size_t *first) {
+  if (!arena || !arena->vbo || !vertices || count == 0 || !first) {
+    return false;
+  }
+  if (!suballoc_alloc(&arena->alloc, count, first)) { return false; }
+  glBindBuffer(GL_ARRAY_BUFFER, arena->vbo);
+  glBufferSubData(GL_ARRAY_BUFFER,
+      *first * sizeof(Vertex),
+      count * sizeof(Vertex),
+      vertices);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return true;
+}
+
+void vertex_arena_release(VertexArena *arena, size_t first, size_t count) {
+  if (!arena) { return; }
+  suballoc_release(&arena->alloc, first, count);
+}
+
+bool vertex_arena_begin_move(VertexArena *arena, size_t capacity) {
+  if (!arena || arena->move_vbo) { return false; }
+  arena->move_vbo = create_vbo(capacity);
+  if (!arena->move_vbo) { return false; }
+  arena->move_capacity = capacity;
+  glBindBuffer(GL_COPY_READ_BUFFER, arena->vbo);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, arena->move_vbo);
+  return true;
+}
+
+void vertex_arena_move(
+    VertexArena *arena, size_t from, size_t to, size_t count) {
+  if (!arena || !arena->move_vbo || count == 0) { return; }
+  glCopyBufferSubData(GL_COPY_READ_BUFFER,
+      GL_COPY_WRITE_BUFFER,
+      from * sizeof(Vertex),
+      to * sizeof(Vertex),
+      count * sizeof(Vertex));
+}
+
+void vertex_arena_end_move(VertexArena *arena, size_t used) {
+  if (!arena || !arena->move_vbo) { return; }
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  if (arena->move_capacity > arena->alloc.capacity) {
+    arena->num_grows++;
+  } else {
+    arena->num_compactions++;
+  }
+  glDeleteBuffers(1, &arena->vbo);
+  arena->vbo      = arena->move_vbo;
+  arena->move_vbo = 0;
+  suballoc_reset(&arena->alloc, used, arena->move_capacity);
+  arena->move_capacity = 0;
+  bind_attributes(arena);
+}
+
+void vertex_arena_draw(VertexArena *arena, const GLint *firsts,
+    const GLsizei *counts, size_t num_ranges) {
+  if (!arena || !arena->vao || num_ranges == 0) { return; }
+  glBindVertexArray(arena->vao);
+  glMultiDrawArrays(GL_TRIANGLES, firsts, counts, (GLsizei)num_ranges);
+  glBindVertexArray(0);
+}
@@ -0,0 +1,49 @@
+#ifndef VERTEX_ARENA_H
+
+#define VERTEX_ARENA_H
+
+// Includes
+#include "chunk.h"
+#include "nuGL.h"
+#include "suballoc.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Vertices the arena starts with room for, it doubles when it runs out
+#define VERTEX_ARENA_INITIAL_CAPACITY (1 << 20)
+
+// Structs
+// One vertex buffer (and VAO) holding every chunk mesh, so they can all be
+// drawn with a single multi-draw call. Ranges are in vertices
+typedef struct {
+  GLuint vao;
+  GLuint vbo;
+  SubAllocator alloc;
+  GLuint move_vbo;        // Buffer being filled by a relocation, 0 if none
+  size_t move_capacity;   // Capacity of move_vbo
+  size_t num_grows;       // Relocations that made the buffer bigger
+  size_t num_compactions; // Relocations that only packed it
+} VertexArena;
+
+// Function prototypes
+// Create the arena's buffers, must be called on the GL thread
+bool vertex_arena_init(VertexArena *arena, size_t capacity);
+void vertex_arena_free(VertexArena *arena);
+// Allocate a range and upload vertices into it. Returns false if the arena
+// has no free range big enough, the owner should relocate and try again
+bool vertex_arena_upload(
+    VertexArena *arena, const Vertex *vertices, size_t count, size_t *first);
+// Free a range
+void vertex_arena_release(VertexArena *arena, size_t first, size_t count);
+// Relocation moves every live range into a fresh buffer. The owner calls
+// begin, then move for each range it owns (packing them from 0), then end
+// with the total it moved
+bool vertex_arena_begin_move(VertexArena *arena, size_t capacity);
+void vertex_arena_move(
+    VertexArena *arena, size_t from, size_t to, size_t count);
+void vertex_arena_end_move(VertexArena *arena, size_t used);
+// Draw a list of ranges in one call, the block program must be bound
+void vertex_arena_draw(VertexArena *arena, const GLint *firsts,
+    const GLsizei *counts, size_t num_ranges);
+
+#endif // vertex_arena.h
@@ -0,0 +1,218 @@
+#include "visibility.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Bit of each face pair in a visibility set, -1 on the diagonal
+static const int8_t pair_bits[NUM_FACES][NUM_FACES] = {
+    {-1, 0, 1, 2, 3, 4},
+    {0, -1, 5, 6, 7, 8},
+    {1, 5, -1, 9, 10, 11},
+    {2, 6, 9, -1, 12, 13},
+    {3, 7, 10, 12, -1, 14},
+    {4, 8, 11, 13, 14, -1},
+};
+
+bool visibility_connected(uint16_t visibility, ChunkFace a, ChunkFace b) {
+  if (a >= NUM_FACES || b >= NUM_FACES) { return false; }
+  if (a == b) { return true; }
+  return visibility & (1u << pair_bits[a][b]);
+}
+
+// Faces of the chunk a block touches
+static inline uint8_t block_faces(int x, int y, int z) {
+  uint8_t faces = 0;
+  if (x == 0) { faces |= 1 << FACE_NEG_X; }
+  if (x == CHUNK_WIDTH - 1) { faces |= 1 << FACE_POS_X; }
+  if (y == 0) { faces |= 1 << FACE_NEG_Y; }
+  if (y == CHUNK_HEIGHT - 1) { faces |= 1 << FACE_POS_Y; }
+  if (z == 0) { faces |= 1 << FACE_NEG_Z; }
+  if (z == CHUNK_LENGTH - 1) { faces |= 1 << FACE_POS_Z; }
+  return faces;
+}
+
+uint16_t chunk_visibility(const Block *blocks) {
+  if (!blocks) { return VISIBILITY_ALL; }
+
+  // Only air lets light through, anything else hides what is behind it
+  size_t num_air = 0;
+  for (size_t i = 0; i < CHUNK_VOLUME; i++) {
+    num_air += blocks[i].type == BlockAir;
+  }
+  if (num_air == 0) { return VISIBILITY_NONE; }
+  if (num_air == CHUNK_VOLUME) { return VISIBILITY_ALL; }
+
+  // Solid blocks start out visited, so the flood only walks air. If this
+  // fails, assume everything is connected so nothing gets wrongly hidden
+  uint8_t *visited = malloc(CHUNK_VOLUME);
+  uint16_t *stack  = malloc(sizeof(uint16_t) * CHUNK_VOLUME);
+  if (!visited || !stack) {
+    if (visited) { free(visited); }
+    if (stack) { free(stack); }
+    return VISIBILITY_ALL;
+  }
+  for (size_t i = 0; i < CHUNK_VOLUME; i++) {
+    visited[i] = blocks[i].type != BlockAir;
+  }
+
+  uint16_t visibility = VISIBILITY_NONE;
+  // Each air region only needs flooding from one of its border blocks, air
+  // that never reaches a face can't connect anything
+  for (int y = 0; y < CHUNK_HEIGHT; y++) {
+    for (int x = 0; x < CHUNK_WIDTH; x++) {
+      for (int z = 0; z < CHUNK_LENGTH; z++) {
+        uint8_t border = block_faces(x, y, z);
+        size_t start   = CHUNK_INDEX(x, y, z);
+        if (!border || visited[start]) { continue; }
+
+        // Flood the region, collecting the faces it touches
+        uint8_t faces      = 0;
+        size_t num_stack   = 0;
+        visited[start]     = 1;
+        stack[num_stack++] = (uint16_t)start;
+        while (num_stack > 0) {
+          size_t i = stack[--num_stack];
+          int by   = (int)(i / CHUNK_AREA);
+          int bx   = (int)(i % CHUNK_AREA / CHUNK_LENGTH);
+          int bz   = (int)(i % CHUNK_LENGTH);
+          faces |= block_faces(bx, by, bz);
+
+          int neighbours[6][3] = {{bx - 1, by, bz},
+              {bx + 1, by, bz},
+              {bx, by - 1, bz},
+              {bx, by + 1, bz},
+              {bx, by, bz - 1},
+              {bx, by, bz + 1}};
+          for (int n = 0; n < 6; n++) {
+            int nx = neighbours[n][0], ny = neighbours[n][1];
+            int nz = neighbours[n][2];
+            if (nx < 0 || ny < 0 || nz < 0 || nx >= CHUNK_WIDTH
+                || ny >= CHUNK_HEIGHT || nz >= CHUNK_LENGTH) {
+              continue;
+            }
+            size_t ni = CHUNK_INDEX(nx, ny, nz);
+            if (visited[ni]) { continue; }
+            visited[ni]        = 1;
+            stack[num_stack++] = (uint16_t)ni;
+          }
+        }
+
+        // Every pair of faces the region touches can see each other
+        for (int a = 0; a < NUM_FACES; a++) {
+          for (int b = a + 1; b < NUM_FACES; b++) {
+            if ((faces >> a & 1) && (faces >> b & 1)) {
+              visibility |= 1u << pair_bits[a][b];
+            }
+          }
+        }
+      }
+    }
+  }
+  free(visited);
+  free(stack);
+  return visibility;
+}
+
+// Step direction of each face
+static const int face_dirs[NUM_FACES][3] = {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+// Index of chunk coords in the walk's grid
+static inline uint32_t walk_cell(
+    const int c[3], const int min[3], const int size[3]) {
+  return (uint32_t)(c[0] - min[0])
+         + ((uint32_t)(c[1] - min[1]) + (uint32_t)(c[2] - min[2]) * size[1])
+               * size[0];
+}
+
+// Check if a chunk is fully outside any frustum plane. far holds each
+// plane's distance to the far corner of a chunk at the origin
+static bool chunk_outside(vec4 planes[6], const float far[6], const int c[3]) {
+  for (int p = 0; p < 6; p++) {
+    float d = planes[p][0] * c[0] * CHUNK_WIDTH
+              + planes[p][1] * c[1] * CHUNK_HEIGHT
+              + planes[p][2] * c[2] * CHUNK_LENGTH + far[p];
+    if (d < 0) { return true; }
+  }
+  return false;
+}
+
+bool occlusion_walk(OcclusionWalk *walk, const int camera[3], const int min[3],
+    const int max[3], vec4 planes[6], OcclusionVisit visit, void *data) {
+  if (!walk || !camera || !min || !max || !visit) { return false; }
+  int size[3];
+  for (int i = 0; i < 3; i++) {
+    size[i] = max[i] - min[i] + 1;
+    if (size[i] <= 0 || camera[i] < min[i] || camera[i] > max[i]) {
+      return false;
+    }
+  }
+
+  size_t cells = (size_t)size[0] * size[1] * size[2];
+  if (cells > walk->alloced) {
+    uint8_t *new_grid = realloc(walk->grid, cells);
+    if (new_grid) { walk->grid = new_grid; }
+    OcclusionStep *new_steps = realloc(
+        walk->steps, sizeof(OcclusionStep) * cells);
+    if (new_steps) { walk->steps = new_steps; }
+    if (!new_grid || !new_steps) { return false; }
+    walk->alloced = cells;
+  }
+  memset(walk->grid, 0, cells);
+
+  const float chunk_size[3] = {CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_LENGTH};
+  float far[6];
+  for (int p = 0; planes && p < 6; p++) {
+    far[p] = planes[p][3];
+    for (int i = 0; i < 3; i++) {
+      if (planes[p][i] > 0) { far[p] += planes[p][i] * chunk_size[i]; }
+    }
+  }
+
+  // Breadth first, so each chunk is reached by its most direct path
+  size_t head = 0, tail = 0;
+  uint32_t start = walk_cell(camera, min, size);
+  walk->grid[start]   = 1;
+  walk->steps[tail++] = (OcclusionStep){start, NUM_FACES, 0};
+  while (head < tail) {
+    OcclusionStep step  = walk->steps[head++];
+    int c[3]            = {(int)(step.cell % size[0]) + min[0],
+        (int)(step.cell / size[0] % size[1]) + min[1],
+        (int)(step.cell / size[0] / size[1]) + min[2]};
+    uint16_t visibility = visit(data, c);
+
+    for (int f = 0; f < NUM_FACES; f++) {
+      // Never step back towards the camera, and only leave through faces
+      // that the way in can see
+      if (step.dirs & (1 << face_opposite(f))) { continue; }
+      if (step.face != NUM_FACES
+          && !visibility_connected(visibility, step.face, f)) {
+        continue;
+      }
+
+      int n[3] = {c[0] + face_dirs[f][0],
+          c[1] + face_dirs[f][1],
+          c[2] + face_dirs[f][2]};
+      if (n[0] < min[0] || n[1] < min[1] || n[2] < min[2] || n[0] > max[0]
+          || n[1] > max[1] || n[2] > max[2]) {
+        continue;
+      }
+      uint32_t cell = walk_cell(n, min, size);
+      if (walk->grid[cell]) { continue; }
+      // Don't walk through chunks that are out of view
+      if (planes && chunk_outside(planes, far, n)) { continue; }
+
+      walk->grid[cell]    = 1;
+      walk->steps[tail++] = (OcclusionStep){
+          cell, face_opposite(f), step.dirs | (1 << f)};
+    }
+  }
+  return true;
+}
+
+void occlusion_walk_free(OcclusionWalk *walk) {
+  if (!walk) { return; }
+  if (walk->grid) { free(walk->grid); }
+  if (walk->steps) { free(walk->steps); }
+  *walk = (OcclusionWalk){0};
+}
@@ -0,0 +1,67 @@
+#ifndef VISIBILITY_H
+
+#define VISIBILITY_H
+
+// Includes
+#include "block.h"
+#include "chunk.h"
+#include <cglm/cglm.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// One bit per pair of chunk faces, set if the faces are connected through air
+#define VISIBILITY_NONE 0
+#define VISIBILITY_ALL 0x7fff
+
+// Structs
+// Faces of a chunk
+typedef enum {
+  FACE_NEG_X,
+  FACE_POS_X,
+  FACE_NEG_Y,
+  FACE_POS_Y,
+  FACE_NEG_Z,
+  FACE_POS_Z,
+  NUM_FACES
+} ChunkFace;
+
+// A chunk the occlusion walk has reached, and how it got there
+typedef struct {
+  uint32_t cell;  // Index into the walk's grid
+  ChunkFace face; // Face the walk came in through, NUM_FACES at the start
+  uint8_t dirs;   // Directions stepped so far, one bit per face
+} OcclusionStep;
+
+// Scratch space for occlusion walks, kept between walks so they don't
+// allocate once it is big enough
+typedef struct {
+  uint8_t *grid;        // Chunks the walk has reached
+  OcclusionStep *steps; // Walk queue, one step per grid cell
+  size_t alloced;       // Cells in grid and steps
+} OcclusionWalk;
+
+// Called once for every chunk an occlusion walk reaches, returns the chunk's
+// visibility set. Chunks with nothing in them should return VISIBILITY_ALL
+typedef uint16_t (*OcclusionVisit)(void *data, const int coords[3]);
+
+// Function prototypes
+// Flood fill a chunk's air to find which of its faces can see each other
+uint16_t chunk_visibility(const Block *blocks);
+// Check if two faces are connected in a visibility set
+bool visibility_connected(uint16_t visibility, ChunkFace a, ChunkFace b);
+// Walk outwards from the camera's chunk, only passing between chunks through
+// faces their air connects, and only stepping away from the camera. Chunks
+// the walk never reaches are hidden behind terrain. The walk stays inside an
+// inclusive box of chunk coords, and inside the frustum unless planes is NULL.
+// Returns false if the camera is outside the box or allocation failed, then
+// nothing was visited
+bool occlusion_walk(OcclusionWalk *walk, const int camera[3], const int min[3],
+    const int max[3], vec4 planes[6], OcclusionVisit visit, void *data);
+// Free a walk's scratch space
+void occlusion_walk_free(OcclusionWalk *walk);
+// Get the face on the other side of a chunk
+static inline ChunkFace face_opposite(ChunkFace face) {
+  return (ChunkFace)(face ^ 1);
+}
+
+#endif // visibility.h
@@ -1,11 +1,25 @@
 #include "world.h"
-#include "player.h"
+#include "decoration.h"
+#include "save.h"
 #include <pthread.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 static void world_load_chunks(World *world);
+static uint8_t world_chunk_lod(
+    const World *world, int x, int y, int z, uint8_t current);
 static ChunkNode *hashmap_get(World *world, int x, int y, int z);
+static Chunk *world_pin_chunk(World *world, int x, int y, int z);
+static void world_unpin_chunk(Chunk *chunk);
+static bool world_queue_chunk(World *world, int x, int y, int z);
+static void world_distribute_spill(World *world, Chunk *chunk, EditList *spill);
+static void world_apply_pending(World *world, Chunk *chunk);
+static void world_free_pending(World *world, bool prune_only);
+static bool world_process_item(World *world, QueueItem item);
+static bool world_mesh_chunk(World *world, Chunk *chunk, double edit_time);
 bool world_update_queue(World *world);
+static bool world_help_carve(World *world);
 
 static inline void world_lock_bucket(World *world, size_t bucket) {
   if (!world || bucket >= HASHMAP_SIZE) { return; }
@@ -27,67 +41,90 @@ static inline void world_unlock_queue(World *world) {
   pthread_mutex_unlock(&world->queue_mutex);
 }
 
+// Check if a carve has slices left to take
+static inline bool carve_job_open(CarveJob *job) {
+  return job && atomic_load(&job->next) < job->chunks.num_items;
+}
+
+// Sleep for up to a millisecond, waking early if a carve starts
+static void world_idle_wait(World *world) {
+  struct timespec until;
+  clock_gettime(CLOCK_REALTIME, &until);
+  until.tv_nsec += 1000000;
+  if (until.tv_nsec >= 1000000000) {
+    until.tv_sec++;
+    until.tv_nsec -= 1000000000;
+  }
+  pthread_mutex_lock(&world->carve_mutex);
+  if (!carve_job_open(world->carve) && !world->kill) {
+    pthread_cond_timedwait(&world->carve_cond, &world->carve_mutex, &until);
+  }
+  pthread_mutex_unlock(&world->carve_mutex);
+}
+
 void *thread_routine(void *arg) {
   World *world = (World *)arg;
   if (!world) { return NULL; }
   while (!world->kill) {
-    world_update_queue(world);
-    usleep(1000); // Without this, theres a weird slowdown when breaking or
-                  // placing blocks.
+    // Carves are waited on by the thread that started them, so come first
+    if (world_help_carve(world)) { continue; }
+    // Only sleep when there was nothing to do. Without this, theres a weird
+    // slowdown when breaking or placing blocks.
+    if (!world_update_queue(world)) { world_idle_wait(world); }
   }
   return NULL;
 }
 
-World *create_world(uint32_t world_seed) {
-  // Create the world's shader program
-  nu_Program *program = nu_create_program(
-      2, "shaders/block.vert", "shaders/block.frag");
-  if (!program) {
+World *create_world_headless(uint32_t world_seed, size_t num_threads) {
+  // Allocate world
+  World *world = calloc(1, sizeof(World));
+  if (!world) {
     fprintf(stderr,
-        "(create_world): Error creating world, nu_create_program() "
-        "returned NULL.\n");
+        "(create_world_headless): Error creating world, calloc failed.\n");
     return NULL;
   }
-  nu_register_uniform(program, "uMVP", GL_FLOAT_MAT4);
-  nu_register_uniform(program, "uPlayerPos", GL_FLOAT_VEC3);
-  nu_register_uniform(program, "uRenderDistance", GL_FLOAT);
-
-  // Load the texture array for blocks
-  nu_Texture *block_textures = nu_load_texture_array(
-      NUM_BLOCK_TEXTURES, BLOCK_TEXTURES);
-  if (!block_textures) {
+  if (num_threads == 0) { num_threads = 1; }
+  world->chunk_threads = calloc(num_threads, sizeof(pthread_t));
+  if (!world->chunk_threads) {
     fprintf(stderr,
-        "(create_world): Error creating world, "
-        "nu_load_texture_array() returned NULL.\n");
-    nu_destroy_program(&program);
-    return NULL;
-  }
-
-  // Allocate world
-  World *world = calloc(1, sizeof(World));
-  if (!world) {
-    fprintf(stderr, "(create_world): Error creating world, calloc failed.\n");
-    nu_destroy_program(&program);
-    nu_destroy_texture(&block_textures);
+        "(create_world_headless): Error creating world, calloc failed.\n");
+    free(world);
     return NULL;
   }
 
   // Set members
-  world->program             = program;
-  world->block_textures      = block_textures;
+  world->program             = NULL;
+  world->block_textures      = NULL;
   world->queue.items         = NULL;
   world->queue.items_alloced = 0;
   world->queue.num_items     = 0;
-
-  for (size_t i = 0; i < NUM_THREADS; i++) {
-    pthread_create(&world->chunk_threads[i], NULL, thread_routine, (void *)world);
+  world->queue.num_active    = 0;
+  coord_set_init(&world->queue.queued);
+  world->mesh_chunks         = true;
+  world->save_dir            = NULL;
+  world->publish_meshes      = false;
+  world->lod_ring            = 0;
+  world->render_moved        = NULL;
+  world->render_free         = NULL;
+  if (!render_queue_init(&world->render_updates)) {
+    fprintf(stderr,
+        "(create_world_headless): Error creating world, "
+        "render_queue_init() failed.\n");
+    free(world->chunk_threads);
+    free(world);
+    return NULL;
   }
+
   // pthread_mutex_init(&world->hashmap_mutex, NULL);
   for (size_t i = 0; i < HASHMAP_SIZE; i++) {
     pthread_mutex_init(&world->map.bucket_mutexes[i], NULL);
   }
   pthread_mutex_init(&world->queue_mutex, NULL);
-  world->kill = false;
+  pthread_mutex_init(&world->pending.mutex, NULL);
+  pthread_mutex_init(&world->carve_mutex, NULL);
+  pthread_cond_init(&world->carve_cond, NULL);
+  world->carve = NULL;
+  world->kill  = false;
 
   // Set world centre and render distance
   world->cx   = 0;
@@ -97,28 +134,47 @@ World *create_world(uint32_t world_seed) {
   world->rdy  = RENDER_DISTANCE;
   world->rdz  = RENDER_DISTANCE;
   world->seed = world_seed;
-  // Queue initial chunks
-  world_load_chunks(world);
+
+  // Start threads once everything they use is initialised
+  world->num_threads = num_threads;
+  for (size_t i = 0; i < num_threads; i++) {
+    pthread_create(&world->chunk_threads[i], NULL, thread_routine, (void *)world);
+  }
 
   return world;
 }
 
+void world_stop(World *world) {
+  if (!world) { return; }
+  world->kill = true;
+  // Wake workers waiting for a carve so they see it
+  pthread_mutex_lock(&world->carve_mutex);
+  pthread_cond_broadcast(&world->carve_cond);
+  pthread_mutex_unlock(&world->carve_mutex);
+}
+
 void destroy_world(World **world) {
   if (!world || !(*world)) { return; }
   // Destroy rendering resources
-  nu_destroy_program(&(*world)->program);
-  nu_destroy_texture(&(*world)->block_textures);
+  if ((*world)->render_free) { (*world)->render_free(*world); }
 
   // Stop thread on world destroyed
-  (*world)->kill = true;
-  for (size_t i = 0; i < NUM_THREADS; i++) {
+  world_stop(*world);
+  for (size_t i = 0; i < (*world)->num_threads; i++) {
     pthread_join((*world)->chunk_threads[i], NULL);
   }
+  free((*world)->chunk_threads);
   // pthread_mutex_destroy(&(*world)->hashmap_mutex);
   for (size_t i = 0; i < HASHMAP_SIZE; i++) {
     pthread_mutex_destroy(&(*world)->map.bucket_mutexes[i]);
   }
   pthread_mutex_destroy(&(*world)->queue_mutex);
+  pthread_mutex_destroy(&(*world)->carve_mutex);
+  pthread_cond_destroy(&(*world)->carve_cond);
+
+  // Free pending decoration edits
+  world_free_pending(*world, false);
+  pthread_mutex_destroy(&(*world)->pending.mutex);
 
   // Destroy every loaded chunk
   for (size_t i = 0; i < HASHMAP_SIZE; i++) {
@@ -133,16 +189,26 @@ void destroy_world(World **world) {
 
   // Free queue
   if ((*world)->queue.items) { free((*world)->queue.items); }
+  coord_set_free(&(*world)->queue.queued);
+
+  // Free meshes that were never drained
+  render_queue_free(&(*world)->render_updates);
 
   free(*world);
   *world = NULL;
   return;
 }
 
-// Append a list of chunk coordinates to the queue
+// Append a chunk's coordinates to the queue. A chunk that is already queued
+// isn't added again, the one item covers every request until it is popped
 static bool world_queue_chunk(World *world, int x, int y, int z) {
   if (!world) { return false; }
   world_lock_queue(world);
+  if (coord_set_contains(&world->queue.queued, x, y, z)) {
+    world->queue.num_coalesced++;
+    world_unlock_queue(world);
+    return true;
+  }
   // If not allocated, allocate
   if (!world->queue.items || world->queue.items_alloced == 0) {
     if (world->queue.items) { free(world->queue.items); }
@@ -164,8 +230,13 @@ static bool world_queue_chunk(World *world, int x, int y, int z) {
   }
 
   // Append queue item
+  if (!coord_set_insert(&world->queue.queued, x, y, z)) {
+    world_unlock_queue(world);
+    return false;
+  }
   world->queue.items[world->queue.num_items++] = (QueueItem){
       .x = x, .y = y, .z = z};
+  world->queue.num_pushed++;
   world_unlock_queue(world);
 
   return true;
@@ -218,85 +289,312 @@ item = world->queue.items[--world->queue.num_items];
   }
   QueueItem item              = world->queue.items[min_idx];
   world->queue.items[min_idx] = world->queue.items[--world->queue.num_items];
+  // Requests from here on need a new item, this one may already be too late
+  coord_set_remove(&world->queue.queued, item.x, item.y, item.z);
+  world->queue.num_active++;
+  world_unlock_queue(world);
+
+  bool success = world_process_item(world, item);
+
+  world_lock_queue(world);
+  world->queue.num_active--;
   world_unlock_queue(world);
+  return success;
+}
+
+// Generate + mesh the chunk a queue item points to
+static bool world_process_item(World *world, QueueItem item) {
+  // If chunk is not loaded, exit early. The pin keeps it alive if the sim
+  // thread unloads it meanwhile
+  Chunk *chunk = world_pin_chunk(world, item.x, item.y, item.z);
+  if (!chunk) { return false; }
+
+  // Load the chunk if it was saved, otherwise generate it, keeping any
+  // decorations that crossed its border
+  EditList spill = {0};
+  lock_chunk(chunk);
+  bool fresh = chunk->state == STATE_EMPTY;
+  if (fresh && world->save_dir) {
+    chunk_load(chunk, world->seed, world->save_dir);
+  }
+  generate_chunk(chunk, world->seed, &spill);
+  bool decorated = fresh && chunk->gen_stage == GEN_STAGE_DECORATED;
+  unlock_chunk(chunk);
 
-  // If chunk is not loaded, exit early
-  ChunkNode *node = hashmap_get(world, item.x, item.y, item.z);
-  if (!node) { return false; }
-  Chunk *chunk = node->chunk;
-  if (!chunk) {
-    return false; // This should never happen
+  // Hand the spill to the neighbours it landed in, and pick up anything the
+  // neighbours left for this chunk. A loaded chunk has no spill, but may have
+  // been saved before a neighbour's decorations reached it
+  if (decorated) {
+    world_distribute_spill(world, chunk, &spill);
+    world_apply_pending(world, chunk);
   }
+  edit_list_free(&spill);
+
+  if (world->mesh_chunks) { world_mesh_chunk(world, chunk, 0.0); }
+  world_unpin_chunk(chunk);
+  return true;
+}
 
-  // Mesh and generate the chunk
+// Mesh a copy of a chunk's blocks and hand the mesh to the render thread. The
+// chunk lock is only held to take the copy and to publish, so edits and block
+// reads never wait for the mesher, and the renderer keeps drawing the old mesh
+// until the new one replaces it. The caller must hold a pin on the chunk.
+// Returns true if the mesh was handed over
+static bool world_mesh_chunk(World *world, Chunk *chunk, double edit_time) {
   lock_chunk(chunk);
-  generate_chunk(chunk, world->seed);
-  mesh_chunk(chunk);
+  if (chunk->state != STATE_NEEDS_MESH || !chunk->blocks || chunk->orphaned) {
+    unlock_chunk(chunk);
+    return false;
+  }
+  Block *blocks = malloc(sizeof(Block) * CHUNK_VOLUME);
+  if (!blocks) {
+    unlock_chunk(chunk);
+    fprintf(stderr,
+        "(world_mesh_chunk): Couldn't mesh chunk at (%d, %d, %d), malloc "
+        "failed.\n",
+        chunk->coords[0],
+        chunk->coords[1],
+        chunk->coords[2]);
+    return false;
+  }
+  memcpy(blocks, chunk->blocks, sizeof(Block) * CHUNK_VOLUME);
+  uint32_t revision = chunk->revision;
+  uint8_t lod       = chunk->lod;
+  chunk->state      = STATE_MESHING;
+  chunk->pins++;
   unlock_chunk(chunk);
+
+  ChunkMesh mesh = {0};
+  bool meshed    = mesh_blocks(blocks, chunk->coords, lod, &mesh);
+  free(blocks);
+
+  // The update is queued under the chunk lock, so it always lands before the
+  // chunk's retire. If the blocks changed meanwhile the mesh is stale, and the
+  // change has already queued the chunk again. When the queue is full the
+  // lock is dropped while the render thread drains it, until the world stops
+  RenderUpdate update = {
+      .coords       = {chunk->coords[0], chunk->coords[1], chunk->coords[2]},
+      .vertices     = mesh.vertices,
+      .num_vertices = mesh.num_vertices,
+      .visibility   = mesh.visibility,
+      .lod          = lod,
+      .retire       = false,
+      .edit_time    = edit_time,
+  };
+  memcpy(update.face_vertices,
+      mesh.face_vertices,
+      sizeof(update.face_vertices));
+  for (;;) {
+    lock_chunk(chunk);
+    // An orphan's retire is already queued, so its mesh must not follow it
+    bool current = chunk->revision == revision && !chunk->orphaned;
+    if (!meshed || !current || world->kill) {
+      if (current) { chunk->state = STATE_NEEDS_MESH; }
+      unlock_chunk(chunk);
+      if (mesh.vertices) { free(mesh.vertices); }
+      world_unpin_chunk(chunk);
+      return false;
+    }
+    if (!world->publish_meshes) {
+      // Keep the mesh on the chunk for whoever is reading it
+      if (chunk->vertices) { free(chunk->vertices); }
+      chunk->vertices     = mesh.vertices;
+      chunk->num_vertices = mesh.num_vertices;
+      memcpy(chunk->face_vertices,
+          mesh.face_vertices,
+          sizeof(chunk->face_vertices));
+      chunk->state = STATE_NEEDS_SEND;
+      break;
+    }
+    if (render_queue_push(&world->render_updates, update)) {
+      chunk->state = STATE_DONE;
+      break;
+    }
+    unlock_chunk(chunk);
+    usleep(1000);
+  }
+  chunk->visibility = mesh.visibility;
+  unlock_chunk(chunk);
+  world_unpin_chunk(chunk);
   return true;
 }
 
-// Render every loaded chunk, and send meshed chunks to GPU
-void render_world(World *world, void *p, float aspect) {
-  if (!world || !p) { return; }
+static inline int floor_div(int a, int b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
 
-  Player *player = (Player *)p;
-  nu_set_uniform(world->program, "uPlayerPos", player->position);
-  float render_dist = world->rdx * CHUNK_WIDTH;
-  nu_set_uniform(world->program, "uRenderDistance", &render_dist);
+static inline uint32_t pending_bucket(int x, int y, int z) {
+  return ((uint32_t)(x * 73856093) ^ (y * 19349663) ^ (z * 83492791))
+         % PENDING_MAP_SIZE;
+}
 
-  // Set OpenGL parameters
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_CULL_FACE);
+// Find the pending node for a chunk, creating it if asked to. The pending
+// mutex must be held
+static PendingNode *pending_get(World *world, int x, int y, int z, bool create) {
+  uint32_t bucket   = pending_bucket(x, y, z);
+  PendingNode *node = world->pending.buckets[bucket];
+  while (node) {
+    if (node->x == x && node->y == y && node->z == z) { return node; }
+    node = node->next;
+  }
+  if (!create) { return NULL; }
 
-  // Get camera's VP matrix
-  mat4 vp;
-  camera_calculate_vp_matrix(player->camera, vp, aspect);
+  node = calloc(1, sizeof(PendingNode));
+  if (!node) { return NULL; }
+  node->x                        = x;
+  node->y                        = y;
+  node->z                        = z;
+  node->next                     = world->pending.buckets[bucket];
+  world->pending.buckets[bucket] = node;
+  return node;
+}
 
-  // Calculate frustum planes for frustum culling
-  vec4 planes[6] = {0};
-  glm_frustum_planes(vp, planes);
+static void pending_destroy_node(PendingNode *node) {
+  edit_list_free(&node->edits);
+  if (node->sources) { free(node->sources); }
+  free(node);
+}
 
-  // Use world's program shader and send vp matrix
-  nu_use_program(world->program);
-  nu_set_uniform(world->program, "uMVP", &vp[0][0]);
-  nu_bind_texture(world->block_textures, 0);
+// Record that a chunk has contributed to a pending node. Returns false if it
+// already had, so a regenerated chunk doesn't add its edits twice
+static bool pending_add_source(PendingNode *node, const int coords[3]) {
+  for (size_t i = 0; i < node->num_sources; i++) {
+    if (node->sources[i][0] == coords[0] && node->sources[i][1] == coords[1]
+        && node->sources[i][2] == coords[2]) {
+      return false;
+    }
+  }
+  if (node->num_sources >= node->sources_alloced) {
+    size_t new_alloced = node->sources_alloced ? node->sources_alloced * 2 : 4;
+    int(*new_sources)[3] = realloc(
+        node->sources, sizeof(*node->sources) * new_alloced);
+    if (!new_sources) { return false; }
+    node->sources         = new_sources;
+    node->sources_alloced = new_alloced;
+  }
+  node->sources[node->num_sources][0] = coords[0];
+  node->sources[node->num_sources][1] = coords[1];
+  node->sources[node->num_sources][2] = coords[2];
+  node->num_sources++;
+  return true;
+}
 
-  for (size_t i = 0; i < HASHMAP_SIZE; i++) {
-    world_lock_bucket(world, i);
-    ChunkNode *node = world->map.buckets[i];
-    while (node) {
-      ChunkNode *next = node->next;
-      Chunk *chunk    = node->chunk;
-      if (chunk && chunk->mesh) {
-        lock_chunk(chunk);
-        ChunkState state = chunk->state;
-        // If the chunk needs to be sent, send it
-        if (state == STATE_NEEDS_SEND) {
-          nu_send_mesh(chunk->mesh);
-          nu_free_mesh(chunk->mesh);
-          chunk->state = STATE_DONE;
-        }
+// Store a freshly decorated chunk's out of bounds edits against the chunks
+// they landed in. Targets that are already decorated get the edits applied
+// straight away and are remeshed, they are never regenerated
+static void world_distribute_spill(World *world, Chunk *chunk, EditList *spill) {
+  if (!world || !chunk || !spill || spill->num_edits == 0) { return; }
+
+  // Find every chunk the spill touches (at most the 26 neighbours)
+  int targets[27][3];
+  size_t num_targets = 0;
+  for (size_t i = 0; i < spill->num_edits; i++) {
+    int tx     = floor_div(spill->edits[i].x, CHUNK_WIDTH);
+    int ty     = floor_div(spill->edits[i].y, CHUNK_HEIGHT);
+    int tz     = floor_div(spill->edits[i].z, CHUNK_LENGTH);
+    bool found = false;
+    for (size_t j = 0; j < num_targets && !found; j++) {
+      found = targets[j][0] == tx && targets[j][1] == ty && targets[j][2] == tz;
+    }
+    if (!found && num_targets < 27) {
+      targets[num_targets][0] = tx;
+      targets[num_targets][1] = ty;
+      targets[num_targets][2] = tz;
+      num_targets++;
+    }
+  }
 
-        // Frustum culling
-        int visible = 1;
+  int remesh[27][3];
+  size_t num_remesh = 0;
+  pthread_mutex_lock(&world->pending.mutex);
+  for (size_t t = 0; t < num_targets; t++) {
+    int tx            = targets[t][0];
+    int ty            = targets[t][1];
+    int tz            = targets[t][2];
+    PendingNode *node = pending_get(world, tx, ty, tz, true);
+    if (!node || !pending_add_source(node, chunk->coords)) { continue; }
+
+    // Move this target's edits into its pending node
+    size_t first = node->edits.num_edits;
+    for (size_t i = 0; i < spill->num_edits; i++) {
+      BlockEdit edit = spill->edits[i];
+      if (floor_div(edit.x, CHUNK_WIDTH) == tx
+          && floor_div(edit.y, CHUNK_HEIGHT) == ty
+          && floor_div(edit.z, CHUNK_LENGTH) == tz) {
+        edit_list_push(&node->edits, edit);
+      }
+    }
 
-        float ccx = chunk->coords[0] * CHUNK_WIDTH;
-        float ccy = chunk->coords[1] * CHUNK_HEIGHT;
-        float ccz = chunk->coords[2] * CHUNK_LENGTH;
+    // If the target is already decorated it won't read its pending node
+    // again, so apply the new edits now
+    Chunk *target = world_pin_chunk(world, tx, ty, tz);
+    if (!target) { continue; }
+    lock_chunk(target);
+    if (target->gen_stage == GEN_STAGE_DECORATED) {
+      EditList added = {
+          .edits     = node->edits.edits + first,
+          .num_edits = node->edits.num_edits - first,
+      };
+      if (decoration_apply_edits(target, &added) > 0) {
+        chunk_invalidate_mesh(target);
+        remesh[num_remesh][0]   = tx;
+        remesh[num_remesh][1]   = ty;
+        remesh[num_remesh++][2] = tz;
+      }
+    }
+    unlock_chunk(target);
+    world_unpin_chunk(target);
+  }
+  pthread_mutex_unlock(&world->pending.mutex);
 
-        vec3 box[2] = {{ccx, ccy, ccz},
-            {ccx + CHUNK_WIDTH, ccy + CHUNK_HEIGHT, ccz + CHUNK_LENGTH}};
-        if (!glm_aabb_frustum(box, planes)) visible = 0;
+  for (size_t i = 0; i < num_remesh; i++) {
+    world_queue_chunk(world, remesh[i][0], remesh[i][1], remesh[i][2]);
+  }
+}
 
-        // Render
-        if (visible) nu_render_mesh(chunk->mesh);
-        unlock_chunk(chunk);
+// Apply the edits neighbours have left for a freshly decorated chunk
+static void world_apply_pending(World *world, Chunk *chunk) {
+  if (!world || !chunk) { return; }
+  pthread_mutex_lock(&world->pending.mutex);
+  PendingNode *node = pending_get(
+      world, chunk->coords[0], chunk->coords[1], chunk->coords[2], false);
+  if (node) {
+    lock_chunk(chunk);
+    decoration_apply_edits(chunk, &node->edits);
+    unlock_chunk(chunk);
+  }
+  pthread_mutex_unlock(&world->pending.mutex);
+}
+
+// Free pending nodes. With prune_only, only nodes for chunks that can no
+// longer have a loaded neighbour are freed, the rest are kept so a chunk that
+// reloads gets its neighbours' decorations back
+static void world_free_pending(World *world, bool prune_only) {
+  if (!world) { return; }
+  pthread_mutex_lock(&world->pending.mutex);
+  for (size_t i = 0; i < PENDING_MAP_SIZE; i++) {
+    PendingNode *node = world->pending.buckets[i];
+    PendingNode *prev = NULL;
+    while (node) {
+      PendingNode *next = node->next;
+      int dx            = abs(node->x - world->cx);
+      int dy            = abs(node->y - world->cy);
+      int dz            = abs(node->z - world->cz);
+      if (!prune_only || dx > (int)world->rdx + 1 || dy > (int)world->rdy + 1
+          || dz > (int)world->rdz + 1) {
+        if (prev) {
+          prev->next = next;
+        } else {
+          world->pending.buckets[i] = next;
+        }
+        pending_destroy_node(node);
+      } else {
+        prev = node;
       }
       node = next;
     }
-    world_unlock_bucket(world, i);
   }
+  pthread_mutex_unlock(&world->pending.mutex);
 }
 
 static inline uint32_t hash_chunk_coords(int x, int y, int z) {
@@ -326,6 +624,37 @@ static ChunkNode *hashmap_get(World *world, int x, int y, int z) {
   return NULL;
 }
 
+// Pin a chunk so it can be used outside its bucket lock, NULL if it isn't
+// loaded. Unloading a pinned chunk leaves it for the last unpin to free
+static Chunk *world_pin_chunk(World *world, int x, int y, int z) {
+  if (!world) { return NULL; }
+  uint32_t bucket = get_bucket(x, y, z);
+  world_lock_bucket(world, bucket);
+  Chunk *chunk = NULL;
+  for (ChunkNode *node = world->map.buckets[bucket]; node; node = node->next) {
+    if (node->x == x && node->y == y && node->z == z) {
+      chunk = node->chunk;
+      break;
+    }
+  }
+  if (chunk) {
+    lock_chunk(chunk);
+    chunk->pins++;
+    unlock_chunk(chunk);
+  }
+  world_unlock_bucket(world, bucket);
+  return chunk;
+}
+
+// Drop a pin taken on a chunk. If the chunk was unloaded while pinned, the
+// last pin frees it
+static void world_unpin_chunk(Chunk *chunk) {
+  lock_chunk(chunk);
+  bool last = --chunk->pins == 0 && chunk->orphaned;
+  unlock_chunk(chunk);
+  if (last) { destroy_chunk(&chunk); }
+}
+
 /*
 static void hashmap_remove(World *world, int x, int y, int z) {
   if (!world) return;
@@ -393,17 +722,16 @@ static void hashmap_append(World *world, Chunk *chunk) {
   world_unlock_bucket(world, bucket);
 }
 
-// Create chunks that are in render distance, if not already loaded
-static void world_load_chunks(World *world) {
+void world_load_box(
+    World *world, int x0, int y0, int z0, int x1, int y1, int z1) {
   if (!world) { return; }
-  for (int x = (int)-world->rdx; x <= (int)world->rdx; x++) {
-    for (int y = (int)-world->rdy; y <= (int)world->rdy; y++) {
-      for (int z = (int)-world->rdz; z <= (int)world->rdz; z++) {
-        int gx = world->cx + x;
-        int gy = world->cy + y;
-        int gz = world->cz + z;
+  for (int gx = x0; gx <= x1; gx++) {
+    for (int gy = y0; gy <= y1; gy++) {
+      for (int gz = z0; gz <= z1; gz++) {
         if (!hashmap_get(world, gx, gy, gz)) {
           Chunk *chunk = create_chunk(gx, gy, gz);
+          if (!chunk) { continue; }
+          chunk->lod = world_chunk_lod(world, gx, gy, gz, CHUNK_LOD_LEVELS);
           if (world_queue_chunk(world, gx, gy, gz)) {
             hashmap_append(world, chunk);
           } else {
@@ -415,6 +743,54 @@ static void world_load_chunks(World *world) {
   }
 }
 
+// Create chunks that are in render distance, if not already loaded
+static void world_load_chunks(World *world) {
+  if (!world) { return; }
+  world_load_box(world,
+      world->cx - (int)world->rdx,
+      world->cy - (int)world->rdy,
+      world->cz - (int)world->rdz,
+      world->cx + (int)world->rdx,
+      world->cy + (int)world->rdy,
+      world->cz + (int)world->rdz);
+}
+
+bool world_is_idle(World *world) {
+  if (!world) { return true; }
+  world_lock_queue(world);
+  bool idle = world->queue.num_items == 0 && world->queue.num_active == 0;
+  world_unlock_queue(world);
+  return idle;
+}
+
+WorldStats world_get_stats(World *world) {
+  WorldStats stats = {0};
+  if (!world) { return stats; }
+  world_lock_queue(world);
+  stats.queue_depth   = world->queue.num_items;
+  stats.queue_active  = world->queue.num_active;
+  stats.num_pushed    = world->queue.num_pushed;
+  stats.num_coalesced = world->queue.num_coalesced;
+  world_unlock_queue(world);
+  return stats;
+}
+
+size_t world_save(World *world, const char *dir) {
+  if (!world || !dir) { return 0; }
+  size_t count = 0;
+  for (size_t i = 0; i < HASHMAP_SIZE; i++) {
+    world_lock_bucket(world, i);
+    for (ChunkNode *node = world->map.buckets[i]; node; node = node->next) {
+      if (!node->chunk) { continue; }
+      lock_chunk(node->chunk);
+      if (chunk_save(node->chunk, world->seed, dir)) { count++; }
+      unlock_chunk(node->chunk);
+    }
+    world_unlock_bucket(world, i);
+  }
+  return count;
+}
+
 // Destroy chunks that are out of render distance
 static void world_unload_chunks(World *world) {
   if (!world) { return; }
@@ -437,10 +813,28 @@ static void world_unload_chunks(World *world) {
             world->map.buckets[i] = next;
           }
 
-          destroy_chunk(&node->chunk);
+          // A chunk still pinned by a worker is left for its last unpin
+          int coords[3] = {node->x, node->y, node->z};
+          lock_chunk(node->chunk);
+          bool pinned           = node->chunk->pins > 0;
+          node->chunk->orphaned = pinned;
+          unlock_chunk(node->chunk);
+          if (!pinned) { destroy_chunk(&node->chunk); }
           free(node);
           node = next;
           count++;
+
+          // Drop its mesh. If the queue is full, wait for the render thread
+          // to drain it, it never takes a bucket lock so it can't be stuck
+          // behind this one. Once the world is stopping nothing drains it
+          RenderUpdate retire = {
+              .coords = {coords[0], coords[1], coords[2]},
+              .retire = true,
+          };
+          while (world->publish_meshes && !world->kill
+                 && !render_queue_push(&world->render_updates, retire)) {
+            usleep(1000);
+          }
           continue;
         }
       }
@@ -449,6 +843,62 @@ static void world_unload_chunks(World *world) {
     }
     world_unlock_bucket(world, i);
   }
+
+  // Drop decoration edits for chunks that have moved out of range
+  world_free_pending(world, true);
+}
+
+// Find the level of detail a chunk should be meshed at, given the level it is
+// at now, or CHUNK_LOD_LEVELS for a new chunk
+static uint8_t world_chunk_lod(
+    const World *world, int x, int y, int z, uint8_t current) {
+  if (!world || world->lod_ring == 0) { return 0; }
+  int dx   = abs(x - world->cx);
+  int dy   = abs(y - world->cy);
+  int dz   = abs(z - world->cz);
+  int dist = dx > dy ? dx : dy;
+  dist     = dist > dz ? dist : dz;
+
+  // Rings end at lod_ring, 2 * lod_ring, 4 * lod_ring...
+  uint8_t lod = 0, lod_past = 0;
+  int ring    = (int)world->lod_ring;
+  for (uint8_t level = 1; level < CHUNK_LOD_LEVELS; level++, ring *= 2) {
+    if (dist > ring) { lod = level; }
+    if (dist - LOD_HYSTERESIS > ring) { lod_past = level; }
+  }
+  // Gain detail straight away, but only lose it once well past the ring
+  if (lod > current) { return lod_past > current ? lod_past : current; }
+  return lod;
+}
+
+// Move chunks between levels of detail after the centre moves, remeshing any
+// that were already meshed
+static void world_update_lods(World *world) {
+  if (!world || world->lod_ring == 0) { return; }
+  for (size_t i = 0; i < HASHMAP_SIZE; i++) {
+    world_lock_bucket(world, i);
+    for (ChunkNode *node = world->map.buckets[i]; node; node = node->next) {
+      Chunk *chunk = node->chunk;
+      if (!chunk) { continue; }
+      lock_chunk(chunk);
+      uint8_t lod = world_chunk_lod(
+          world, node->x, node->y, node->z, chunk->lod);
+      bool remesh = false;
+      if (lod != chunk->lod) {
+        chunk->lod = lod;
+        // Chunks that haven't been meshed yet will pick up the new level,
+        // and a mesh being made at the old level is dropped
+        if (chunk->state != STATE_EMPTY
+            && chunk->state != STATE_NEEDS_MESH) {
+          chunk_invalidate_mesh(chunk);
+          remesh = true;
+        }
+      }
+      unlock_chunk(chunk);
+      if (remesh) { world_queue_chunk(world, node->x, node->y, node->z); }
+    }
+    world_unlock_bucket(world, i);
+  }
 }
 
 // Update the position that chunks load around
@@ -460,18 +910,16 @@ void world_update_centre(World *world, int nx, int ny, int nz) {
   world->cz = nz;
   world_load_chunks(world);
   world_unload_chunks(world);
+  world_update_lods(world);
+  if (world->render_moved) { world->render_moved(world); }
 }
 
 Chunk *world_get_chunk(World *world, int x, int y, int z) {
   if (!world) { return NULL; }
-  int cx          = (int)floorf((float)x / (float)CHUNK_WIDTH);
-  int cy          = (int)floorf((float)y / (float)CHUNK_HEIGHT);
-  int cz          = (int)floorf((float)z / (float)CHUNK_LENGTH);
-  ChunkNode *node = hashmap_get(world, cx, cy, cz);
+  ChunkNode *node = hashmap_get(
+      world, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
   if (!node) { return NULL; }
-  Chunk *chunk = node->chunk;
-  if (!chunk) { return NULL; }
-  return chunk;
+  return node->chunk;
 }
 
 Chunk *world_get_chunkf(World *world, float x, float y, float z) {
@@ -482,44 +930,561 @@ Chunk *world_get_chunkf(World *world, float x, float y, float z) {
 }
 
 Block *world_get_block(World *world, int x, int y, int z) {
-  if (!world) { return NULL; }
-  int cx          = (int)floorf((float)x / (float)CHUNK_WIDTH);
-  int cy          = (int)floorf((float)y / (float)CHUNK_HEIGHT);
-  int cz          = (int)floorf((float)z / (float)CHUNK_LENGTH);
-  ChunkNode *node = hashmap_get(world, cx, cy, cz);
-  if (!node) { return NULL; }
-  Chunk *chunk = node->chunk;
+  Chunk *chunk = world_get_chunk(world, x, y, z);
   if (!chunk) { return NULL; }
-  size_t ccx = x - (cx * CHUNK_WIDTH);
-  size_t ccy = y - (cy * CHUNK_HEIGHT);
-  size_t ccz = z - (cz * CHUNK_LENGTH);
   lock_chunk(chunk);
-  Block *block = chunk_get_block(chunk, ccx, ccy, ccz);
+  Block *block = chunk_get_block(
+      chunk, x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
   unlock_chunk(chunk);
   return block;
 }
 
 void world_set_block(World *world, BlockType block, int x, int y, int z) {
-  if (!world) { return; }
-  int cx          = (int)floorf((float)x / (float)CHUNK_WIDTH);
-  int cy          = (int)floorf((float)y / (float)CHUNK_HEIGHT);
-  int cz          = (int)floorf((float)z / (float)CHUNK_LENGTH);
-  ChunkNode *node = hashmap_get(world, cx, cy, cz);
-  if (!node) { return; }
-  Chunk *chunk = node->chunk;
+  Chunk *chunk = world_pin_chunk(
+      world, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
   if (!chunk) { return; }
-  size_t ccx = x - (cx * CHUNK_WIDTH);
-  size_t ccy = y - (cy * CHUNK_HEIGHT);
-  size_t ccz = z - (cz * CHUNK_LENGTH);
   lock_chunk(chunk);
-  bool success = chunk_set_block(chunk, block, ccx, ccy, ccz);
+  bool success = chunk_set_block(
+      chunk, block, x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+  if (success) { chunk_invalidate_mesh(chunk); }
   unlock_chunk(chunk);
+  world_unpin_chunk(chunk);
   if (success) {
-    chunk->state = STATE_NEEDS_MESH;
-    world_queue_chunk(world, cx, cy, cz);
+    world_queue_chunk(world,
+        x >> CHUNK_SHIFT,
+        y >> CHUNK_SHIFT,
+        z >> CHUNK_SHIFT);
   }
 }
 
+void world_edit_block(
+    World *world, BlockType block, int x, int y, int z, double edit_time) {
+  Chunk *chunk = world_pin_chunk(
+      world, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+  if (!chunk) { return; }
+  lock_chunk(chunk);
+  bool success = chunk_set_block(
+      chunk, block, x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK);
+  if (success) { chunk_invalidate_mesh(chunk); }
+  unlock_chunk(chunk);
+  // Mesh it here rather than behind the queue. If a worker already has it, or
+  // meshing fails, the queue picks it up as usual
+  bool meshed = success && world->mesh_chunks
+                && world_mesh_chunk(world, chunk, edit_time);
+  world_unpin_chunk(chunk);
+  if (!success || meshed) { return; }
+  world_queue_chunk(world,
+      x >> CHUNK_SHIFT,
+      y >> CHUNK_SHIFT,
+      z >> CHUNK_SHIFT);
+}
+
+// Apply a box edit to every chunk it touches under one lock each, then queue
+// the chunks that changed for remeshing once each
+static size_t world_edit_region(World *world, BlockType block, bool match,
+    BlockType from, int x0, int y0, int z0, int x1, int y1, int z1) {
+  if (!world) { return 0; }
+  int lo[3] = {x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, z0 < z1 ? z0 : z1};
+  int hi[3] = {x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0, z0 < z1 ? z1 : z0};
+
+  size_t changed = 0;
+  for (int cx = lo[0] >> CHUNK_SHIFT; cx <= hi[0] >> CHUNK_SHIFT; cx++) {
+    for (int cy = lo[1] >> CHUNK_SHIFT; cy <= hi[1] >> CHUNK_SHIFT; cy++) {
+      for (int cz = lo[2] >> CHUNK_SHIFT; cz <= hi[2] >> CHUNK_SHIFT; cz++) {
+        Chunk *chunk = world_pin_chunk(world, cx, cy, cz);
+        if (!chunk) { continue; }
+        // The box in the chunk's local coords, chunk_fill_box() clamps it
+        int base[3] = {cx * CHUNK_WIDTH, cy * CHUNK_HEIGHT, cz * CHUNK_LENGTH};
+        int local_lo[3] = {lo[0] - base[0], lo[1] - base[1], lo[2] - base[2]};
+        int local_hi[3] = {hi[0] - base[0], hi[1] - base[1], hi[2] - base[2]};
+        size_t n        = 0;
+        lock_chunk(chunk);
+        if (match) {
+          n = chunk_replace_box(chunk, from, block, local_lo, local_hi);
+        } else {
+          n = chunk_fill_box(chunk, block, local_lo, local_hi);
+        }
+        if (n > 0) { chunk_invalidate_mesh(chunk); }
+        unlock_chunk(chunk);
+        world_unpin_chunk(chunk);
+        if (n > 0) { world_queue_chunk(world, cx, cy, cz); }
+        changed += n;
+      }
+    }
+  }
+  return changed;
+}
+
+size_t world_fill_region(World *world, BlockType block, int x0, int y0,
+    int z0, int x1, int y1, int z1) {
+  return world_edit_region(
+      world, block, false, BlockAir, x0, y0, z0, x1, y1, z1);
+}
+
+size_t world_replace_region(World *world, BlockType from, BlockType to,
+    int x0, int y0, int z0, int x1, int y1, int z1) {
+  if (from == to) { return 0; }
+  return world_edit_region(world, to, true, from, x0, y0, z0, x1, y1, z1);
+}
+
+// A chunk an edit list touches, and where its edits are in the grouped list
+typedef struct {
+  int x, y, z;
+  size_t start, count;
+} EditGroup;
+
+size_t world_apply_edit_list(World *world, const EditList *edits) {
+  if (!world || !edits || edits->num_edits == 0) { return 0; }
+  size_t num = edits->num_edits;
+  // Open addressing table from chunk coords to group, at most half full
+  size_t table_size = 2;
+  while (table_size < num * 2) { table_size *= 2; }
+  EditGroup *groups  = malloc(sizeof(EditGroup) * num);
+  uint32_t *group_of = malloc(sizeof(uint32_t) * num);
+  uint32_t *table    = malloc(sizeof(uint32_t) * table_size);
+  BlockEdit *grouped = malloc(sizeof(BlockEdit) * num);
+  size_t changed     = 0;
+  if (!groups || !group_of || !table || !grouped || num > UINT32_MAX) {
+    fprintf(stderr,
+        "(world_apply_edit_list): Error applying edits, malloc failed.\n");
+    goto cleanup;
+  }
+
+  // Find the chunk each edit is in, counting the edits per chunk
+  memset(table, 0xff, sizeof(uint32_t) * table_size);
+  size_t num_groups = 0;
+  for (size_t i = 0; i < num; i++) {
+    BlockEdit edit = edits->edits[i];
+    int x          = edit.x >> CHUNK_SHIFT;
+    int y          = edit.y >> CHUNK_SHIFT;
+    int z          = edit.z >> CHUNK_SHIFT;
+    size_t slot    = hash_chunk_coords(x, y, z) & (table_size - 1);
+    while (table[slot] != UINT32_MAX) {
+      EditGroup *group = &groups[table[slot]];
+      if (group->x == x && group->y == y && group->z == z) { break; }
+      slot = (slot + 1) & (table_size - 1);
+    }
+    if (table[slot] == UINT32_MAX) {
+      table[slot]          = (uint32_t)num_groups;
+      groups[num_groups++] = (EditGroup){.x = x, .y = y, .z = z};
+    }
+    group_of[i] = table[slot];
+    groups[table[slot]].count++;
+  }
+
+  // Lay each chunk's edits out together, keeping their order
+  size_t offset = 0;
+  for (size_t g = 0; g < num_groups; g++) {
+    groups[g].start = offset;
+    offset += groups[g].count;
+    groups[g].count = 0;
+  }
+  for (size_t i = 0; i < num; i++) {
+    EditGroup *group = &groups[group_of[i]];
+    grouped[group->start + group->count++] = edits->edits[i];
+  }
+
+  // Apply each chunk's edits under one lock
+  for (size_t g = 0; g < num_groups; g++) {
+    EditGroup group = groups[g];
+    Chunk *chunk    = world_pin_chunk(world, group.x, group.y, group.z);
+    if (!chunk) { continue; }
+    lock_chunk(chunk);
+    size_t n = chunk_apply_edits(chunk, grouped + group.start, group.count);
+    if (n > 0) { chunk_invalidate_mesh(chunk); }
+    unlock_chunk(chunk);
+    world_unpin_chunk(chunk);
+    if (n > 0) { world_queue_chunk(world, group.x, group.y, group.z); }
+    changed += n;
+  }
+
+cleanup:
+  if (groups) { free(groups); }
+  if (group_of) { free(group_of); }
+  if (table) { free(table); }
+  if (grouped) { free(grouped); }
+  return changed;
+}
+
+// Carves with a bounding box smaller than this many blocks aren't shared with
+// the workers, waking them costs more than they would save
+#define CARVE_SHARE_VOLUME (32 * 32 * 32)
+
+// Add a chunk to a list, returns false if allocation failed
+static bool chunk_list_push(ChunkList *list, Chunk *chunk) {
+  if (list->num_items >= list->items_alloced) {
+    size_t new_alloced = list->items_alloced ? list->items_alloced * 2 : 16;
+    Chunk **new_items  = realloc(list->items, sizeof(Chunk *) * new_alloced);
+    if (!new_items) { return false; }
+    list->items         = new_items;
+    list->items_alloced = new_alloced;
+  }
+  list->items[list->num_items++] = chunk;
+  return true;
+}
+
+// Find the inclusive range of chunk coords covering [min, max] in block
+// coords on one axis, kept inside int range. Returns false if it is empty
+static bool chunk_range(float min, float max, int *lo, int *hi) {
+  const float limit = (float)(INT_MAX >> CHUNK_SHIFT);
+  min               = floorf(min / CHUNK_WIDTH);
+  max               = floorf(max / CHUNK_WIDTH);
+  *lo               = min < -limit ? -(INT_MAX >> CHUNK_SHIFT) : (int)min;
+  *hi               = max > limit ? INT_MAX >> CHUNK_SHIFT : (int)max;
+  return *lo <= *hi;
+}
+
+// Carve slices until there are none left, returns the number taken
+static size_t carve_job_run(CarveJob *job) {
+  size_t taken = 0;
+  size_t i;
+  while ((i = atomic_fetch_add(&job->next, 1)) < job->chunks.num_items) {
+    Chunk *chunk = job->chunks.items[i];
+    lock_chunk(chunk);
+    size_t n = chunk_carve_capsule(chunk, job->a, job->b, job->radius);
+    if (n > 0) { chunk_invalidate_mesh(chunk); }
+    unlock_chunk(chunk);
+    job->changed[i] = n;
+    taken++;
+  }
+  return taken;
+}
+
+// Take slices of the world's carve if there is one, returns true if any were
+// taken
+static bool world_help_carve(World *world) {
+  pthread_mutex_lock(&world->carve_mutex);
+  CarveJob *job = carve_job_open(world->carve) ? world->carve : NULL;
+  if (job) { world->carve_helpers++; }
+  pthread_mutex_unlock(&world->carve_mutex);
+  if (!job) { return false; }
+  size_t taken = carve_job_run(job);
+  pthread_mutex_lock(&world->carve_mutex);
+  world->carve_helpers--;
+  pthread_cond_broadcast(&world->carve_cond);
+  pthread_mutex_unlock(&world->carve_mutex);
+  return taken > 0;
+}
+
+// Find and pin every loaded chunk overlapping an inclusive box of chunk
+// coords, release them with world_release_chunks(). Small boxes look each
+// chunk up, big ones walk the chunk map instead
+static bool world_collect_chunks(
+    World *world, const int lo[3], const int hi[3], ChunkList *list) {
+  double volume = 1.0;
+  for (int i = 0; i < 3; i++) { volume *= (double)hi[i] - lo[i] + 1.0; }
+  if (volume <= HASHMAP_SIZE) {
+    for (int cx = lo[0]; cx <= hi[0]; cx++) {
+      for (int cy = lo[1]; cy <= hi[1]; cy++) {
+        for (int cz = lo[2]; cz <= hi[2]; cz++) {
+          Chunk *chunk = world_pin_chunk(world, cx, cy, cz);
+          if (!chunk) { continue; }
+          if (!chunk_list_push(list, chunk)) {
+            world_unpin_chunk(chunk);
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  }
+  bool success = true;
+  for (size_t i = 0; i < HASHMAP_SIZE && success; i++) {
+    world_lock_bucket(world, i);
+    for (ChunkNode *node = world->map.buckets[i]; node; node = node->next) {
+      if (!node->chunk) { continue; }
+      if (node->x < lo[0] || node->y < lo[1] || node->z < lo[2]) { continue; }
+      if (node->x > hi[0] || node->y > hi[1] || node->z > hi[2]) { continue; }
+      if (!chunk_list_push(list, node->chunk)) {
+        success = false;
+        break;
+      }
+      lock_chunk(node->chunk);
+      node->chunk->pins++;
+      unlock_chunk(node->chunk);
+    }
+    world_unlock_bucket(world, i);
+  }
+  return success;
+}
+
+// Unpin and free a list of chunks from world_collect_chunks()
+static void world_release_chunks(ChunkList *list) {
+  for (size_t i = 0; i < list->num_items; i++) {
+    world_unpin_chunk(list->items[i]);
+  }
+  if (list->items) { free(list->items); }
+  *list = (ChunkList){0};
+}
+
+size_t world_carve_capsule(
+    World *world, const vec3 a, const vec3 b, float radius) {
+  if (!world || !a || !b || !(radius > 0.0f) || !isfinite(radius)) {
+    return 0;
+  }
+  CarveJob job  = {.radius = radius};
+  double volume = 1.0;
+  int lo[3], hi[3];
+  for (int i = 0; i < 3; i++) {
+    if (!isfinite(a[i]) || !isfinite(b[i])) { return 0; }
+    job.a[i] = a[i];
+    job.b[i] = b[i];
+    volume *= fabsf(a[i] - b[i]) + 2.0f * radius;
+    if (!chunk_range(fminf(a[i], b[i]) - radius, fmaxf(a[i], b[i]) + radius,
+            &lo[i], &hi[i])) {
+      return 0;
+    }
+  }
+  atomic_init(&job.next, 0);
+  size_t changed = 0;
+  if (!world_collect_chunks(world, lo, hi, &job.chunks)) {
+    fprintf(stderr, "(world_carve_capsule): Error carving, realloc failed.\n");
+    goto cleanup;
+  }
+  if (job.chunks.num_items == 0) { goto cleanup; }
+  job.changed = calloc(job.chunks.num_items, sizeof(size_t));
+  if (!job.changed) {
+    fprintf(stderr, "(world_carve_capsule): Error carving, calloc failed.\n");
+    goto cleanup;
+  }
+
+  // Let the workers help with big carves over more than one chunk, unless
+  // another carve already has them
+  bool shared = false;
+  if (job.chunks.num_items > 1 && volume >= CARVE_SHARE_VOLUME) {
+    pthread_mutex_lock(&world->carve_mutex);
+    if (!world->carve) {
+      world->carve = &job;
+      shared       = true;
+      pthread_cond_broadcast(&world->carve_cond);
+    }
+    pthread_mutex_unlock(&world->carve_mutex);
+  }
+  carve_job_run(&job);
+  if (shared) {
+    // Every slice has been taken, so once the workers let go of the job the
+    // slices they took are done too
+    pthread_mutex_lock(&world->carve_mutex);
+    world->carve = NULL;
+    while (world->carve_helpers > 0) {
+      pthread_cond_wait(&world->carve_cond, &world->carve_mutex);
+    }
+    pthread_mutex_unlock(&world->carve_mutex);
+  }
+
+  // One remesh per chunk that changed
+  for (size_t i = 0; i < job.chunks.num_items; i++) {
+    if (job.changed[i] == 0) { continue; }
+    const int *coords = job.chunks.items[i]->coords;
+    world_queue_chunk(world, coords[0], coords[1], coords[2]);
+    changed += job.changed[i];
+  }
+
+cleanup:
+  world_release_chunks(&job.chunks);
+  if (job.changed) { free(job.changed); }
+  return changed;
+}
+
+size_t world_carve_sphere(World *world, const vec3 centre, float radius) {
+  return world_carve_capsule(world, centre, centre, radius);
+}
+
+// A chunk a search may find its block in, and the squared distance from the
+// search's origin to the chunk's nearest block centre
+typedef struct {
+  Chunk *chunk;
+  float dist2;
+} SearchCandidate;
+
+static int search_candidate_cmp(const void *a, const void *b) {
+  float da = ((const SearchCandidate *)a)->dist2;
+  float db = ((const SearchCandidate *)b)->dist2;
+  return (da > db) - (da < db);
+}
+
+// Get the squared distance from a point to the nearest point of a box
+static inline float box_dist2(
+    const float p[3], const float lo[3], const float hi[3]) {
+  float d2 = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    float d = p[i] < lo[i] ? lo[i] - p[i] : (p[i] > hi[i] ? p[i] - hi[i] : 0);
+    d2 += d * d;
+  }
+  return d2;
+}
+
+// Get the local coords of a brick's minimum corner from its bit index
+static inline void brick_corner(int bit, int corner[3]) {
+  corner[0] = (bit / CHUNK_BRICKS % CHUNK_BRICKS) * CHUNK_BRICK;
+  corner[1] = (bit / (CHUNK_BRICKS * CHUNK_BRICKS)) * CHUNK_BRICK;
+  corner[2] = (bit % CHUNK_BRICKS) * CHUNK_BRICK;
+}
+
+bool world_find_nearest(World *world, BlockType type, const vec3 origin,
+    float radius, int out[3]) {
+  if (!world || !origin || !out || type >= CHUNK_BLOCK_TYPES) { return false; }
+  if (!(radius >= 0.0f) || !isfinite(radius)) { return false; }
+  int lo[3], hi[3];
+  for (int i = 0; i < 3; i++) {
+    if (!isfinite(origin[i])) { return false; }
+    if (!chunk_range(
+            origin[i] - radius, origin[i] + radius, &lo[i], &hi[i])) {
+      return false;
+    }
+  }
+  ChunkList chunks            = {0};
+  SearchCandidate *candidates = NULL;
+  bool found                  = false;
+  if (!world_collect_chunks(world, lo, hi, &chunks)) {
+    fprintf(stderr,
+        "(world_find_nearest): Error searching, realloc failed.\n");
+    goto cleanup;
+  }
+  if (chunks.num_items == 0) { goto cleanup; }
+  candidates = malloc(sizeof(SearchCandidate) * chunks.num_items);
+  if (!candidates) {
+    fprintf(stderr, "(world_find_nearest): Error searching, malloc failed.\n");
+    goto cleanup;
+  }
+
+  // Keep the chunks in range that hold the type, nearest first
+  float best        = radius * radius;
+  size_t num_chunks = 0;
+  for (size_t i = 0; i < chunks.num_items; i++) {
+    Chunk *chunk = chunks.items[i];
+    float min[3], max[3];
+    for (int j = 0; j < 3; j++) {
+      min[j] = (float)(chunk->coords[j] * CHUNK_WIDTH) + 0.5f;
+      max[j] = min[j] + (float)(CHUNK_WIDTH - 1);
+    }
+    float dist2 = box_dist2(origin, min, max);
+    if (dist2 > best) { continue; }
+    lock_chunk(chunk);
+    bool holds = chunk->type_counts[type] > 0;
+    unlock_chunk(chunk);
+    if (holds) {
+      candidates[num_chunks++] = (SearchCandidate){chunk, dist2};
+    }
+  }
+  qsort(candidates, num_chunks, sizeof(SearchCandidate), search_candidate_cmp);
+
+  // Search each chunk's bricks until the rest are further than the best find
+  for (size_t i = 0; i < num_chunks && candidates[i].dist2 <= best; i++) {
+    Chunk *chunk = candidates[i].chunk;
+    int base[3]  = {chunk->coords[0] * CHUNK_WIDTH,
+        chunk->coords[1] * CHUNK_HEIGHT,
+        chunk->coords[2] * CHUNK_LENGTH};
+    lock_chunk(chunk);
+    uint64_t bricks = chunk->blocks ? chunk->type_bricks[type] : 0;
+    for (; bricks; bricks &= bricks - 1) {
+      int corner[3];
+      brick_corner(__builtin_ctzll(bricks), corner);
+      float min[3], max[3];
+      for (int j = 0; j < 3; j++) {
+        min[j] = (float)(base[j] + corner[j]) + 0.5f;
+        max[j] = min[j] + (float)(CHUNK_BRICK - 1);
+      }
+      if (box_dist2(origin, min, max) > best) { continue; }
+      for (int y = corner[1]; y < corner[1] + CHUNK_BRICK; y++) {
+        for (int x = corner[0]; x < corner[0] + CHUNK_BRICK; x++) {
+          const Block *row = &chunk->blocks[CHUNK_INDEX(x, y, 0)];
+          for (int z = corner[2]; z < corner[2] + CHUNK_BRICK; z++) {
+            if (row[z].type != type) { continue; }
+            float dx = (float)(base[0] + x) + 0.5f - origin[0];
+            float dy = (float)(base[1] + y) + 0.5f - origin[1];
+            float dz = (float)(base[2] + z) + 0.5f - origin[2];
+            float d2 = dx * dx + dy * dy + dz * dz;
+            if (d2 > best || (found && d2 == best)) { continue; }
+            best   = d2;
+            found  = true;
+            out[0] = base[0] + x;
+            out[1] = base[1] + y;
+            out[2] = base[2] + z;
+          }
+        }
+      }
+    }
+    unlock_chunk(chunk);
+  }
+
+cleanup:
+  world_release_chunks(&chunks);
+  if (candidates) { free(candidates); }
+  return found;
+}
+
+size_t world_count_blocks(World *world, BlockType type, int x0, int y0, int z0,
+    int x1, int y1, int z1) {
+  if (!world || type >= CHUNK_BLOCK_TYPES) { return 0; }
+  int lo[3] = {x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, z0 < z1 ? z0 : z1};
+  int hi[3] = {x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0, z0 < z1 ? z1 : z0};
+  int clo[3], chi[3];
+  for (int i = 0; i < 3; i++) {
+    clo[i] = lo[i] >> CHUNK_SHIFT;
+    chi[i] = hi[i] >> CHUNK_SHIFT;
+  }
+  ChunkList chunks = {0};
+  if (!world_collect_chunks(world, clo, chi, &chunks)) {
+    fprintf(stderr,
+        "(world_count_blocks): Error counting blocks, realloc failed.\n");
+    world_release_chunks(&chunks);
+    return 0;
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < chunks.num_items; i++) {
+    Chunk *chunk = chunks.items[i];
+    // The box in the chunk's local coords, clamped to the chunk
+    int box_lo[3], box_hi[3];
+    bool whole = true;
+    for (int j = 0; j < 3; j++) {
+      long long base = (long long)chunk->coords[j] * CHUNK_WIDTH;
+      long long l    = lo[j] - base;
+      long long h    = hi[j] - base;
+      box_lo[j]      = l < 0 ? 0 : (int)l;
+      box_hi[j]      = h > CHUNK_MASK ? CHUNK_MASK : (int)h;
+      whole          = whole && box_lo[j] == 0 && box_hi[j] == CHUNK_MASK;
+    }
+    lock_chunk(chunk);
+    if (!chunk->blocks || chunk->type_counts[type] == 0) {
+      unlock_chunk(chunk);
+      continue;
+    }
+    if (whole) {
+      count += chunk->type_counts[type];
+      unlock_chunk(chunk);
+      continue;
+    }
+    // Only scan the part of each brick that may hold the type inside the box
+    for (uint64_t bricks = chunk->type_bricks[type]; bricks;
+         bricks &= bricks - 1) {
+      int corner[3], from[3], to[3];
+      brick_corner(__builtin_ctzll(bricks), corner);
+      bool empty = false;
+      for (int j = 0; j < 3; j++) {
+        from[j] = corner[j] > box_lo[j] ? corner[j] : box_lo[j];
+        to[j]   = corner[j] + CHUNK_BRICK - 1 < box_hi[j]
+                      ? corner[j] + CHUNK_BRICK - 1
+                      : box_hi[j];
+        empty   = empty || from[j] > to[j];
+      }
+      if (empty) { continue; }
+      for (int y = from[1]; y <= to[1]; y++) {
+        for (int x = from[0]; x <= to[0]; x++) {
+          const Block *row = &chunk->blocks[CHUNK_INDEX(x, y, 0)];
+          for (int z = from[2]; z <= to[2]; z++) {
+            count += row[z].type == type;
+          }
+        }
+      }
+    }
+    unlock_chunk(chunk);
+  }
+  world_release_chunks(&chunks);
+  return count;
+}
+
 Block *world_get_blockf(World *world, float x, float y, float z) {
   int ix = (int)floorf(x);
   int iy = (int)floorf(y);
@@ -534,79 +1499,264 @@ void world_set_blockf(World *world, BlockType block, float x, float y, float z)
   world_set_block(world, block, ix, iy, iz);
 }
 
-RayCastReturn world_raycast(World *world, float x, float y, float z, float dx,
-    float dy, float dz, float max_dist) {
-  RayCastReturn ret = {0};
-  if (!world) { return ret; }
-  // Normalise direction vector
-  float d_mag = (dx * dx + dy * dy + dz * dz);
-  if (d_mag == 0.f) {
-    return ret; // Handle 0 magnitude
-  }
-  dx /= d_mag;
-  dy /= d_mag;
-  dz /= d_mag;
-  // Get integer position of first block
-  int cur_x = (int)floorf(x);
-  int cur_y = (int)floorf(y);
-  int cur_z = (int)floorf(z);
-
-  int last_x = (int)floorf(x);
-  int last_y = (int)floorf(y);
-  int last_z = (int)floorf(z);
-  float dist = 0.f;
-
-  float tdx = fabsf(1.f / dx);
-  float tdy = fabsf(1.f / dy);
-  float tdz = fabsf(1.f / dz);
-
-  int step_x = (dx > 0) ? 1 : -1;
-  int step_y = (dy > 0) ? 1 : -1;
-  int step_z = (dz > 0) ? 1 : -1;
-
-  float tmx = (dx > 0) ? ((cur_x + 1 - x) / dx) : ((x - cur_x) / -dx);
-  float tmy = (dy > 0) ? ((cur_y + 1 - y) / dy) : ((y - cur_y) / -dy);
-  float tmz = (dz > 0) ? ((cur_z + 1 - z) / dz) : ((z - cur_z) / -dz);
-
-  while (dist < max_dist) {
-    Block *block = world_get_block(world, cur_x, cur_y, cur_z);
-    if (block && block->type != BlockAir) {
-      ret.hit       = true;
-      ret.hit_x     = cur_x;
-      ret.hit_y     = cur_y;
-      ret.hit_z     = cur_z;
-      ret.last_x    = last_x;
-      ret.last_y    = last_y;
-      ret.last_z    = last_z;
-      ret.block_hit = block;
-      return ret;
-    }
-
-    last_x = cur_x;
-    last_z = cur_z;
-    last_y = cur_y;
-
-    if (tmx < tmy) {
-      if (tmx < tmz) {
-        cur_x += step_x;
-        dist = tmx;
-        tmx += tdx;
-      } else {
-        cur_z += step_z;
-        dist = tmz;
-        tmz += tdz;
+void world_cursor_init(WorldCursor *cursor, World *world) {
+  if (!cursor) { return; }
+  *cursor = (WorldCursor){.world = world};
+}
+
+// Find a chunk for a cursor slot, NULL if it isn't loaded or generated. Block
+// arrays aren't replaced once a chunk is generated, so the cursor can keep
+// the pointer without holding the lock. The node is read after its bucket is
+// unlocked, which is safe as only this thread unloads chunks
+static void world_cursor_lookup(
+    WorldCursor *cursor, unsigned slot, int x, int y, int z) {
+  cursor->num_lookups++;
+  cursor->chunks[slot] = NULL;
+  cursor->blocks[slot] = NULL;
+  ChunkNode *node      = hashmap_get(cursor->world, x, y, z);
+  Chunk *chunk         = node ? node->chunk : NULL;
+  if (!chunk) { return; }
+  lock_chunk(chunk);
+  if (chunk->state != STATE_EMPTY) {
+    cursor->chunks[slot] = chunk;
+    cursor->blocks[slot] = chunk->blocks;
+  }
+  unlock_chunk(chunk);
+}
+
+// Get the window slot holding a chunk, moving the window and looking the
+// chunk up if needed
+static inline unsigned world_cursor_slot(
+    WorldCursor *cursor, int cx, int cy, int cz) {
+  // Move the window so the chunk is in the middle if it is outside of it
+  unsigned dx = (unsigned)(cx - cursor->base[0]);
+  unsigned dy = (unsigned)(cy - cursor->base[1]);
+  unsigned dz = (unsigned)(cz - cursor->base[2]);
+  if (dx >= WORLD_CURSOR_SPAN || dy >= WORLD_CURSOR_SPAN
+      || dz >= WORLD_CURSOR_SPAN) {
+    cursor->base[0] = cx - WORLD_CURSOR_SPAN / 2;
+    cursor->base[1] = cy - WORLD_CURSOR_SPAN / 2;
+    cursor->base[2] = cz - WORLD_CURSOR_SPAN / 2;
+    cursor->cached  = 0;
+    dx = dy = dz = WORLD_CURSOR_SPAN / 2;
+  }
+
+  unsigned slot = dx + WORLD_CURSOR_SPAN * (dy + WORLD_CURSOR_SPAN * dz);
+  if (!(cursor->cached & (1u << slot))) {
+    world_cursor_lookup(cursor, slot, cx, cy, cz);
+    cursor->cached |= 1u << slot;
+  }
+  return slot;
+}
+
+Block *world_cursor_get_block(WorldCursor *cursor, int x, int y, int z) {
+  if (!cursor || !cursor->world) { return NULL; }
+  unsigned slot = world_cursor_slot(
+      cursor, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+  Block *blocks = cursor->blocks[slot];
+  if (!blocks) { return NULL; }
+  return &blocks[CHUNK_INDEX(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK)];
+}
+
+bool world_cursor_any_solid(
+    WorldCursor *cursor, const int lo[3], const int hi[3]) {
+  if (!cursor || !cursor->world) { return false; }
+  for (int x = lo[0]; x <= hi[0]; x++) {
+    for (int y = lo[1]; y <= hi[1]; y++) {
+      // Split the z span where it crosses chunks, and test each piece as one
+      // masked row
+      for (int z = lo[2]; z <= hi[2];) {
+        int end       = (z | CHUNK_MASK) < hi[2] ? (z | CHUNK_MASK) : hi[2];
+        unsigned slot = world_cursor_slot(
+            cursor, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+        Chunk *chunk  = cursor->chunks[slot];
+        if (chunk) {
+          uint32_t mask = (uint32_t)((2ull << (end & CHUNK_MASK))
+                                     - (1ull << (z & CHUNK_MASK)));
+          uint32_t row = chunk_solid_row(chunk, x & CHUNK_MASK, y & CHUNK_MASK);
+          if (row & mask) { return true; }
+        }
+        z = end + 1;
       }
+    }
+  }
+  return false;
+}
+
+// A ray's walk through the block grid. Distances to boundaries are worked
+// out from the number crossed on each axis rather than added up step by step,
+// so the walk can jump over a whole brick or chunk and land exactly where
+// stepping one block at a time would have
+typedef struct {
+  int start[3];   // Block the ray starts in
+  int step[3];    // Direction the ray moves in on each axis
+  float first[3]; // Distance to the first boundary on each axis
+  float delta[3]; // Distance between boundaries on each axis, 0 if parallel
+  int crossed[3]; // Boundaries crossed so far on each axis
+  int cur[3];     // Block the ray is in
+  float next[3];  // Distance to the next boundary on each axis
+  int axis;       // Axis of the last boundary crossed, -1 before the first
+  float dist;     // Distance to the last boundary crossed
+} RayWalk;
+
+// Distance along a ray to its nth boundary on an axis
+static inline float ray_boundary(const RayWalk *walk, int axis, int n) {
+  return walk->first[axis] + (float)n * walk->delta[axis];
+}
+
+// Cross n boundaries on an axis
+static inline void ray_walk_cross(RayWalk *walk, int axis, int n) {
+  walk->crossed[axis] += n;
+  walk->cur[axis] += walk->step[axis] * n;
+  walk->next[axis] = ray_boundary(walk, axis, walk->crossed[axis]);
+}
+
+// Start a walk, returns false if the direction has no length
+static bool ray_walk_init(RayWalk *walk, const vec3 origin, const vec3 dir) {
+  float mag = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+  if (mag == 0.f) { return false; }
+  for (int i = 0; i < 3; i++) {
+    float d          = dir[i] / mag;
+    walk->start[i]   = (int)floorf(origin[i]);
+    walk->cur[i]     = walk->start[i];
+    walk->crossed[i] = 0;
+    if (d > 0.f) {
+      walk->step[i]  = 1;
+      walk->first[i] = (walk->start[i] + 1 - origin[i]) / d;
+      walk->delta[i] = 1.f / d;
+    } else if (d < 0.f) {
+      walk->step[i]  = -1;
+      walk->first[i] = (origin[i] - walk->start[i]) / -d;
+      walk->delta[i] = -1.f / d;
     } else {
-      if (tmy < tmz) {
-        cur_y += step_y;
-        dist = tmy;
-        tmy += tdy;
-      } else {
-        cur_z += step_z;
-        dist = tmz;
-        tmz += tdz;
-      }
+      // Never crosses a boundary on this axis
+      walk->step[i]  = 1;
+      walk->first[i] = INFINITY;
+      walk->delta[i] = 0.f;
+    }
+    walk->next[i] = walk->first[i];
+  }
+  walk->axis = -1;
+  walk->dist = 0.f;
+  return true;
+}
+
+// Step a walk into the next block. Boundaries the same distance away are
+// crossed z first, then y, then x
+static inline void ray_walk_step(RayWalk *walk) {
+  int axis = walk->next[1] <= walk->next[0] ? 1 : 0;
+  if (walk->next[2] <= walk->next[axis]) { axis = 2; }
+  walk->dist = walk->next[axis];
+  walk->axis = axis;
+  ray_walk_cross(walk, axis, 1);
+}
+
+// Move a walk out of the aligned cube of 2^shift blocks to a side that it is
+// in, to where ray_walk_step() would have left it
+static void ray_walk_skip(RayWalk *walk, int shift) {
+  int mask = (1 << shift) - 1;
+
+  // Boundaries inside the cube left on each axis, and where the ray leaves
+  int inside[3];
+  int out      = 0;
+  float out_at = INFINITY;
+  for (int i = 0; i < 3; i++) {
+    int cur   = walk->cur[i];
+    inside[i] = walk->step[i] > 0 ? (cur | mask) - cur : cur & mask;
+    float at  = ray_boundary(walk, i, walk->crossed[i] + inside[i]);
+    if (at <= out_at) {
+      out    = i;
+      out_at = at;
     }
   }
+
+  // Cross the boundaries the other axes reach before the ray leaves
+  for (int i = 0; i < 3; i++) {
+    if (i == out || inside[i] == 0 || walk->delta[i] == 0.f) { continue; }
+    float guess = (out_at - walk->first[i]) / walk->delta[i] - walk->crossed[i];
+    int n = guess <= 0.f ? 0 : (guess >= inside[i] ? inside[i] : (int)guess);
+    // The guess is rounded, so settle it against the exact boundaries
+    while (n < inside[i]) {
+      float at = ray_boundary(walk, i, walk->crossed[i] + n);
+      if (at > out_at || (at == out_at && i < out)) { break; }
+      n++;
+    }
+    while (n > 0) {
+      float at = ray_boundary(walk, i, walk->crossed[i] + n - 1);
+      if (at < out_at || (at == out_at && i > out)) { break; }
+      n--;
+    }
+    if (n > 0) { ray_walk_cross(walk, i, n); }
+  }
+  ray_walk_cross(walk, out, inside[out] + 1);
+  walk->axis = out;
+  walk->dist = out_at;
+}
+
+// Raycast through a cursor. Chunks that aren't loaded and empty bricks are
+// skipped whole
+static RayCastReturn world_cursor_raycast(
+    WorldCursor *cursor, const vec3 origin, const vec3 dir, float max_dist) {
+  RayCastReturn ret = {0};
+  RayWalk walk;
+  if (!ray_walk_init(&walk, origin, dir)) { return ret; }
+
+  while (walk.dist < max_dist) {
+    const int *cur = walk.cur;
+    unsigned slot  = world_cursor_slot(cursor,
+        cur[0] >> CHUNK_SHIFT,
+        cur[1] >> CHUNK_SHIFT,
+        cur[2] >> CHUNK_SHIFT);
+    Chunk *chunk   = cursor->chunks[slot];
+    if (!chunk) {
+      ray_walk_skip(&walk, CHUNK_SHIFT);
+      continue;
+    }
+    int x = cur[0] & CHUNK_MASK;
+    int y = cur[1] & CHUNK_MASK;
+    int z = cur[2] & CHUNK_MASK;
+    if (!(chunk->solid_bricks & CHUNK_BRICK_BIT(x, y, z))) {
+      ray_walk_skip(&walk, CHUNK_BRICK_SHIFT);
+      continue;
+    }
+    Block *block = &cursor->blocks[slot][CHUNK_INDEX(x, y, z)];
+    if (block->type == BlockAir) {
+      ray_walk_step(&walk);
+      continue;
+    }
+
+    ret.hit       = true;
+    ret.hit_x     = cur[0];
+    ret.hit_y     = cur[1];
+    ret.hit_z     = cur[2];
+    ret.dist      = walk.dist;
+    ret.block_hit = block;
+    if (walk.axis >= 0) { ret.normal[walk.axis] = -walk.step[walk.axis]; }
+    ret.last_x = cur[0] + ret.normal[0];
+    ret.last_y = cur[1] + ret.normal[1];
+    ret.last_z = cur[2] + ret.normal[2];
+    return ret;
+  }
   return ret;
 }
+
+RayCastReturn world_raycast(World *world, float x, float y, float z, float dx,
+    float dy, float dz, float max_dist) {
+  RayCastReturn ret = {0};
+  if (!world) { return ret; }
+  WorldCursor cursor;
+  world_cursor_init(&cursor, world);
+  return world_cursor_raycast(
+      &cursor, (vec3){x, y, z}, (vec3){dx, dy, dz}, max_dist);
+}
+
+void world_raycast_batch(World *world, const WorldRay *rays, size_t num_rays,
+    RayCastReturn *results) {
+  if (!world || !rays || !results) { return; }
+  WorldCursor cursor;
+  world_cursor_init(&cursor, world);
+  for (size_t i = 0; i < num_rays; i++) {
+    results[i] = world_cursor_raycast(
+        &cursor, rays[i].origin, rays[i].dir, rays[i].max_dist);
+  }
+}
@@ -4,11 +4,15 @@
 
 #include "block.h"
 #include "chunk.h"
+#include "coord_set.h"
+#include "horizon.h"
 #include "nuGL.h"
+#include "render_list.h"
 
 #include <cglm/cglm.h>
 #include <limits.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,8 +21,17 @@
 
 #define HASHMAP_SIZE 4096
 
+#define PENDING_MAP_SIZE 1024
+
 #define RENDER_DISTANCE 8
 
+// Chunks up to LOD_RING chunks from the centre are meshed at full detail.
+// Past that, each ring twice as far out as the last drops a level of detail
+#define LOD_RING 4
+// Chunks only drop a level once they are this many chunks past its ring, so
+// a player walking back and forth over a ring doesn't keep remeshing them
+#define LOD_HYSTERESIS 1
+
 typedef struct ChunkNode {
   Chunk *chunk;
   int x, y, z;
@@ -30,6 +43,21 @@ typedef struct {
   pthread_mutex_t bucket_mutexes[HASHMAP_SIZE];
 } ChunkMap;
 
+// Decoration edits waiting on a chunk, keyed by that chunk's coords
+typedef struct PendingNode {
+  int x, y, z;
+  EditList edits;         // Edits that landed in this chunk, in global coords
+  int (*sources)[3];      // Chunks that have already contributed edits
+  size_t sources_alloced;
+  size_t num_sources;
+  struct PendingNode *next;
+} PendingNode;
+
+typedef struct {
+  PendingNode *buckets[PENDING_MAP_SIZE];
+  pthread_mutex_t mutex;
+} PendingMap;
+
 typedef struct {
   int x, y, z;
 } QueueItem;
@@ -38,40 +66,145 @@ typedef struct {
   QueueItem *items;
   size_t items_alloced;
   size_t num_items;
+  size_t num_active;    // Items popped by a thread that haven't finished yet
+  CoordSet queued;      // Coords of every item, so a chunk is only queued once
+  size_t num_pushed;    // Items added to the queue
+  size_t num_coalesced; // Requests for a chunk that was already queued
 } Queue;
 
+// Snapshot of the world's queue, for stats
+typedef struct {
+  size_t queue_depth;   // Chunks waiting to be generated or meshed
+  size_t queue_active;  // Chunks workers are working on
+  size_t num_pushed;    // Chunks added to the queue so far
+  size_t num_coalesced; // Requests that found their chunk already queued
+} WorldStats;
+
+// Loaded chunks found by a search of the chunk map
+typedef struct {
+  Chunk **items;
+  size_t num_items;
+  size_t items_alloced;
+} ChunkList;
+
+// A carve split into one slice per chunk it touches. The carving thread and
+// idle workers take slices until there are none left
 typedef struct {
+  ChunkList chunks; // One slice each
+  size_t *changed;  // Blocks each slice changed
+  float a[3], b[3]; // Ends of the capsule's segment, in block coords
+  float radius;
+  atomic_size_t next; // Next slice to take
+} CarveJob;
+
+typedef struct World {
   nu_Program *program;        // Shader program used to render the world
   nu_Texture *block_textures; // Texture array of block textures
   ChunkMap map;               // Hashmap of loaded chunks
+  PendingMap pending;         // Decoration edits that crossed chunk borders
   size_t rdx, rdy, rdz;       // render distances in each axis
-  int cx, cy, cz; // the centre of the world (where chunks load around)
+  // The centre of the world (where chunks load around). Atomic, because the
+  // thread that moves it isn't the one that renders
+  _Atomic int cx, cy, cz;
   Queue queue;    // Queue of chunk coordinates to be generated and meshed
   uint32_t seed;  // World seed
-  pthread_t chunk_threads[NUM_THREADS]; // The threads that will generate and mesh
-                                        // chunks
+  pthread_t *chunk_threads; // The threads that will generate and mesh chunks
+  size_t num_threads;
+  bool mesh_chunks;     // Whether threads mesh chunks after generating them
+  // If set, chunks are loaded from here when possible. Not owned, it must
+  // outlive the world
+  const char *save_dir;
+  bool publish_meshes;  // Whether meshes are handed to the render list
+  size_t lod_ring;      // Full detail distance, see LOD_RING. 0 turns LOD off
+  RenderList render_list;            // Drawable chunks, render thread only
+  RenderUpdateQueue render_updates; // Meshes waiting to join the render list
+  Horizon *horizon; // Far terrain past the loaded chunks, NULL when headless
+  // Set by create_world(), NULL when headless, so the world itself never
+  // calls into GL. render_moved follows a centre move on the sim thread, and
+  // render_free frees the render resources on the GL thread
+  void (*render_moved)(struct World *world);
+  void (*render_free)(struct World *world);
   // pthread_mutex_t hashmap_mutex; // Mutex protecting hashmap lookups /
   // insertions
   pthread_mutex_t
       queue_mutex;    // Mutex protecting pushing and popping from the queue
+  CarveJob *carve;        // Carve workers can help with, NULL if none
+  size_t carve_helpers;   // Workers taking slices of carve
+  pthread_mutex_t carve_mutex; // Protects carve and carve_helpers
+  // Wakes idle workers when a carve starts, and the carving thread when a
+  // worker lets go of it
+  pthread_cond_t carve_cond;
   volatile bool kill; // Flag to kill the threads
 } World;
 
+// Chunks a cursor keeps on each axis, around the last chunk it had to look up
+#define WORLD_CURSOR_SPAN 3
+#define WORLD_CURSOR_CHUNKS \
+  (WORLD_CURSOR_SPAN * WORLD_CURSOR_SPAN * WORLD_CURSOR_SPAN)
+
+// Reads blocks for a run of nearby queries (a collision box, a raycast). It
+// remembers the chunks around the last one it looked up, so it only goes to
+// the chunk map when a query crosses into a chunk it hasn't seen. It holds
+// chunks and their blocks without pinning them, which is only safe because
+// chunks are only freed by world_update_centre(). So a cursor must be used on
+// the thread that calls it (the sim thread in the game), and can't be kept
+// across it
+typedef struct {
+  World *world;
+  int base[3]; // Chunk coords of the cached window's minimum corner
+  // Each chunk in the window and its blocks, NULL if it isn't loaded or
+  // generated
+  Chunk *chunks[WORLD_CURSOR_CHUNKS];
+  Block *blocks[WORLD_CURSOR_CHUNKS];
+  uint32_t cached;    // One bit per window chunk that has been looked up
+  size_t num_lookups; // Times the cursor went to the chunk map
+} WorldCursor;
+
 typedef struct {
   bool hit;                   // Did it hit?
   int hit_x, hit_y, hit_z;    // Store the position the ray hit at
   int last_x, last_y, last_z; // Store the last position of the ray before hit
-  Block *block_hit;           // Store a pointer to the block that was hit
+  // Normal of the face the ray entered the hit block through, all 0 if the
+  // ray started inside it
+  int normal[3];
+  float dist;       // Distance along the ray to the hit
+  Block *block_hit; // Store a pointer to the block that was hit
 } RayCastReturn;
 
-// Allocate, initialise and return a pointer to a world
-World *create_world(uint32_t world_seed);
+// One ray of a batch
+typedef struct {
+  vec3 origin;
+  vec3 dir;       // Doesn't need to be normalised
+  float max_dist; // In blocks
+} WorldRay;
+
+// Allocate, initialise and return a pointer to a world. If save_dir isn't
+// NULL, chunks saved there with the same seed (e.g. by pregen -o) are loaded
+// instead of generated
+World *create_world(uint32_t world_seed, const char *save_dir);
+// Create a world without any rendering resources, so no GL context is needed.
+// No chunks are loaded until world_load_box() or world_update_centre()
+World *create_world_headless(uint32_t world_seed, size_t num_threads);
+// Tell the world's threads to stop, and anyone waiting on the render queue
+// to give up, without freeing anything. Call before joining a thread that
+// edits the world while nothing drains the queue, e.g. the sim's on shutdown
+void world_stop(World *world);
 // Destroy all of a world's resources, and null the pointer
 void destroy_world(World **world);
 // Render a world given a player and an aspect
 void render_world(World *world, void *player, float aspect);
-// Set the point of the world that chunks load around
+// Set the point of the world that chunks load around. Frees unloaded chunks,
+// so nothing may hold on to chunks or cursors across it. When meshes are
+// published it may wait for the render thread, so it can't be called there
 void world_update_centre(World *world, int nx, int ny, int nz);
+// Create and queue every chunk in an inclusive box of chunk coords
+void world_load_box(World *world, int x0, int y0, int z0, int x1, int y1, int z1);
+// Check if every queued chunk has been generated (and meshed)
+bool world_is_idle(World *world);
+// Get the queue's depth and counters
+WorldStats world_get_stats(World *world);
+// Save every generated chunk to a directory, returns the number saved
+size_t world_save(World *world, const char *dir);
 // Generate and mesh one chunk from the queue, returns true on success, and
 // false if the queue was empty
 bool world_update_queue(World *world);
@@ -82,12 +215,68 @@ Chunk *world_get_chunkf(World *world, float x, float y, float z);
 Block *world_get_block(World *world, int x, int y, int z);
 // Set a block at integer coords
 void world_set_block(World *world, BlockType block, int x, int y, int z);
+// Set a block for an edit someone is waiting to see, like a player breaking
+// it. The chunk is remeshed on the calling thread instead of waiting behind
+// the queue, so the render thread picks the mesh up on its next drain.
+// edit_time is when the edit was asked for, in seconds on CLOCK_MONOTONIC (0
+// if unknown), and is passed on with the mesh so the render list can time it
+void world_edit_block(
+    World *world, BlockType block, int x, int y, int z, double edit_time);
+// Set every block in an inclusive box of block coords. Each touched chunk is
+// locked and queued for remeshing once, and blocks in chunks that aren't
+// loaded or generated are skipped. Returns the number of blocks changed
+size_t world_fill_region(World *world, BlockType block, int x0, int y0,
+    int z0, int x1, int y1, int z1);
+// Like world_fill_region(), but only changes blocks of type from
+size_t world_replace_region(World *world, BlockType from, BlockType to,
+    int x0, int y0, int z0, int x1, int y1, int z1);
+// Apply a list of edits in order, grouped by chunk so each chunk is locked
+// and queued once. Returns the number of blocks changed
+size_t world_apply_edit_list(World *world, const EditList *edits);
+// Set every solid block whose centre is within radius of a point to air. The
+// touched chunks are carved in parallel by the calling thread and any idle
+// workers, then queued for remeshing once each. Returns the number of blocks
+// changed
+size_t world_carve_sphere(World *world, const vec3 centre, float radius);
+// Like world_carve_sphere(), but for every point on the segment a-b
+size_t world_carve_capsule(
+    World *world, const vec3 a, const vec3 b, float radius);
+// Find the block of a type nearest a point, measuring to block centres, up to
+// radius away. Only chunks holding the type are searched, nearest first, and
+// only the bricks in them that may hold it. Returns false if there is none,
+// otherwise fills out with its coords
+bool world_find_nearest(World *world, BlockType type, const vec3 origin,
+    float radius, int out[3]);
+// Count the blocks of a type in an inclusive box of block coords. Chunks the
+// box covers are counted from their summaries, the rest a brick at a time.
+// Blocks in chunks that aren't loaded or generated aren't counted
+size_t world_count_blocks(World *world, BlockType type, int x0, int y0, int z0,
+    int x1, int y1, int z1);
 // Get a pointer to a block from float coords
 Block *world_get_blockf(World *world, float x, float y, float z);
 // Set a block from float coords
 void world_set_blockf(World *world, BlockType block, float x, float y, float z);
-// Raycast from an origin in a direction, up to a certain distance
+// Start a cursor with nothing cached. Only for the thread that calls
+// world_update_centre(), see WorldCursor
+void world_cursor_init(WorldCursor *cursor, World *world);
+// Get a pointer to the block at integer coords, NULL if its chunk isn't
+// loaded or generated
+Block *world_cursor_get_block(WorldCursor *cursor, int x, int y, int z);
+// Check if any block in an inclusive box of block coords isn't air, testing
+// whole rows of occupancy bits at a time. Blocks in chunks that aren't loaded
+// or generated count as air
+bool world_cursor_any_solid(
+    WorldCursor *cursor, const int lo[3], const int hi[3]);
+// Raycast from an origin in a direction, up to a certain distance. Chunks that
+// aren't loaded count as air. Reads through a cursor, so only for the thread
+// that calls world_update_centre()
 RayCastReturn world_raycast(World *world, float x, float y, float z, float dx,
     float dy, float dz, float max_dist);
+// Raycast a batch of rays, writing one result per ray. The rays share a
+// cursor, so rays from nearby origins (line of sight checks, explosions,
+// sound occlusion) only look each chunk up once. Same thread as
+// world_raycast()
+void world_raycast_batch(World *world, const WorldRay *rays, size_t num_rays,
+    RayCastReturn *results);
 
 #endif
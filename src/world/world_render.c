@@ -0,0 +1,146 @@
+#include "world.h"
+#include "player.h"
+
+// Rendering side of the world. It is kept apart from world.c so headless
+// tools can link the world without GL
+
+// Move the far terrain with the world's centre
+static void world_render_moved(World *world) {
+  horizon_update_centre(
+      world->horizon, world->cx * CHUNK_WIDTH, world->cz * CHUNK_LENGTH);
+}
+
+// Free everything create_world() added to the headless world
+static void world_render_free(World *world) {
+  if (world->program) { nu_destroy_program(&world->program); }
+  if (world->block_textures) { nu_destroy_texture(&world->block_textures); }
+  destroy_horizon(&world->horizon);
+  render_list_free(&world->render_list);
+}
+
+World *create_world(uint32_t world_seed, const char *save_dir) {
+  // Create the world's shader program
+  nu_Program *program = nu_create_program(
+      2, "shaders/block.vert", "shaders/block.frag");
+  if (!program) {
+    fprintf(stderr,
+        "(create_world): Error creating world, nu_create_program() "
+        "returned NULL.\n");
+    return NULL;
+  }
+  nu_register_uniform(program, "uMVP", GL_FLOAT_MAT4);
+  nu_register_uniform(program, "uPlayerPos", GL_FLOAT_VEC3);
+  nu_register_uniform(program, "uRenderDistance", GL_FLOAT);
+
+  // Load the texture array for blocks
+  nu_Texture *block_textures = nu_load_texture_array(
+      NUM_BLOCK_TEXTURES, BLOCK_TEXTURES);
+  if (!block_textures) {
+    fprintf(stderr,
+        "(create_world): Error creating world, "
+        "nu_load_texture_array() returned NULL.\n");
+    nu_destroy_program(&program);
+    return NULL;
+  }
+
+  // Create the world itself
+  World *world = create_world_headless(world_seed, NUM_THREADS);
+  if (!world) {
+    fprintf(stderr,
+        "(create_world): Error creating world, create_world_headless() "
+        "returned NULL.\n");
+    nu_destroy_program(&program);
+    nu_destroy_texture(&block_textures);
+    return NULL;
+  }
+  world->program               = program;
+  world->block_textures        = block_textures;
+  world->save_dir              = save_dir;
+  world->publish_meshes        = true;
+  world->lod_ring              = LOD_RING;
+  world->render_moved          = world_render_moved;
+  world->render_free           = world_render_free;
+  render_list_init(&world->render_list);
+  world->render_list.occlusion = true;
+
+  // The horizon is only scenery, so the world still works without it
+  world->horizon = create_horizon(world_seed);
+  if (!world->horizon) {
+    fprintf(stderr,
+        "(create_world): Couldn't create horizon, create_horizon() returned "
+        "NULL.\n");
+  }
+
+  // Queue initial chunks
+  world_load_box(world,
+      world->cx - (int)world->rdx,
+      world->cy - (int)world->rdy,
+      world->cz - (int)world->rdz,
+      world->cx + (int)world->rdx,
+      world->cy + (int)world->rdy,
+      world->cz + (int)world->rdz);
+
+  return world;
+}
+
+// Render every chunk with a mesh, and send newly meshed chunks to GPU
+void render_world(World *world, void *p, float aspect) {
+  if (!world || !p) { return; }
+
+  Player *player = (Player *)p;
+
+  // Draw the far terrain first, chunks fade into it instead of the sky
+  float render_dist = world->rdx * CHUNK_WIDTH;
+  if (world->horizon) {
+    float inner_min[2] = {(float)(world->cx - (int)world->rdx) * CHUNK_WIDTH,
+        (float)(world->cz - (int)world->rdz) * CHUNK_LENGTH};
+    float inner_max[2] = {
+        (float)(world->cx + (int)world->rdx + 1) * CHUNK_WIDTH,
+        (float)(world->cz + (int)world->rdz + 1) * CHUNK_LENGTH};
+    render_horizon(
+        world->horizon, player->camera, aspect, inner_min, inner_max);
+    render_dist = horizon_distance();
+  }
+
+  nu_set_uniform(world->program, "uPlayerPos", player->position);
+  nu_set_uniform(world->program, "uRenderDistance", &render_dist);
+
+  // Set OpenGL parameters
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+
+  // Get camera's VP matrix
+  mat4 vp;
+  camera_calculate_vp_matrix(player->camera, vp, aspect);
+
+  // Calculate frustum planes for frustum culling
+  vec4 planes[6] = {0};
+  glm_frustum_planes(vp, planes);
+
+  // Use world's program shader and send vp matrix
+  nu_use_program(world->program);
+  nu_set_uniform(world->program, "uMVP", &vp[0][0]);
+  nu_bind_texture(world->block_textures, 0);
+
+  // Pick up meshes finished since last frame
+  render_queue_drain(&world->render_updates, &world->render_list);
+
+  // Find which chunks terrain doesn't hide, then draw the ones in view
+  if (world->render_list.occlusion) {
+    float *eye    = player->camera->position;
+    int camera[3] = {(int)floorf(eye[0] / CHUNK_WIDTH),
+        (int)floorf(eye[1] / CHUNK_HEIGHT),
+        (int)floorf(eye[2] / CHUNK_LENGTH)};
+    int min[3]    = {world->cx - (int)world->rdx,
+        world->cy - (int)world->rdy,
+        world->cz - (int)world->rdz};
+    int max[3]    = {world->cx + (int)world->rdx,
+        world->cy + (int)world->rdy,
+        world->cz + (int)world->rdz};
+    render_list_occlude(&world->render_list, camera, min, max, planes);
+  }
+  render_list_cull(&world->render_list, planes);
+  // Near chunks first, so the depth test rejects what they hide
+  render_list_sort(&world->render_list, player->camera->position, false);
+  render_list_draw(&world->render_list, player->camera->position);
+}
@@ -0,0 +1,159 @@
+// Checks that world generation doesn't depend on threads or load order. The
+// same box of chunks is generated on one thread, on several, and one chunk
+// at a time in shuffled orders, and every run must produce the same blocks
+//
+// Usage: determinism [-t threads]
+
+#include "bench_util.h"
+#include "world.h"
+#include <string.h>
+#include <unistd.h>
+
+#define SEED 6
+#define SHUFFLES 2
+
+// Inclusive box of chunk coords, covering both ore bands and a forest
+static const int box[6] = {-3, -3, -3, 3, 3, 3};
+
+#define BOX_X (box[3] - box[0] + 1)
+#define BOX_Y (box[4] - box[1] + 1)
+#define BOX_Z (box[5] - box[2] + 1)
+#define BOX_CHUNKS (BOX_X * BOX_Y * BOX_Z)
+
+static void box_coords(int i, int coords[3]) {
+  coords[0] = box[0] + i % BOX_X;
+  coords[1] = box[1] + i / BOX_X % BOX_Y;
+  coords[2] = box[2] + i / (BOX_X * BOX_Y);
+}
+
+// Copy every chunk's blocks out of a world, in box order. Returns false if a
+// chunk is missing
+static bool copy_blocks(World *world, Block *out) {
+  for (int i = 0; i < BOX_CHUNKS; i++) {
+    int c[3];
+    box_coords(i, c);
+    Chunk *chunk = world_get_chunk(
+        world, c[0] * CHUNK_WIDTH, c[1] * CHUNK_HEIGHT, c[2] * CHUNK_LENGTH);
+    if (!chunk || !chunk->blocks) {
+      fprintf(stderr,
+          "(copy_blocks): Chunk (%d, %d, %d) wasn't generated.\n",
+          c[0],
+          c[1],
+          c[2]);
+      return false;
+    }
+    memcpy(out + (size_t)i * CHUNK_VOLUME,
+        chunk->blocks,
+        sizeof(Block) * CHUNK_VOLUME);
+  }
+  return true;
+}
+
+// Generate the box with the workers free to take chunks in any order
+static bool generate_box(size_t threads, Block *out) {
+  World *world = create_world_headless(SEED, threads);
+  if (!world) { return false; }
+  world->mesh_chunks = false;
+  world_load_box(world, box[0], box[1], box[2], box[3], box[4], box[5]);
+  wait_idle(world);
+  bool success = copy_blocks(world, out);
+  destroy_world(&world);
+  return success;
+}
+
+// Generate the box one chunk at a time in a shuffled order, so neighbours
+// generate before and after each other in ways a whole box never does
+static bool generate_shuffled(size_t threads, uint32_t shuffle, Block *out) {
+  int order[BOX_CHUNKS];
+  for (int i = 0; i < BOX_CHUNKS; i++) { order[i] = i; }
+  uint32_t state = shuffle * 2654435761u + 1;
+  for (int i = BOX_CHUNKS - 1; i > 0; i--) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    int j    = (int)(state % (uint32_t)(i + 1));
+    int tmp  = order[i];
+    order[i] = order[j];
+    order[j] = tmp;
+  }
+
+  World *world = create_world_headless(SEED, threads);
+  if (!world) { return false; }
+  world->mesh_chunks = false;
+  for (int i = 0; i < BOX_CHUNKS; i++) {
+    int c[3];
+    box_coords(order[i], c);
+    world_load_box(world, c[0], c[1], c[2], c[0], c[1], c[2]);
+    wait_idle(world);
+  }
+  bool success = copy_blocks(world, out);
+  destroy_world(&world);
+  return success;
+}
+
+// Compare a run against the reference, returns the number of chunks that
+// differ
+static int compare(const char *name, const Block *ref, const Block *run) {
+  int differ = 0;
+  for (int i = 0; i < BOX_CHUNKS; i++) {
+    size_t offset = (size_t)i * CHUNK_VOLUME;
+    if (memcmp(ref + offset, run + offset, sizeof(Block) * CHUNK_VOLUME)
+        == 0) {
+      continue;
+    }
+    int c[3];
+    box_coords(i, c);
+    size_t blocks = 0;
+    for (size_t j = 0; j < CHUNK_VOLUME; j++) {
+      blocks += ref[offset + j].type != run[offset + j].type;
+    }
+    fprintf(stderr,
+        "(compare): %s: chunk (%d, %d, %d) differs in %zu blocks.\n",
+        name,
+        c[0],
+        c[1],
+        c[2],
+        blocks);
+    differ++;
+  }
+  printf("%-24s %s\n", name, differ ? "FAILED" : "ok");
+  return differ;
+}
+
+int main(int argc, char **argv) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (argc == 3 && strcmp(argv[1], "-t") == 0) {
+    threads = atol(argv[2]);
+  } else if (argc != 1) {
+    fprintf(stderr, "Usage: %s [-t threads]\n", argv[0]);
+    return 1;
+  }
+  if (threads < 2) { threads = 2; }
+
+  size_t size = sizeof(Block) * CHUNK_VOLUME * BOX_CHUNKS;
+  Block *ref  = malloc(size);
+  Block *run  = malloc(size);
+  if (!ref || !run) {
+    fprintf(stderr, "(main): Error: malloc failed.\n");
+    return 1;
+  }
+
+  int failed = 0;
+  if (!generate_box(1, ref)) { return 1; }
+  printf("%-24s reference\n", "1 thread");
+
+  char name[64];
+  snprintf(name, sizeof(name), "%ld threads", threads);
+  if (!generate_box((size_t)threads, run)) { return 1; }
+  failed += compare(name, ref, run);
+
+  for (uint32_t s = 1; s <= SHUFFLES; s++) {
+    snprintf(name, sizeof(name), "shuffled %u, %ld threads", s, threads);
+    if (!generate_shuffled((size_t)threads, s, run)) { return 1; }
+    failed += compare(name, ref, run);
+  }
+
+  free(ref);
+  free(run);
+  return failed ? 1 : 0;
+}
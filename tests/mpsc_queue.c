@@ -0,0 +1,133 @@
+// Checks the multi-producer queue: a full queue refuses pushes until it is
+// popped, items come out in order across many laps, and items from several
+// producer threads all arrive once each, in the order each thread pushed them
+
+#include "mpsc_queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PRODUCERS 4
+#define ITEMS_PER_PRODUCER 200000
+#define SMALL_CAPACITY 64
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+          #cond);                                                     \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+typedef struct {
+  uint32_t producer;
+  uint32_t sequence;
+} Item;
+
+static void test_full(void) {
+  MpscQueue queue;
+  // Capacity rounds up to a power of 2
+  CHECK(mpsc_queue_init(&queue, 5, sizeof(int)));
+  CHECK(queue.capacity == 8);
+  for (int i = 0; i < 8; i++) { CHECK(mpsc_queue_push(&queue, &i)); }
+  int item = 8;
+  CHECK(!mpsc_queue_push(&queue, &item));
+
+  // Popping one slot frees exactly one push
+  CHECK(mpsc_queue_pop(&queue, &item) && item == 0);
+  item = 8;
+  CHECK(mpsc_queue_push(&queue, &item));
+  CHECK(!mpsc_queue_push(&queue, &item));
+  for (int i = 1; i <= 8; i++) {
+    CHECK(mpsc_queue_pop(&queue, &item) && item == i);
+  }
+  CHECK(!mpsc_queue_pop(&queue, &item));
+  mpsc_queue_free(&queue);
+}
+
+static void test_laps(void) {
+  MpscQueue queue;
+  CHECK(mpsc_queue_init(&queue, 4, sizeof(int)));
+  // Keep the queue partly full while it goes round many times
+  int next_push = 0, next_pop = 0, item;
+  for (int round = 0; round < 1000; round++) {
+    // Refill, a correct queue takes at most its capacity
+    int pushed = 0;
+    while (pushed <= 4 && mpsc_queue_push(&queue, &next_push)) {
+      next_push++;
+      pushed++;
+    }
+    CHECK(pushed <= 4);
+    for (int i = 0; i < 1 + round % 4; i++) {
+      CHECK(mpsc_queue_pop(&queue, &item) && item == next_pop);
+      next_pop++;
+    }
+  }
+  while (mpsc_queue_pop(&queue, &item)) { CHECK(item == next_pop++); }
+  CHECK(next_pop == next_push);
+  mpsc_queue_free(&queue);
+}
+
+typedef struct {
+  MpscQueue *queue;
+  uint32_t producer;
+} Producer;
+
+static void *producer_routine(void *arg) {
+  Producer *producer = arg;
+  for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+    Item item = {.producer = producer->producer, .sequence = i};
+    // The queue is small, so producers often find it full and retry
+    while (!mpsc_queue_push(producer->queue, &item)) { sched_yield(); }
+  }
+  return NULL;
+}
+
+static void test_producers(void) {
+  MpscQueue queue;
+  CHECK(mpsc_queue_init(&queue, SMALL_CAPACITY, sizeof(Item)));
+  pthread_t threads[PRODUCERS];
+  Producer producers[PRODUCERS];
+  for (uint32_t p = 0; p < PRODUCERS; p++) {
+    producers[p] = (Producer){.queue = &queue, .producer = p};
+    pthread_create(&threads[p], NULL, producer_routine, &producers[p]);
+  }
+
+  // Every producer's items must arrive in the order it pushed them. Keep
+  // draining after a failure, or the producers would wait on a full queue
+  uint32_t next[PRODUCERS] = {0};
+  size_t received         = 0;
+  while (received < (size_t)PRODUCERS * ITEMS_PER_PRODUCER) {
+    Item item;
+    if (!mpsc_queue_pop(&queue, &item)) {
+      sched_yield();
+      continue;
+    }
+    received++;
+    CHECK(item.producer < PRODUCERS);
+    if (item.producer >= PRODUCERS) { continue; }
+    CHECK(item.sequence == next[item.producer]);
+    next[item.producer] = item.sequence + 1;
+  }
+  for (int p = 0; p < PRODUCERS; p++) { pthread_join(threads[p], NULL); }
+  Item item;
+  CHECK(!mpsc_queue_pop(&queue, &item));
+  for (int p = 0; p < PRODUCERS; p++) {
+    CHECK(next[p] == ITEMS_PER_PRODUCER);
+  }
+  mpsc_queue_free(&queue);
+}
+
+int main(void) {
+  test_full();
+  test_laps();
+  // A queue that loses slots would leave the producers spinning forever
+  if (failures == 0) { test_producers(); }
+  printf("mpsc_queue               %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
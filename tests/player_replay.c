@@ -0,0 +1,211 @@
+// Replays fixed random inputs through player_update() on a fixed course of
+// steps, pits and walls, and checks every run ends where it was recorded.
+// Pins down collision, crouch edge stops, stepping and jumping, so changes to
+// the player's physics have to keep them exactly
+//
+// Usage: player_replay [-r]
+//   -r  Print the recorded table for the current physics instead of checking
+
+#include "bench_util.h"
+#include "player.h"
+#include <string.h>
+
+#define RUNS 16
+#define FRAMES 240
+#define FLOOR_Y 63
+
+// Where each run ended: position, then velocity
+static const float recorded[RUNS][6] = {
+    {-0x1.49b162p+3, 0x1.07c312p+6, 0x1.50165cp+4,
+        0x0p+0, 0x1.d958e8p+0, 0x1.a7469ap+0},
+    {0x1.9ed0b8p+4, 0x1.057474p+6, -0x1.1fe9d8p+2,
+        -0x1.ae73b6p-1, 0x1.b6e7ep+2, -0x1.81cc8p-4},
+    {-0x1.a66a52p+1, 0x1.03a0b4p+6, 0x1.8573acp+4,
+        0x0p+0, 0x0p+0, 0x1.eafep-9},
+    {-0x1.2b22d2p+4, 0x1.03ac8p+6, -0x1.d7fc0cp+4,
+        -0x1.3ec7a8p-3, 0x0p+0, -0x1.5c313ap+0},
+    {0x1.902bb8p+0, 0x1.039a4ap+6, 0x1.14e3f6p+4,
+        -0x1.ebab8ap-1, 0x0p+0, 0x0p+0},
+    {0x1.3a9364p+4, 0x1.ef717cp+5, 0x1.73133cp+4,
+        0x1.04efc2p-4, 0x0p+0, -0x1.12eeaep-6},
+    {-0x1.b5aeap+3, 0x1.f3daep+5, 0x1.89d6ep+3,
+        0x1.fbe1b8p-3, 0x1.a19898p+0, 0x0p+0},
+    {-0x1.2590c8p+5, 0x1.ef341cp+5, 0x1.5e4902p-2,
+        0x1.477c56p-4, 0x0p+0, 0x1.54bffep-1},
+    {0x1.f71406p+4, 0x1.f3107ap+5, -0x1.c5c37ap+1,
+        -0x1.2aa8dep+1, 0x1.b154a4p+2, -0x1.1bcdd8p-1},
+    {-0x1.98ef1p+2, 0x1.03a22ap+6, 0x1.acb066p+2,
+        -0x1.54c58cp+0, 0x0p+0, 0x1.b3ac96p-2},
+    {0x1.9a153cp+2, 0x1.ef4edp+5, 0x1.e604e6p+4,
+        0x1.be117cp-6, 0x0p+0, -0x1.e9a77p-5},
+    {-0x1.5da8dcp+3, 0x1.039ae4p+6, -0x1.a4d4e8p+4,
+        -0x1.34ddfcp-8, 0x0p+0, 0x0p+0},
+    {-0x1.01b3c4p+2, 0x1.07766ap+6, 0x1.a4c2f8p+1,
+        -0x1.cb1c1ep-4, 0x1.998092p+1, -0x1.3564cep-1},
+    {-0x1.591848p+1, 0x1.039adp+6, -0x1.1e5bb4p+3,
+        -0x1.91433p-3, 0x0p+0, -0x1.7fcf9cp-2},
+    {-0x1.8e8156p+3, 0x1.03b3e4p+6, -0x1.a3915cp+4,
+        -0x1.8fcc74p-5, -0x1.0b9af8p-1, 0x1.fe9ff6p-7},
+    {0x1.6578bp+4, 0x1.039d38p+6, -0x1.3512a2p+5,
+        0x1.a3baa2p-9, 0x0p+0, -0x1.78e806p-6},
+};
+// FNV-1a hash of the position, velocity and grounded flag after every frame
+static const uint64_t recorded_hash = 0xd340a3ae449d8002ull;
+
+static uint64_t rng_state = 12345;
+
+// Small xorshift RNG, so the replay is the same everywhere
+static uint32_t replay_rand(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (uint32_t)rng_state;
+}
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = data;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+// Flatten the generated terrain into a stone floor, then scatter single
+// steps, pits to crouch along and walls to slide against
+static void build_course(World *world) {
+  world_fill_region(world, BlockAir, -128, 0, -128, 159, 95, 159);
+  world_fill_region(world, BlockStone, -128, 0, -128, 159, FLOOR_Y, 159);
+  for (int i = 0; i < 1500; i++) {
+    int x    = (int)(replay_rand() % 160) - 80;
+    int z    = (int)(replay_rand() % 160) - 80;
+    int size = (int)(replay_rand() % 3);
+    switch (replay_rand() % 4) {
+    case 0: // Step up
+      world_fill_region(world,
+          BlockStone,
+          x,
+          FLOOR_Y + 1,
+          z,
+          x + size,
+          FLOOR_Y + 1,
+          z + size);
+      break;
+    case 1: // Pit
+      world_fill_region(
+          world, BlockAir, x, FLOOR_Y - 2, z, x + size, FLOOR_Y, z + size);
+      break;
+    case 2: // Wall along x
+      world_fill_region(
+          world, BlockStone, x, FLOOR_Y + 1, z, x + 6, FLOOR_Y + 3, z);
+      break;
+    default: // Wall along z
+      world_fill_region(
+          world, BlockStone, x, FLOOR_Y + 1, z, x, FLOOR_Y + 3, z + 6);
+      break;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  bool record = argc == 2 && strcmp(argv[1], "-r") == 0;
+  if (argc > 2 || (argc == 2 && !record)) {
+    fprintf(stderr, "Usage: %s [-r]\n", argv[0]);
+    return 1;
+  }
+
+  World *world = create_world_headless(3, 1);
+  if (!world) { return 1; }
+  world->mesh_chunks = false;
+  world_load_box(world, -4, 0, -4, 4, 2, 4);
+  wait_idle(world);
+  build_course(world);
+  wait_idle(world);
+
+  Player *player = create_player();
+  if (!player) { return 1; }
+
+  // Frame rates from a fast monitor down to a bad stutter
+  const float frame_times[4] = {1.f / 144.f, 1.f / 60.f, 0.05f, 0.2f};
+  uint64_t hash = 1469598103934665603ull;
+  int failed    = 0;
+  for (int run = 0; run < RUNS; run++) {
+    player->position[0] = (float)((int)(replay_rand() % 60) - 30) + 0.5f;
+    // The hitbox is centred on the position, so this is above the walls
+    player->position[1] = FLOOR_Y + 6;
+    player->position[2] = (float)((int)(replay_rand() % 60) - 30) + 0.5f;
+    glm_vec3_zero(player->velocity);
+    player->grounded = false;
+    camera_rotate(player->camera, (float)(replay_rand() % 1000) * 0.01f, 0);
+
+    for (int frame = 0; frame < FRAMES; frame++) {
+      uint32_t r = replay_rand();
+      if (r & 1) { player_forwards(player); }
+      if (r & 2) { player_left(player); }
+      if ((r & 12) == 12) { player_right(player); }
+      if ((r & 48) == 48) { player_backwards(player); }
+      player_set_crouching(player, (r >> 6) % 3 == 0);
+      player_set_sprinting(player, (r >> 8) & 1);
+      player_set_jumping(player, ((r >> 9) & 7) == 0);
+      if (((r >> 12) & 15) == 0) {
+        camera_rotate(player->camera, (float)((r >> 16) % 200) * 0.02f - 2, 0);
+      }
+      player->dt = frame_times[(r >> 24) & 3];
+      player_update(player, world);
+
+      hash = hash_bytes(hash, player->position, sizeof(vec3));
+      hash = hash_bytes(hash, player->velocity, sizeof(vec3));
+      hash = hash_bytes(hash, &player->grounded, sizeof(bool));
+    }
+
+    const float *p = player->position;
+    const float *v = player->velocity;
+    if (record) {
+      printf("    {%a, %a, %a,\n        %a, %a, %a},\n",
+          p[0],
+          p[1],
+          p[2],
+          v[0],
+          v[1],
+          v[2]);
+      continue;
+    }
+    const float *want = recorded[run];
+    if (p[0] != want[0] || p[1] != want[1] || p[2] != want[2]
+        || v[0] != want[3] || v[1] != want[4] || v[2] != want[5]) {
+      fprintf(stderr,
+          "(main): Run %d ended at (%g, %g, %g) moving (%g, %g, %g), "
+          "recorded (%g, %g, %g) moving (%g, %g, %g).\n",
+          run,
+          p[0],
+          p[1],
+          p[2],
+          v[0],
+          v[1],
+          v[2],
+          want[0],
+          want[1],
+          want[2],
+          want[3],
+          want[4],
+          want[5]);
+      failed++;
+    }
+  }
+
+  if (record) {
+    printf("recorded_hash = 0x%016llxull\n", (unsigned long long)hash);
+  } else if (hash != recorded_hash) {
+    fprintf(stderr,
+        "(main): Frame hash %016llx, recorded %016llx.\n",
+        (unsigned long long)hash,
+        (unsigned long long)recorded_hash);
+    failed++;
+  }
+  if (!record) {
+    printf("player_replay            %s\n", failed ? "FAILED" : "ok");
+  }
+
+  destroy_player(&player);
+  destroy_world(&world);
+  return failed ? 1 : 0;
+}
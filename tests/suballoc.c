@@ -0,0 +1,176 @@
+// Checks the sub-allocator: best fit allocation, release merging with the
+// free ranges either side, reset after compacting, and a long run of random
+// allocations and releases checked against a bitmap of used units
+
+#include "suballoc.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_CAPACITY 100000
+#define FUZZ_LIVE 5000
+#define FUZZ_OPS 200000
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+          #cond);                                                     \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+// Check an allocator's free list is sorted, never touching, and adds up
+static void check_free_list(const SubAllocator *alloc) {
+  size_t free = 0;
+  for (size_t i = 0; i < alloc->num_free; i++) {
+    SubRange range = alloc->free[i];
+    CHECK(range.size > 0);
+    CHECK(range.offset + range.size <= alloc->capacity);
+    if (i > 0) {
+      SubRange prev = alloc->free[i - 1];
+      CHECK(prev.offset + prev.size < range.offset);
+    }
+    free += range.size;
+  }
+  CHECK(free + alloc->used == alloc->capacity);
+}
+
+static void test_best_fit(void) {
+  SubAllocator alloc;
+  CHECK(suballoc_init(&alloc, 100));
+  size_t a, b, c, d;
+  CHECK(suballoc_alloc(&alloc, 10, &a) && a == 0);
+  CHECK(suballoc_alloc(&alloc, 30, &b) && b == 10);
+  CHECK(suballoc_alloc(&alloc, 5, &c) && c == 40);
+  CHECK(suballoc_alloc(&alloc, 20, &d) && d == 45);
+
+  // Holes of 10 at 0 and 5 at 40, plus the tail at 65. A 4 unit allocation
+  // goes in the smallest hole that fits
+  suballoc_release(&alloc, a, 10);
+  suballoc_release(&alloc, c, 5);
+  size_t e;
+  CHECK(suballoc_alloc(&alloc, 4, &e) && e == 40);
+  CHECK(suballoc_alloc(&alloc, 10, &e) && e == 0);
+  CHECK(!suballoc_alloc(&alloc, 36, &e));
+  CHECK(suballoc_alloc(&alloc, 35, &e) && e == 65);
+  CHECK(alloc.used == 99);
+  check_free_list(&alloc);
+  suballoc_free(&alloc);
+}
+
+static void test_coalesce(void) {
+  SubAllocator alloc;
+  CHECK(suballoc_init(&alloc, 40));
+  size_t offsets[4];
+  for (int i = 0; i < 4; i++) {
+    CHECK(suballoc_alloc(&alloc, 10, &offsets[i]));
+  }
+  CHECK(alloc.num_free == 0);
+
+  // Release the outer ranges, then the inner ones, which touch a free range
+  // on one side and then on both
+  suballoc_release(&alloc, offsets[0], 10);
+  suballoc_release(&alloc, offsets[3], 10);
+  CHECK(alloc.num_free == 2);
+  suballoc_release(&alloc, offsets[1], 10);
+  CHECK(alloc.num_free == 2);
+  suballoc_release(&alloc, offsets[2], 10);
+  CHECK(alloc.num_free == 1);
+  CHECK(alloc.free[0].offset == 0 && alloc.free[0].size == 40);
+  CHECK(alloc.used == 0);
+
+  SubAllocStats stats = suballoc_stats(&alloc);
+  CHECK(stats.largest_free == 40 && stats.fragmentation == 0.0f);
+  suballoc_free(&alloc);
+}
+
+static void test_reset(void) {
+  SubAllocator alloc;
+  CHECK(suballoc_init(&alloc, 64));
+  size_t offset;
+  for (int i = 0; i < 8; i++) { CHECK(suballoc_alloc(&alloc, 8, &offset)); }
+  for (size_t i = 0; i < 64; i += 16) { suballoc_release(&alloc, i, 8); }
+  SubAllocStats stats = suballoc_stats(&alloc);
+  CHECK(stats.num_free == 4 && stats.largest_free == 8);
+  CHECK(stats.fragmentation > 0.7f);
+  CHECK(!suballoc_alloc(&alloc, 16, &offset));
+
+  // The owner packs the live ranges to the front, then resets. Growing at
+  // the same time works too
+  CHECK(suballoc_reset(&alloc, 32, 128));
+  stats = suballoc_stats(&alloc);
+  CHECK(stats.capacity == 128 && stats.used == 32);
+  CHECK(stats.num_free == 1 && stats.largest_free == 96);
+  CHECK(suballoc_alloc(&alloc, 96, &offset) && offset == 32);
+  CHECK(suballoc_reset(&alloc, 128, 128));
+  CHECK(alloc.num_free == 0);
+  check_free_list(&alloc);
+  suballoc_free(&alloc);
+}
+
+// Small xorshift RNG, so the fuzz is the same every run
+static uint32_t fuzz_rand(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static void test_fuzz(void) {
+  SubAllocator alloc;
+  CHECK(suballoc_init(&alloc, FUZZ_CAPACITY));
+  static unsigned char used[FUZZ_CAPACITY];
+  static SubRange live[FUZZ_LIVE];
+  memset(used, 0, sizeof(used));
+  size_t num_live = 0;
+  uint32_t state  = 3;
+
+  for (int op = 0; op < FUZZ_OPS && failures == 0; op++) {
+    uint32_t r = fuzz_rand(&state);
+    if (num_live == 0 || (num_live < FUZZ_LIVE && (r & 1))) {
+      size_t size = 1 + (r >> 1) % 200;
+      size_t offset;
+      if (!suballoc_alloc(&alloc, size, &offset)) { continue; }
+      CHECK(offset + size <= FUZZ_CAPACITY);
+      for (size_t i = offset; i < offset + size && i < FUZZ_CAPACITY; i++) {
+        CHECK(!used[i]);
+        used[i] = 1;
+      }
+      live[num_live++] = (SubRange){offset, size};
+    } else {
+      size_t k = (r >> 1) % num_live;
+      memset(used + live[k].offset, 0, live[k].size);
+      suballoc_release(&alloc, live[k].offset, live[k].size);
+      live[k] = live[--num_live];
+    }
+
+    if (op % 1000 == 0) {
+      size_t total = 0;
+      for (size_t i = 0; i < FUZZ_CAPACITY; i++) { total += used[i]; }
+      CHECK(total == alloc.used);
+      check_free_list(&alloc);
+      for (size_t i = 0; i < alloc.num_free; i++) {
+        SubRange range = alloc.free[i];
+        for (size_t j = range.offset; j < range.offset + range.size; j++) {
+          CHECK(!used[j]);
+        }
+      }
+    }
+  }
+  suballoc_free(&alloc);
+}
+
+int main(void) {
+  test_best_fit();
+  test_coalesce();
+  test_reset();
+  test_fuzz();
+  printf("suballoc                 %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
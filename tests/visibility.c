@@ -0,0 +1,272 @@
+// Checks the occlusion culling building blocks on hand built chunks: which
+// faces a chunk's air connects (a tunnel, an L bend, a slab splitting the
+// chunk, a sealed pocket, all air and all solid), and the walk between
+// chunks, which must stop at walls, pass through tunnels, never turn back
+// towards the camera and stay inside the frustum
+
+#include "visibility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+          #cond);                                                     \
+      failures++;                                                     \
+    }                                                                 \
+  } while (0)
+
+// Check a visibility set connects exactly the pairs of faces listed, as a
+// string of face numbers in pairs, e.g. "01" for -x to +x
+static void check_pairs(uint16_t visibility, const char *pairs) {
+  uint16_t expected = VISIBILITY_NONE;
+  for (size_t i = 0; pairs[i] && pairs[i + 1]; i += 2) {
+    ChunkFace a = (ChunkFace)(pairs[i] - '0');
+    ChunkFace b = (ChunkFace)(pairs[i + 1] - '0');
+    // Build the expected set through the same bit layout
+    for (int bit = 0; bit < 15; bit++) {
+      if (visibility_connected(1u << bit, a, b)) { expected |= 1u << bit; }
+    }
+  }
+  CHECK(visibility == expected);
+  if (visibility != expected) {
+    fprintf(stderr, "  got 0x%04x, expected 0x%04x (%s)\n",
+        visibility,
+        expected,
+        pairs);
+  }
+}
+
+static Block *solid_chunk(void) {
+  Block *blocks = malloc(sizeof(Block) * CHUNK_VOLUME);
+  if (!blocks) { return NULL; }
+  for (size_t i = 0; i < CHUNK_VOLUME; i++) {
+    blocks[i] = (Block){.type = BlockStone};
+  }
+  return blocks;
+}
+
+static void carve(Block *blocks, int x0, int y0, int z0, int x1, int y1,
+    int z1) {
+  for (int x = x0; x <= x1; x++) {
+    for (int y = y0; y <= y1; y++) {
+      for (int z = z0; z <= z1; z++) {
+        blocks[CHUNK_INDEX(x, y, z)] = (Block){.type = BlockAir};
+      }
+    }
+  }
+}
+
+static void test_chunks(void) {
+  const int mid = CHUNK_HEIGHT / 2;
+
+  // All air sees through every face, all solid through none
+  Block *blocks = calloc(CHUNK_VOLUME, sizeof(Block));
+  if (!blocks) {
+    CHECK(blocks);
+    return;
+  }
+  CHECK(chunk_visibility(blocks) == VISIBILITY_ALL);
+  free(blocks);
+  blocks = solid_chunk();
+  if (!blocks) {
+    CHECK(blocks);
+    return;
+  }
+  CHECK(chunk_visibility(blocks) == VISIBILITY_NONE);
+
+  // A straight tunnel along x only connects the faces at its ends
+  carve(blocks, 0, mid, mid, CHUNK_WIDTH - 1, mid + 1, mid + 1);
+  check_pairs(chunk_visibility(blocks), "01");
+  free(blocks);
+
+  // A tunnel in from -x that turns up to +y
+  blocks = solid_chunk();
+  if (!blocks) { return; }
+  carve(blocks, 0, mid, mid, mid, mid, mid);
+  carve(blocks, mid, mid, mid, mid, CHUNK_HEIGHT - 1, mid);
+  check_pairs(chunk_visibility(blocks), "03");
+  free(blocks);
+
+  // A slab across the middle leaves air above and below, both touching the
+  // side faces, but nothing joins -y to +y
+  blocks = calloc(CHUNK_VOLUME, sizeof(Block));
+  if (!blocks) { return; }
+  for (int x = 0; x < CHUNK_WIDTH; x++) {
+    for (int z = 0; z < CHUNK_LENGTH; z++) {
+      blocks[CHUNK_INDEX(x, mid, z)] = (Block){.type = BlockStone};
+    }
+  }
+  check_pairs(chunk_visibility(blocks),
+      "01" "04" "05" "14" "15" "45" "02" "12" "24" "25" "03" "13" "34" "35");
+  free(blocks);
+
+  // A pocket of air that never reaches a face connects nothing
+  blocks = solid_chunk();
+  if (!blocks) { return; }
+  carve(blocks, 4, 4, 4, CHUNK_WIDTH - 5, CHUNK_HEIGHT - 5, CHUNK_LENGTH - 5);
+  CHECK(chunk_visibility(blocks) == VISIBILITY_NONE);
+  free(blocks);
+}
+
+// A box of chunks for the walk, each with a visibility set, and whether the
+// walk reached it
+#define GRID 5
+
+typedef struct {
+  uint16_t visibility[GRID][GRID][GRID];
+  int reached[GRID][GRID][GRID];
+} WalkGrid;
+
+static uint16_t visit_grid(void *data, const int coords[3]) {
+  WalkGrid *grid = data;
+  grid->reached[coords[0]][coords[1]][coords[2]]++;
+  return grid->visibility[coords[0]][coords[1]][coords[2]];
+}
+
+static void grid_reset(WalkGrid *grid) {
+  for (int x = 0; x < GRID; x++) {
+    for (int y = 0; y < GRID; y++) {
+      for (int z = 0; z < GRID; z++) {
+        grid->visibility[x][y][z] = VISIBILITY_ALL;
+        grid->reached[x][y][z]    = 0;
+      }
+    }
+  }
+}
+
+static void test_walk(void) {
+  static WalkGrid grid;
+  OcclusionWalk walk = {0};
+  const int min[3] = {0, 0, 0}, max[3] = {GRID - 1, GRID - 1, GRID - 1};
+
+  // Open air reaches every chunk, each exactly once
+  grid_reset(&grid);
+  int camera[3] = {2, 2, 0};
+  CHECK(occlusion_walk(&walk, camera, min, max, NULL, visit_grid, &grid));
+  for (int x = 0; x < GRID; x++) {
+    for (int y = 0; y < GRID; y++) {
+      for (int z = 0; z < GRID; z++) { CHECK(grid.reached[x][y][z] == 1); }
+    }
+  }
+
+  // A solid wall across z = 2 is reached, but hides everything behind it
+  grid_reset(&grid);
+  for (int x = 0; x < GRID; x++) {
+    for (int y = 0; y < GRID; y++) {
+      grid.visibility[x][y][2] = VISIBILITY_NONE;
+    }
+  }
+  CHECK(occlusion_walk(&walk, camera, min, max, NULL, visit_grid, &grid));
+  for (int x = 0; x < GRID; x++) {
+    for (int y = 0; y < GRID; y++) {
+      CHECK(grid.reached[x][y][2] == 1);
+      CHECK(grid.reached[x][y][3] == 0);
+      CHECK(grid.reached[x][y][4] == 0);
+    }
+  }
+
+  // A gap at the end of the wall shows what is behind the gap, but not what
+  // is behind the middle of the wall, which would need a turn back towards
+  // the camera
+  grid_reset(&grid);
+  for (int x = 0; x < GRID - 1; x++) {
+    for (int y = 0; y < GRID; y++) {
+      grid.visibility[x][y][2] = VISIBILITY_NONE;
+    }
+  }
+  CHECK(occlusion_walk(&walk, camera, min, max, NULL, visit_grid, &grid));
+  CHECK(grid.reached[4][2][3] == 1);
+  CHECK(grid.reached[4][2][4] == 1);
+  CHECK(grid.reached[3][2][3] == 0);
+  CHECK(grid.reached[2][2][3] == 0);
+
+  // A tunnel through the wall lets the walk through that one chunk
+  grid_reset(&grid);
+  for (int x = 0; x < GRID; x++) {
+    for (int y = 0; y < GRID; y++) {
+      grid.visibility[x][y][2] = VISIBILITY_NONE;
+    }
+  }
+  Block *blocks = solid_chunk();
+  if (!blocks) {
+    CHECK(blocks);
+    return;
+  }
+  carve(blocks, 15, 15, 0, 16, 16, CHUNK_LENGTH - 1);
+  grid.visibility[2][2][2] = chunk_visibility(blocks);
+  free(blocks);
+  CHECK(occlusion_walk(&walk, camera, min, max, NULL, visit_grid, &grid));
+  CHECK(grid.reached[2][2][3] == 1);
+  CHECK(grid.reached[1][2][3] == 1);
+  CHECK(grid.reached[1][2][4] == 1);
+  CHECK(grid.reached[1][1][3] == 1);
+  CHECK(grid.reached[1][2][2] == 1); // The wall beside the tunnel is seen
+  CHECK(grid.reached[0][0][3] == 1); // and the walk spreads out past it
+
+  // A chunk whose air joins -z to +x, entered from -z, lets the walk turn
+  // towards +x but not -x. Everything else is solid, so the chunk at -x
+  // could only be reached through the bend
+  grid_reset(&grid);
+  for (int x = 0; x < GRID; x++) {
+    for (int y = 0; y < GRID; y++) {
+      for (int z = 0; z < GRID; z++) {
+        grid.visibility[x][y][z] = VISIBILITY_NONE;
+      }
+    }
+  }
+  blocks = solid_chunk();
+  if (!blocks) {
+    CHECK(blocks);
+    return;
+  }
+  carve(blocks, 16, 16, 0, 16, 16, 16);
+  carve(blocks, 16, 16, 16, CHUNK_WIDTH - 1, 16, 16);
+  grid.visibility[2][2][1] = chunk_visibility(blocks);
+  free(blocks);
+  check_pairs(grid.visibility[2][2][1], "41");
+  grid.visibility[1][2][1] = VISIBILITY_ALL;
+  grid.visibility[3][2][1] = VISIBILITY_ALL;
+  grid.visibility[4][2][1] = VISIBILITY_ALL;
+  CHECK(occlusion_walk(&walk, camera, min, max, NULL, visit_grid, &grid));
+  CHECK(grid.reached[2][2][1] == 1);
+  CHECK(grid.reached[3][2][1] == 1);
+  CHECK(grid.reached[4][2][1] == 1);
+  CHECK(grid.reached[1][2][1] == 0);
+  CHECK(grid.reached[2][2][2] == 0);
+
+  // Only x > CHUNK_WIDTH is in view, so the walk never enters chunk x = 0
+  grid_reset(&grid);
+  vec4 planes[6] = {{1, 0, 0, -CHUNK_WIDTH - 1},
+      {0, 0, 0, 1},
+      {0, 0, 0, 1},
+      {0, 0, 0, 1},
+      {0, 0, 0, 1},
+      {0, 0, 0, 1}};
+  CHECK(occlusion_walk(&walk, camera, min, max, planes, visit_grid, &grid));
+  for (int y = 0; y < GRID; y++) {
+    for (int z = 0; z < GRID; z++) {
+      CHECK(grid.reached[0][y][z] == 0);
+      CHECK(grid.reached[1][y][z] == 1);
+    }
+  }
+
+  // A camera outside the box has nowhere to start from
+  grid_reset(&grid);
+  int outside[3] = {GRID, 0, 0};
+  CHECK(!occlusion_walk(&walk, outside, min, max, NULL, visit_grid, &grid));
+  CHECK(grid.reached[GRID - 1][0][0] == 0);
+
+  occlusion_walk_free(&walk);
+}
+
+int main(void) {
+  test_chunks();
+  test_walk();
+  printf("visibility               %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
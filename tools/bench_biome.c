@@ -0,0 +1,91 @@
+// Measures what the biome layer adds to generation. Generates a box of chunk
+// columns on one thread, then fills the same chunks' biome columns on their
+// own with a new seed, so the biome cache starts as cold as it did during
+// generation, and reports the biome share of generate_chunk(). Each is timed
+// a few times with new seeds and the fastest round is kept
+//
+// Usage: bench_biome [radius]
+//   radius  Half the width of the box in chunks (default: 6)
+
+#include "bench_util.h"
+#include "biome.h"
+#include "chunk.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SEED 1234
+#define ROUNDS 3
+#define MIN_Y -1 // Chunk layers generated in every column, surface included
+#define MAX_Y 4
+// Biome lookups should stay under this share of generate_chunk()
+#define TARGET 0.1
+
+// Generate every chunk in the box on this thread, returns the time taken or
+// -1 on failure. Layers go innermost, like chunks load, so the biome cache
+// sees each column's layers back to back
+static double time_generate(int radius, uint32_t seed, size_t *num_chunks) {
+  *num_chunks  = 0;
+  double start = get_time();
+  for (int x = -radius; x < radius; x++) {
+    for (int z = -radius; z < radius; z++) {
+      for (int y = MIN_Y; y <= MAX_Y; y++) {
+        Chunk *chunk = create_chunk(x, y, z);
+        if (!chunk) {
+          fprintf(stderr,
+              "(time_generate): Error: create_chunk() returned NULL.\n");
+          return -1;
+        }
+        generate_chunk(chunk, seed, NULL);
+        destroy_chunk(&chunk);
+        (*num_chunks)++;
+      }
+    }
+  }
+  return get_time() - start;
+}
+
+// Fill the biome columns of every chunk in the box, the way generation does
+static double time_biomes(int radius, uint32_t seed) {
+  float base[CHUNK_AREA];
+  float scale[CHUNK_AREA];
+  BiomeType biomes[CHUNK_AREA];
+  double start = get_time();
+  for (int x = -radius; x < radius; x++) {
+    for (int z = -radius; z < radius; z++) {
+      for (int y = MIN_Y; y <= MAX_Y; y++) {
+        biome_fill_columns(x, z, seed, base, scale, biomes);
+      }
+    }
+  }
+  return get_time() - start;
+}
+
+int main(int argc, char **argv) {
+  int radius = argc > 1 ? atoi(argv[1]) : 6;
+  if (argc > 2 || radius < 1) {
+    fprintf(stderr, "Usage: %s [radius]\n", argv[0]);
+    return 1;
+  }
+
+  double generate = 0, biome = 0;
+  size_t num_chunks = 0;
+  for (uint32_t round = 0; round < ROUNDS; round++) {
+    double time = time_generate(radius, SEED + 2 * round, &num_chunks);
+    if (time < 0) { return 1; }
+    if (round == 0 || time < generate) { generate = time; }
+    time = time_biomes(radius, SEED + 2 * round + 1);
+    if (round == 0 || time < biome) { biome = time; }
+  }
+  generate /= (double)num_chunks;
+  biome /= (double)num_chunks;
+
+  double share = biome / generate;
+  printf("generate_chunk()      %8.3f ms per chunk (%zu chunks)\n",
+      generate * 1e3,
+      num_chunks);
+  printf("biome_fill_columns()  %8.3f ms per chunk, %.1f%% of generation%s\n",
+      biome * 1e3,
+      share * 100.0,
+      share < TARGET ? "" : ", over the target");
+  return 0;
+}
@@ -0,0 +1,110 @@
+// Measures carve latency against radius. Fills a block of stone in a loaded
+// world, carves a sphere out of it, and times how long world_carve_sphere()
+// takes to return and how long the queue then takes to remesh what it
+// touched. Each radius is carved a few times at nearby centres and the
+// averages are reported, followed by a capsule dug like a tunnel
+//
+// Usage: bench_carve [-t threads]
+
+#include "bench_util.h"
+#include "world.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SEED 3
+#define CARVES 5 // Carves timed at each radius
+
+static const float radii[] = {2, 4, 8, 16, 32};
+
+#define NUM_RADII (sizeof(radii) / sizeof(radii[0]))
+
+// Fill the box a carve of a radius could reach with stone, so every carve
+// has as much to do, and let the remeshing finish before timing
+static void fill_stone(World *world, const vec3 a, const vec3 b, float radius) {
+  int r = (int)ceilf(radius) + 1;
+  world_fill_region(world,
+      BlockStone,
+      (int)floorf(fminf(a[0], b[0])) - r,
+      (int)floorf(fminf(a[1], b[1])) - r,
+      (int)floorf(fminf(a[2], b[2])) - r,
+      (int)floorf(fmaxf(a[0], b[0])) + r,
+      (int)floorf(fmaxf(a[1], b[1])) + r,
+      (int)floorf(fmaxf(a[2], b[2])) + r);
+  wait_idle(world);
+}
+
+// Carve a capsule, or a sphere when a and b are the same, and print the
+// averages over a few carves
+static void time_carves(
+    World *world, const char *name, vec3 a, vec3 b, float radius) {
+  bool sphere   = memcmp(a, b, sizeof(vec3)) == 0;
+  double carve  = 0, remesh = 0;
+  size_t blocks = 0;
+  for (int i = 0; i < CARVES; i++) {
+    // Move the centre a little each time, so carves land on the chunk grid
+    // differently
+    vec3 offset = {(float)i * 3.1f, 0, (float)i * 1.7f};
+    vec3 start_point, end_point;
+    glm_vec3_add(a, offset, start_point);
+    glm_vec3_add(b, offset, end_point);
+    fill_stone(world, start_point, end_point, radius);
+
+    double start = get_time();
+    if (sphere) {
+      blocks += world_carve_sphere(world, start_point, radius);
+    } else {
+      blocks += world_carve_capsule(world, start_point, end_point, radius);
+    }
+    double carved = get_time();
+    wait_idle(world);
+    carve += carved - start;
+    remesh += get_time() - carved;
+  }
+  printf("%-16s %9zu %10.3f %10.3f %12.3f\n",
+      name,
+      blocks / CARVES,
+      carve / CARVES * 1e3,
+      remesh / CARVES * 1e3,
+      carve / (double)blocks * 1e9);
+}
+
+int main(int argc, char **argv) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (argc == 3 && strcmp(argv[1], "-t") == 0) {
+    threads = atol(argv[2]);
+  } else if (argc != 1) {
+    fprintf(stderr, "Usage: %s [-t threads]\n", argv[0]);
+    return 1;
+  }
+  if (threads < 1) { threads = 1; }
+
+  World *world = create_world_headless(SEED, (size_t)threads);
+  if (!world) {
+    fprintf(stderr, "(main): Error: create_world_headless() returned NULL.\n");
+    return 1;
+  }
+  world_load_box(world, -3, 0, -3, 3, 4, 3);
+  wait_idle(world);
+
+  printf("%ld threads, averages over %d carves\n", threads, CARVES);
+  printf("%-16s %9s %10s %10s %12s\n",
+      "carve",
+      "blocks",
+      "carve ms",
+      "remesh ms",
+      "ns per block");
+  vec3 centre = {0.5f, 64.f, 0.5f};
+  for (size_t r = 0; r < NUM_RADII; r++) {
+    char name[32];
+    snprintf(name, sizeof(name), "sphere r %g", radii[r]);
+    time_carves(world, name, centre, centre, radii[r]);
+  }
+  // A tunnel sloping down, 48 blocks long
+  vec3 tunnel_end = {40.5f, 40.f, 24.5f};
+  time_carves(world, "capsule r 3", centre, tunnel_end, 3);
+
+  destroy_world(&world);
+  return 0;
+}
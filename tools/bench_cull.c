@@ -0,0 +1,136 @@
+// Measures frustum culling. Fills a render list with a cube of chunks at
+// render distances 8, 16 and 32, about half of them holding a mesh like
+// loaded terrain does, then turns a camera through a full circle and times
+// render_list_cull() each frame against testing every chunk on its own with
+// glm_aabb_frustum(). Both report how many chunks they kept, which can differ
+// by a chunk touching a plane, as they round differently. Meshes are
+// uploaded, so it opens a hidden window for a GL context. Not run by
+// `make bench`, build it with `make tools/bench_cull`
+//
+// Usage: bench_cull [frames]
+//   frames  Frames timed at each render distance (default: 240)
+
+#include "bench_util.h"
+#include "camera.h"
+#include "render_list.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_DISTANCES 3
+
+static const int distances[NUM_DISTANCES] = {8, 16, 32};
+
+// Pick about half the chunks, scattered, to hold a mesh
+static bool chunk_has_mesh(int x, int y, int z) {
+  uint32_t hash = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u
+                  ^ (uint32_t)z * 83492791u;
+  hash ^= hash >> 13;
+  hash *= 0x5bd1e995u;
+  return (hash ^ (hash >> 15)) & 1;
+}
+
+// Fill a list with every meshed chunk in a cube of chunk coords around 0,
+// returns the number published
+static size_t fill_list(RenderList *list, int distance) {
+  // One face is enough, culling never looks at the vertices
+  Vertex vertices[6] = {0};
+  size_t num_chunks  = 0;
+  for (int x = -distance; x <= distance; x++) {
+    for (int y = -distance; y <= distance; y++) {
+      for (int z = -distance; z <= distance; z++) {
+        if (!chunk_has_mesh(x, y, z)) { continue; }
+        int coords[3] = {x, y, z};
+        render_list_publish(list, coords, vertices, 6, NULL, 0, 0);
+        num_chunks++;
+      }
+    }
+  }
+  return num_chunks;
+}
+
+// Test every record against the frustum on its own, the way culling worked
+// before records were grouped. Returns the number inside
+static size_t cull_each(const RenderList *list, vec4 planes[6]) {
+  size_t visible = 0;
+  for (size_t g = 0; g < list->num_groups; g++) {
+    uint64_t mask = list->groups[g].mask;
+    while (mask) {
+      size_t i = g * RENDER_GROUP_CHUNKS + (size_t)__builtin_ctzll(mask);
+      mask &= mask - 1;
+      vec3 box[2] = {{list->min_x[i], list->min_y[i], list->min_z[i]},
+          {list->min_x[i] + CHUNK_WIDTH,
+              list->min_y[i] + CHUNK_HEIGHT,
+              list->min_z[i] + CHUNK_LENGTH}};
+      visible += glm_aabb_frustum(box, planes);
+    }
+  }
+  return visible;
+}
+
+int main(int argc, char **argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 240;
+  if (argc > 2 || frames < 1) {
+    fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+    return 1;
+  }
+
+  nu_Window *window = nu_create_window(64, 64, NULL, false);
+  if (!window) {
+    fprintf(stderr, "(main): Error: nu_create_window() returned NULL.\n");
+    return 1;
+  }
+  glfwHideWindow(window->glfw_window);
+
+  printf("distance  chunks  grouped us/frame (visible)  "
+         "per chunk us/frame (visible)\n");
+  int status = 0;
+  for (int d = 0; d < NUM_DISTANCES; d++) {
+    int distance = distances[d];
+    RenderList list;
+    render_list_init(&list);
+    size_t num_chunks = fill_list(&list, distance);
+
+    // Far enough to see the corners of the cube
+    Camera *camera = create_camera(0.1f, distance * CHUNK_WIDTH * 1.8f, 90);
+    if (!camera) {
+      render_list_free(&list);
+      status = 1;
+      break;
+    }
+    glm_vec3_copy((vec3){7.5f, 40.f, -3.f}, camera->position);
+
+    double grouped = 0, each = 0;
+    size_t grouped_visible = 0, each_visible = 0;
+    for (int frame = 0; frame < frames; frame++) {
+      camera->yaw   = glm_rad(360.f * (float)frame / (float)frames);
+      camera->pitch = glm_rad(30.f * sinf((float)frame * 0.05f));
+      mat4 vp;
+      camera_calculate_vp_matrix(camera, vp, 16.f / 9.f);
+      vec4 planes[6];
+      glm_frustum_planes(vp, planes);
+
+      double start = get_time();
+      render_list_cull(&list, planes);
+      grouped += get_time() - start;
+
+      grouped_visible += list.num_visible;
+
+      start = get_time();
+      each_visible += cull_each(&list, planes);
+      each += get_time() - start;
+    }
+    printf("%8d  %6zu  %16.1f (%7zu)  %18.1f (%7zu)\n",
+        distance,
+        num_chunks,
+        grouped / frames * 1e6,
+        grouped_visible / (size_t)frames,
+        each / frames * 1e6,
+        each_visible / (size_t)frames);
+
+    destroy_camera(&camera);
+    render_list_free(&list);
+  }
+
+  nu_destroy_window(&window);
+  return status;
+}
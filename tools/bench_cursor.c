@@ -0,0 +1,142 @@
+// Measures block queries the way collision makes them: every block of a
+// player sized box, for boxes scattered over a loaded world and for boxes a
+// small step apart along a walk. Each box is read with world_get_block(),
+// with a cursor, and with one world_cursor_any_solid() call, and each rate
+// is reported in blocks queried per second
+//
+// Usage: bench_cursor [boxes]
+//   boxes  Boxes read by each method on each path (default: 1000000)
+
+#include "bench_util.h"
+#include "world.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SEED 11
+// A cursor lives for one player update, which reads a few dozen boxes
+#define BOXES_PER_CURSOR 64
+
+typedef enum { METHOD_GET_BLOCK, METHOD_CURSOR, METHOD_ANY_SOLID } Method;
+
+static const char *method_names[] = {
+    "world_get_block()", "cursor", "world_cursor_any_solid()"};
+
+static uint64_t rng_state;
+
+static float rand_float(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (float)(uint32_t)rng_state / 4294967296.f;
+}
+
+// Move to the next box centre, scattered at random or a step along a walk
+static void next_box(bool walk, vec3 pos) {
+  if (!walk) {
+    pos[0] = rand_float() * 120 - 60;
+    pos[1] = rand_float() * 60 + 30;
+    pos[2] = rand_float() * 120 - 60;
+    return;
+  }
+  pos[0] += 0.05f;
+  if (pos[0] > 60) {
+    pos[0] = -60;
+    pos[2] = pos[2] > 58 ? -60 : pos[2] + 1.3f;
+  }
+}
+
+// Read every block of a box, returns the number of solid ones, or for
+// METHOD_ANY_SOLID whether there are any
+static size_t read_box(World *world, WorldCursor *cursor, Method method,
+    const vec3 pos, size_t *num_queries) {
+  int lo[3] = {(int)floorf(pos[0] - 0.3f),
+      (int)floorf(pos[1] - 0.9f),
+      (int)floorf(pos[2] - 0.3f)};
+  int hi[3] = {(int)floorf(pos[0] + 0.3f),
+      (int)floorf(pos[1] + 0.9f),
+      (int)floorf(pos[2] + 0.3f)};
+  size_t volume = (size_t)(hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1)
+                  * (hi[2] - lo[2] + 1);
+  *num_queries += volume;
+  if (method == METHOD_ANY_SOLID) {
+    return world_cursor_any_solid(cursor, lo, hi);
+  }
+
+  size_t solid = 0;
+  for (int x = lo[0]; x <= hi[0]; x++) {
+    for (int y = lo[1]; y <= hi[1]; y++) {
+      for (int z = lo[2]; z <= hi[2]; z++) {
+        Block *block = method == METHOD_GET_BLOCK
+                           ? world_get_block(world, x, y, z)
+                           : world_cursor_get_block(cursor, x, y, z);
+        solid += block && block->type != BlockAir;
+      }
+    }
+  }
+  return solid;
+}
+
+// Read a path of boxes with one method, returns a checksum of what it found
+static size_t run(World *world, Method method, bool walk, size_t num_boxes) {
+  rng_state = 88172645463325252ull;
+  vec3 pos  = {-60, 60, -40};
+  WorldCursor cursor;
+  world_cursor_init(&cursor, world);
+  size_t num_queries = 0, num_lookups = 0, checksum = 0;
+  double start = get_time();
+  for (size_t i = 0; i < num_boxes; i++) {
+    if (i > 0 && i % BOXES_PER_CURSOR == 0) {
+      num_lookups += cursor.num_lookups;
+      world_cursor_init(&cursor, world);
+    }
+    next_box(walk, pos);
+    // world_cursor_any_solid() only says whether there are any
+    checksum += read_box(world, &cursor, method, pos, &num_queries) > 0;
+  }
+  double elapsed = get_time() - start;
+  num_lookups += cursor.num_lookups;
+
+  printf("%-8s %-26s %8.1f M blocks/s",
+      walk ? "walk" : "scatter",
+      method_names[method],
+      (double)num_queries / elapsed / 1e6);
+  if (method != METHOD_GET_BLOCK) {
+    printf(", %.4f map lookups per block",
+        (double)num_lookups / (double)num_queries);
+  }
+  printf("\n");
+  return checksum;
+}
+
+int main(int argc, char **argv) {
+  long num_boxes = argc > 1 ? atol(argv[1]) : 1000000;
+  if (argc > 2 || num_boxes < 1) {
+    fprintf(stderr, "Usage: %s [boxes]\n", argv[0]);
+    return 1;
+  }
+
+  World *world = create_world_headless(SEED, 1);
+  if (!world) {
+    fprintf(stderr, "(main): Error: create_world_headless() returned NULL.\n");
+    return 1;
+  }
+  world->mesh_chunks = false;
+  world_load_box(world, -2, 0, -2, 2, 3, 2);
+  wait_idle(world);
+
+  int status = 0;
+  for (int walk = 0; walk < 2; walk++) {
+    size_t expected = run(world, METHOD_GET_BLOCK, walk, (size_t)num_boxes);
+    for (Method method = METHOD_CURSOR; method <= METHOD_ANY_SOLID; method++) {
+      if (run(world, method, walk, (size_t)num_boxes) != expected) {
+        fprintf(stderr,
+            "(main): %s disagreed with world_get_block().\n",
+            method_names[method]);
+        status = 1;
+      }
+    }
+  }
+
+  destroy_world(&world);
+  return status;
+}
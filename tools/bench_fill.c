@@ -0,0 +1,204 @@
+// Measures large edits. Runs the same fills, a replace and an edit list on
+// two copies of a loaded world, one through world_set_block() a block at a
+// time and one through the region APIs, and reports how long each took to
+// apply, how many times it asked for a chunk to be remeshed and how many
+// chunks that queued, and how long the queue took to remesh them. The two
+// worlds must end up with the same blocks
+//
+// Usage: bench_fill
+
+#include "bench_util.h"
+#include "world.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SEED 3
+
+// Inclusive box of chunk coords both worlds load
+static const int box[6] = {-3, 0, -3, 3, 4, 3};
+
+typedef enum { EDIT_FILL, EDIT_REPLACE, EDIT_LIST } EditKind;
+
+typedef struct {
+  const char *name;
+  EditKind kind;
+  int lo[3], hi[3];
+  BlockType from, to; // from is only used by replaces
+} Edit;
+
+static const Edit edits[] = {
+    {"fill 22^3 stone", EDIT_FILL, {-11, 50, -11}, {10, 71, 10}, 0, BlockStone},
+    {"fill 22^3 air", EDIT_FILL, {-11, 50, -11}, {10, 71, 10}, 0, BlockAir},
+    {"fill 64^3 air", EDIT_FILL, {-40, 40, -20}, {23, 103, 43}, 0, BlockAir},
+    {"replace 64^3 stone", EDIT_REPLACE, {-60, 20, -60}, {3, 83, 3}, BlockStone,
+        BlockSand},
+    {"edit list, 2 spheres", EDIT_LIST, {0}, {0}, 0, 0},
+};
+
+#define NUM_EDITS (sizeof(edits) / sizeof(edits[0]))
+
+static World *load_world(void) {
+  World *world = create_world_headless(SEED, 1);
+  if (!world) {
+    fprintf(stderr,
+        "(load_world): Error: create_world_headless() returned NULL.\n");
+    return NULL;
+  }
+  world_load_box(world, box[0], box[1], box[2], box[3], box[4], box[5]);
+  wait_idle(world);
+  return world;
+}
+
+// A sphere of logs with a smaller sphere of air carved out of it, so later
+// edits overwrite earlier ones
+static bool make_edit_list(EditList *list) {
+  for (int pass = 0; pass < 2; pass++) {
+    int radius = pass ? 8 : 14;
+    for (int x = -radius; x <= radius; x++) {
+      for (int y = -radius; y <= radius; y++) {
+        for (int z = -radius; z <= radius; z++) {
+          if (x * x + y * y + z * z > radius * radius) { continue; }
+          BlockEdit edit = {x + 30, y + 75, z - 30, pass ? BlockAir : BlockLog};
+          if (!edit_list_push(list, edit)) { return false; }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Apply an edit a block at a time, the way callers did before the region APIs
+static void apply_each(World *world, const Edit *edit, const EditList *list) {
+  if (edit->kind == EDIT_LIST) {
+    for (size_t i = 0; i < list->num_edits; i++) {
+      const BlockEdit *e = &list->edits[i];
+      world_set_block(world, e->type, e->x, e->y, e->z);
+    }
+    return;
+  }
+  for (int y = edit->lo[1]; y <= edit->hi[1]; y++) {
+    for (int x = edit->lo[0]; x <= edit->hi[0]; x++) {
+      for (int z = edit->lo[2]; z <= edit->hi[2]; z++) {
+        if (edit->kind == EDIT_REPLACE) {
+          Block *block = world_get_block(world, x, y, z);
+          if (!block || block->type != edit->from) { continue; }
+        }
+        world_set_block(world, edit->to, x, y, z);
+      }
+    }
+  }
+}
+
+static void apply_region(World *world, const Edit *edit, const EditList *list) {
+  const int *lo = edit->lo, *hi = edit->hi;
+  switch (edit->kind) {
+  case EDIT_FILL:
+    world_fill_region(
+        world, edit->to, lo[0], lo[1], lo[2], hi[0], hi[1], hi[2]);
+    break;
+  case EDIT_REPLACE:
+    world_replace_region(world,
+        edit->from,
+        edit->to,
+        lo[0],
+        lo[1],
+        lo[2],
+        hi[0],
+        hi[1],
+        hi[2]);
+    break;
+  case EDIT_LIST: world_apply_edit_list(world, list); break;
+  }
+}
+
+// Apply an edit and wait for the remeshing it queued, printing the times
+static void time_edit(World *world, const Edit *edit, const EditList *list,
+    bool region) {
+  WorldStats before = world_get_stats(world);
+  double start      = get_time();
+  if (region) {
+    apply_region(world, edit, list);
+  } else {
+    apply_each(world, edit, list);
+  }
+  double applied = get_time();
+  wait_idle(world);
+  double remeshed  = get_time();
+  WorldStats after = world_get_stats(world);
+  // Requests that found their chunk already queued were coalesced
+  size_t queued   = after.num_pushed - before.num_pushed;
+  size_t requests = queued + after.num_coalesced - before.num_coalesced;
+  printf("  %-17s %8.2f ms apply, %6zu requests, %3zu queued, "
+         "%6.2f ms remesh\n",
+      region ? "region" : "world_set_block()",
+      (applied - start) * 1e3,
+      requests,
+      queued,
+      (remeshed - applied) * 1e3);
+}
+
+// Check both worlds hold the same blocks, returns the number of chunks that
+// differ
+static size_t compare_worlds(World *a, World *b) {
+  size_t differ = 0;
+  for (int x = box[0]; x <= box[3]; x++) {
+    for (int y = box[1]; y <= box[4]; y++) {
+      for (int z = box[2]; z <= box[5]; z++) {
+        Chunk *ca = world_get_chunk(
+            a, x * CHUNK_WIDTH, y * CHUNK_HEIGHT, z * CHUNK_LENGTH);
+        Chunk *cb = world_get_chunk(
+            b, x * CHUNK_WIDTH, y * CHUNK_HEIGHT, z * CHUNK_LENGTH);
+        if (!ca || !cb || !ca->blocks || !cb->blocks) {
+          differ += (ca && ca->blocks) != (cb && cb->blocks);
+          continue;
+        }
+        for (size_t i = 0; i < CHUNK_VOLUME; i++) {
+          if (ca->blocks[i].type != cb->blocks[i].type) {
+            differ++;
+            break;
+          }
+        }
+      }
+    }
+  }
+  return differ;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    fprintf(stderr, "Usage: %s\n", argv[0]);
+    return 1;
+  }
+
+  World *each   = load_world();
+  World *region = load_world();
+  EditList list = {0};
+  if (!each || !region || !make_edit_list(&list)) { return 1; }
+
+  int status = 0;
+  for (size_t e = 0; e < NUM_EDITS; e++) {
+    const Edit *edit = &edits[e];
+    size_t blocks    = list.num_edits;
+    if (edit->kind != EDIT_LIST) {
+      blocks = (size_t)(edit->hi[0] - edit->lo[0] + 1)
+               * (edit->hi[1] - edit->lo[1] + 1)
+               * (edit->hi[2] - edit->lo[2] + 1);
+    }
+    printf("%s, %zu blocks\n", edit->name, blocks);
+    time_edit(each, edit, &list, false);
+    time_edit(region, edit, &list, true);
+    size_t differ = compare_worlds(each, region);
+    if (differ > 0) {
+      fprintf(stderr,
+          "(main): %zu chunks differ between the worlds after %s.\n",
+          differ,
+          edit->name);
+      status = 1;
+    }
+  }
+
+  edit_list_free(&list);
+  destroy_world(&each);
+  destroy_world(&region);
+  return status;
+}
@@ -0,0 +1,212 @@
+// Measures occlusion culling. Generates and meshes a box of chunks, then
+// turns a camera through a full circle from a few places (on the surface,
+// looking down from the sky, buried in stone) and counts the meshed chunks
+// in the frustum, which is what is drawn without occlusion, against those
+// the occlusion walk also reaches. Reports both counts and the time per walk
+//
+// Usage: bench_occlusion [distance]
+//   distance  Chunks loaded around the origin in every direction (default: 6)
+
+#include "bench_util.h"
+#include "camera.h"
+#include "visibility.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEED 3
+#define FRAMES 16 // Camera directions around the circle at each place
+
+typedef struct {
+  const char *name;
+  float height; // Eye height above the ground, or below it if negative
+  float pitch;  // Degrees, negative looks down
+} View;
+
+static const View views[] = {
+    {"surface, level", 2.f, 0.f},
+    {"surface, looking down", 2.f, -30.f},
+    {"sky, looking down", 120.f, -60.f},
+    {"buried in stone", -40.f, 0.f},
+};
+
+#define NUM_VIEWS (sizeof(views) / sizeof(views[0]))
+
+// Every chunk of the box, the way the render list sees it
+typedef struct {
+  int min[3], size[3];
+  size_t cells;
+  bool *meshed;         // Whether the chunk has anything to draw
+  uint16_t *visibility; // Which of its faces see each other
+  bool *reached;        // Whether the last walk reached it
+} ChunkGrid;
+
+static size_t grid_index(const ChunkGrid *grid, const int c[3]) {
+  return (size_t)(c[0] - grid->min[0])
+         + ((size_t)(c[1] - grid->min[1])
+               + (size_t)(c[2] - grid->min[2]) * grid->size[1])
+               * grid->size[0];
+}
+
+// Chunks without a mesh are open air to the walk, like in the render list
+static uint16_t visit_chunk(void *data, const int coords[3]) {
+  ChunkGrid *grid = data;
+  size_t i        = grid_index(grid, coords);
+  grid->reached[i] = true;
+  return grid->meshed[i] ? grid->visibility[i] : VISIBILITY_ALL;
+}
+
+// Copy what culling needs out of the loaded world, returns the number of
+// meshed chunks, or 0 on failure
+static size_t fill_grid(World *world, int distance, ChunkGrid *grid) {
+  grid->cells = 1;
+  for (int i = 0; i < 3; i++) {
+    grid->min[i]  = -distance;
+    grid->size[i] = distance * 2 + 1;
+    grid->cells *= (size_t)grid->size[i];
+  }
+  grid->meshed     = calloc(grid->cells, sizeof(bool));
+  grid->visibility = calloc(grid->cells, sizeof(uint16_t));
+  grid->reached    = calloc(grid->cells, sizeof(bool));
+  if (!grid->meshed || !grid->visibility || !grid->reached) {
+    fprintf(stderr, "(fill_grid): Error: calloc failed.\n");
+    return 0;
+  }
+
+  size_t num_meshed = 0;
+  int c[3];
+  for (c[0] = -distance; c[0] <= distance; c[0]++) {
+    for (c[1] = -distance; c[1] <= distance; c[1]++) {
+      for (c[2] = -distance; c[2] <= distance; c[2]++) {
+        Chunk *chunk = world_get_chunk(world,
+            c[0] * CHUNK_WIDTH,
+            c[1] * CHUNK_HEIGHT,
+            c[2] * CHUNK_LENGTH);
+        if (!chunk || chunk->num_vertices == 0) { continue; }
+        size_t i            = grid_index(grid, c);
+        grid->meshed[i]     = true;
+        grid->visibility[i] = chunk->visibility;
+        num_meshed++;
+      }
+    }
+  }
+  return num_meshed;
+}
+
+static void free_grid(ChunkGrid *grid) {
+  if (grid->meshed) { free(grid->meshed); }
+  if (grid->visibility) { free(grid->visibility); }
+  if (grid->reached) { free(grid->reached); }
+}
+
+// Count the meshed chunks inside the frustum, and those of them the last
+// walk reached
+static void count_drawn(const ChunkGrid *grid, vec4 planes[6], size_t *frustum,
+    size_t *occluded) {
+  int c[3];
+  for (c[0] = grid->min[0]; c[0] < grid->min[0] + grid->size[0]; c[0]++) {
+    for (c[1] = grid->min[1]; c[1] < grid->min[1] + grid->size[1]; c[1]++) {
+      for (c[2] = grid->min[2]; c[2] < grid->min[2] + grid->size[2]; c[2]++) {
+        size_t i = grid_index(grid, c);
+        if (!grid->meshed[i]) { continue; }
+        vec3 box[2] = {{(float)c[0] * CHUNK_WIDTH,
+                           (float)c[1] * CHUNK_HEIGHT,
+                           (float)c[2] * CHUNK_LENGTH},
+            {(float)(c[0] + 1) * CHUNK_WIDTH,
+                (float)(c[1] + 1) * CHUNK_HEIGHT,
+                (float)(c[2] + 1) * CHUNK_LENGTH}};
+        if (!glm_aabb_frustum(box, planes)) { continue; }
+        (*frustum)++;
+        *occluded += grid->reached[i];
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  int distance = argc > 1 ? atoi(argv[1]) : 6;
+  if (argc > 2 || distance < 1) {
+    fprintf(stderr, "Usage: %s [distance]\n", argv[0]);
+    return 1;
+  }
+
+  World *world = create_world_headless(SEED, 1);
+  if (!world) {
+    fprintf(stderr, "(main): Error: create_world_headless() returned NULL.\n");
+    return 1;
+  }
+  double start = get_time();
+  world_load_box(
+      world, -distance, -distance, -distance, distance, distance, distance);
+  wait_idle(world);
+  ChunkGrid grid    = {0};
+  size_t num_meshed = fill_grid(world, distance, &grid);
+  int ground_y      = distance * CHUNK_HEIGHT;
+  for (; ground_y > -distance * CHUNK_HEIGHT; ground_y--) {
+    Block *block = world_get_block(world, 0, ground_y, 0);
+    if (block && block->type != BlockAir) { break; }
+  }
+  destroy_world(&world);
+  if (num_meshed == 0) {
+    free_grid(&grid);
+    return 1;
+  }
+  printf("Loaded %zu chunks, %zu meshed, in %.1f s\n",
+      grid.cells,
+      num_meshed,
+      get_time() - start);
+
+  Camera *camera = create_camera(0.1f, distance * CHUNK_WIDTH * 1.8f, 90);
+  if (!camera) {
+    free_grid(&grid);
+    return 1;
+  }
+  OcclusionWalk walk = {0};
+  printf("%-22s %10s %10s %10s %10s\n",
+      "view",
+      "frustum",
+      "occluded",
+      "drawn %",
+      "walk us");
+  for (size_t v = 0; v < NUM_VIEWS; v++) {
+    const View *view = &views[v];
+    glm_vec3_copy(
+        (vec3){0.5f, (float)ground_y + 1 + view->height, 0.5f},
+        camera->position);
+    int eye[3] = {0, (int)floorf(camera->position[1] / CHUNK_HEIGHT), 0};
+
+    size_t frustum = 0, occluded = 0;
+    double walk_time = 0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+      camera->yaw   = glm_rad(360.f * (float)frame / FRAMES);
+      camera->pitch = glm_rad(view->pitch);
+      mat4 vp;
+      camera_calculate_vp_matrix(camera, vp, 16.f / 9.f);
+      vec4 planes[6];
+      glm_frustum_planes(vp, planes);
+
+      // If the eye is outside the box the walk can't start, and like the
+      // render list, everything in the frustum is drawn
+      memset(grid.reached, 0, grid.cells * sizeof(bool));
+      int max[3]        = {distance, distance, distance};
+      double walk_start = get_time();
+      if (!occlusion_walk(
+              &walk, eye, grid.min, max, planes, visit_chunk, &grid)) {
+        memset(grid.reached, 1, grid.cells * sizeof(bool));
+      }
+      walk_time += get_time() - walk_start;
+      count_drawn(&grid, planes, &frustum, &occluded);
+    }
+    printf("%-22s %10zu %10zu %9.1f%% %10.1f\n",
+        view->name,
+        frustum / FRAMES,
+        occluded / FRAMES,
+        frustum ? 100.0 * occluded / frustum : 100.0,
+        walk_time / FRAMES * 1e6);
+  }
+
+  occlusion_walk_free(&walk);
+  destroy_camera(&camera);
+  free_grid(&grid);
+  return 0;
+}
@@ -0,0 +1,189 @@
+// Measures block type queries on a fully loaded world. Loads every chunk in
+// the default render distance, then times world_find_nearest() and
+// world_count_blocks() against scanning the same blocks with
+// world_get_block(), and checks both find the same answer
+//
+// Usage: bench_query [-t threads]
+
+#include "bench_util.h"
+#include "world.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SEED 11
+// Times each indexed query is run, once is too quick to time
+#define REPEATS 100
+
+typedef struct {
+  const char *name;
+  BlockType type;
+  vec3 origin;
+  float radius;
+} NearestQuery;
+
+typedef struct {
+  const char *name;
+  BlockType type;
+  int lo[3], hi[3];
+} CountQuery;
+
+static const NearestQuery nearest_queries[] = {
+    {"log, r 64", BlockLog, {5, 80, 5}, 64},
+    {"diamond ore, r 64", BlockDiamondOre, {10, -100, -30}, 64},
+    {"dirt, r 48", BlockDirt, {-70, 20, 60}, 48},
+    {"leaves, r 32", BlockLeaves, {5, 80, 5}, 32},
+    {"diamond ore, r 32 (none)", BlockDiamondOre, {0, 120, 0}, 32},
+};
+
+static const CountQuery count_queries[] = {
+    {"diamond ore, 8^3 chunks", BlockDiamondOre, {-128, -256, -128},
+        {127, -1, 127}},
+    {"log, 200x100x200", BlockLog, {-100, 20, -100}, {99, 119, 99}},
+    {"stone, 100^3", BlockStone, {-37, -50, -61}, {62, 49, 38}},
+};
+
+#define NUM_NEAREST (sizeof(nearest_queries) / sizeof(nearest_queries[0]))
+#define NUM_COUNT (sizeof(count_queries) / sizeof(count_queries[0]))
+
+// Squared distance from a point to a block's centre
+static float block_dist2(const vec3 origin, const int block[3]) {
+  float d2 = 0;
+  for (int i = 0; i < 3; i++) {
+    float d = (float)block[i] + 0.5f - origin[i];
+    d2 += d * d;
+  }
+  return d2;
+}
+
+// Find the nearest block of a type by reading every block in range, returns
+// its squared distance, or -1 if there is none
+static float scan_nearest(World *world, const NearestQuery *query) {
+  const float *o = query->origin;
+  float r        = query->radius;
+  float best     = -1;
+  int block[3];
+  for (block[0] = (int)floorf(o[0] - r); block[0] <= (int)floorf(o[0] + r);
+      block[0]++) {
+    for (block[1] = (int)floorf(o[1] - r); block[1] <= (int)floorf(o[1] + r);
+        block[1]++) {
+      for (block[2] = (int)floorf(o[2] - r);
+          block[2] <= (int)floorf(o[2] + r);
+          block[2]++) {
+        Block *b = world_get_block(world, block[0], block[1], block[2]);
+        if (!b || b->type != query->type) { continue; }
+        float d2 = block_dist2(o, block);
+        if (d2 <= r * r && (best < 0 || d2 < best)) { best = d2; }
+      }
+    }
+  }
+  return best;
+}
+
+static size_t scan_count(World *world, const CountQuery *query) {
+  size_t count = 0;
+  for (int x = query->lo[0]; x <= query->hi[0]; x++) {
+    for (int y = query->lo[1]; y <= query->hi[1]; y++) {
+      for (int z = query->lo[2]; z <= query->hi[2]; z++) {
+        Block *b = world_get_block(world, x, y, z);
+        count += b && b->type == query->type;
+      }
+    }
+  }
+  return count;
+}
+
+int main(int argc, char **argv) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (argc == 3 && strcmp(argv[1], "-t") == 0) {
+    threads = atol(argv[2]);
+  } else if (argc != 1) {
+    fprintf(stderr, "Usage: %s [-t threads]\n", argv[0]);
+    return 1;
+  }
+  if (threads < 1) { threads = 1; }
+
+  World *world = create_world_headless(SEED, (size_t)threads);
+  if (!world) {
+    fprintf(stderr, "(main): Error: create_world_headless() returned NULL.\n");
+    return 1;
+  }
+  world->mesh_chunks = false;
+  double start       = get_time();
+  int rx = (int)world->rdx, ry = (int)world->rdy, rz = (int)world->rdz;
+  world_load_box(world, -rx, -ry, -rz, rx, ry, rz);
+  wait_idle(world);
+  printf("Loaded %d chunks in %.1f s\n",
+      (2 * rx + 1) * (2 * ry + 1) * (2 * rz + 1),
+      get_time() - start);
+
+  int status = 0;
+  printf("%-26s %12s %12s  result\n", "nearest", "indexed us", "scan ms");
+  for (size_t q = 0; q < NUM_NEAREST; q++) {
+    const NearestQuery *query = &nearest_queries[q];
+    int found[3];
+    bool any = false;
+    start    = get_time();
+    for (int i = 0; i < REPEATS; i++) {
+      any = world_find_nearest(
+          world, query->type, query->origin, query->radius, found);
+    }
+    double indexed = (get_time() - start) / REPEATS;
+
+    start          = get_time();
+    float scan_d2  = scan_nearest(world, query);
+    double scanned = get_time() - start;
+
+    float d2 = any ? block_dist2(query->origin, found) : -1;
+    printf("%-26s %12.1f %12.1f  ",
+        query->name,
+        indexed * 1e6,
+        scanned * 1e3);
+    if (any) {
+      printf("%.1f blocks away\n", sqrtf(d2));
+    } else {
+      printf("none\n");
+    }
+    if (d2 != scan_d2) {
+      fprintf(stderr,
+          "(main): %s: the index and the scan found different blocks.\n",
+          query->name);
+      status = 1;
+    }
+  }
+
+  printf("%-26s %12s %12s  result\n", "count", "indexed us", "scan ms");
+  for (size_t q = 0; q < NUM_COUNT; q++) {
+    const CountQuery *query = &count_queries[q];
+    const int *lo = query->lo, *hi = query->hi;
+    size_t count  = 0;
+    start         = get_time();
+    for (int i = 0; i < REPEATS; i++) {
+      count = world_count_blocks(
+          world, query->type, lo[0], lo[1], lo[2], hi[0], hi[1], hi[2]);
+    }
+    double indexed = (get_time() - start) / REPEATS;
+
+    start             = get_time();
+    size_t scan_total = scan_count(world, query);
+    double scanned    = get_time() - start;
+
+    printf("%-26s %12.1f %12.1f  %zu blocks\n",
+        query->name,
+        indexed * 1e6,
+        scanned * 1e3,
+        count);
+    if (count != scan_total) {
+      fprintf(stderr,
+          "(main): %s: the index counted %zu, the scan %zu.\n",
+          query->name,
+          count,
+          scan_total);
+      status = 1;
+    }
+  }
+
+  destroy_world(&world);
+  return status;
+}
@@ -0,0 +1,143 @@
+// Measures raycasts through a loaded world. Casts batches of rays shaped like
+// the game's uses (block selection, long line of sight checks, an explosion's
+// rays from one point) with world_raycast() one at a time and with
+// world_raycast_batch(), and reports rays per second. Each batch is timed a
+// few times and the fastest is kept
+//
+// Usage: bench_raycast [rays]
+//   rays  Rays in each batch (default: 200000)
+
+#include "bench_util.h"
+#include "world.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SEED 3
+#define ROUNDS 3
+
+typedef enum {
+  RAYS_SELECTION,
+  RAYS_SIGHT,
+  RAYS_EXPLOSION,
+  NUM_RAY_KINDS
+} RayKind;
+
+static const char *ray_kind_names[NUM_RAY_KINDS] = {
+    "selection, 4.5 blocks", "line of sight, 160", "explosion, 16"};
+
+static uint64_t rng_state = 99;
+
+static float rand_float(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (float)(uint32_t)rng_state / 4294967296.f;
+}
+
+// Fill a batch with rays of one kind. Explosions cast from just above the
+// ground at ground_y, the rest from scattered points over the world
+static void make_rays(WorldRay *rays, size_t num_rays, RayKind kind,
+    int ground_y) {
+  for (size_t i = 0; i < num_rays; i++) {
+    float yaw   = glm_rad(rand_float() * 360);
+    float pitch = glm_rad((rand_float() - 0.5f) * 180);
+    rays[i].dir[0] = cosf(pitch) * cosf(yaw);
+    rays[i].dir[1] = sinf(pitch);
+    rays[i].dir[2] = cosf(pitch) * sinf(yaw);
+    // Callers don't always normalise
+    rays[i].dir[0] *= (float)(1 + i % 3);
+
+    if (kind == RAYS_EXPLOSION) {
+      glm_vec3_copy((vec3){3.5f, ground_y + 1.5f, -2.5f}, rays[i].origin);
+      rays[i].max_dist = 16;
+      continue;
+    }
+    rays[i].origin[0] = (rand_float() - 0.5f) * 100;
+    rays[i].origin[1] = 60 + rand_float() * 40;
+    rays[i].origin[2] = (rand_float() - 0.5f) * 100;
+    rays[i].max_dist  = kind == RAYS_SELECTION ? 4.5f : 160;
+  }
+}
+
+static bool same_hit(const RayCastReturn *a, const RayCastReturn *b) {
+  if (a->hit != b->hit) { return false; }
+  return !a->hit
+         || (a->hit_x == b->hit_x && a->hit_y == b->hit_y
+             && a->hit_z == b->hit_z);
+}
+
+int main(int argc, char **argv) {
+  long num_rays = argc > 1 ? atol(argv[1]) : 200000;
+  if (argc > 2 || num_rays < 1) {
+    fprintf(stderr, "Usage: %s [rays]\n", argv[0]);
+    return 1;
+  }
+
+  World *world           = create_world_headless(SEED, 1);
+  WorldRay *rays         = malloc(sizeof(WorldRay) * num_rays);
+  RayCastReturn *single  = malloc(sizeof(RayCastReturn) * num_rays);
+  RayCastReturn *batched = malloc(sizeof(RayCastReturn) * num_rays);
+  if (!world || !rays || !single || !batched) {
+    fprintf(stderr, "(main): Error: couldn't set up the world.\n");
+    return 1;
+  }
+  world->mesh_chunks = false;
+  world_load_box(world, -4, 0, -4, 4, 4, 4);
+  wait_idle(world);
+  int ground_y = 4 * CHUNK_HEIGHT;
+  for (; ground_y > 0; ground_y--) {
+    Block *block = world_get_block(world, 3, ground_y, -3);
+    if (block && block->type != BlockAir) { break; }
+  }
+
+  printf("%-22s  %14s  %14s  hits\n", "rays", "single M/s", "batch M/s");
+  int status = 0;
+  for (RayKind kind = 0; kind < NUM_RAY_KINDS; kind++) {
+    make_rays(rays, (size_t)num_rays, kind, ground_y);
+    double single_time = 0, batch_time = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+      double start = get_time();
+      for (long i = 0; i < num_rays; i++) {
+        const WorldRay *ray = &rays[i];
+        single[i]           = world_raycast(world,
+            ray->origin[0],
+            ray->origin[1],
+            ray->origin[2],
+            ray->dir[0],
+            ray->dir[1],
+            ray->dir[2],
+            ray->max_dist);
+      }
+      double time = get_time() - start;
+      if (round == 0 || time < single_time) { single_time = time; }
+
+      start = get_time();
+      world_raycast_batch(world, rays, (size_t)num_rays, batched);
+      time = get_time() - start;
+      if (round == 0 || time < batch_time) { batch_time = time; }
+    }
+
+    size_t hits = 0, differ = 0;
+    for (long i = 0; i < num_rays; i++) {
+      hits += single[i].hit;
+      differ += !same_hit(&single[i], &batched[i]);
+    }
+    printf("%-22s  %14.2f  %14.2f  %.0f%%\n",
+        ray_kind_names[kind],
+        num_rays / single_time / 1e6,
+        num_rays / batch_time / 1e6,
+        100.0 * hits / num_rays);
+    if (differ > 0) {
+      fprintf(stderr,
+          "(main): %zu batched rays hit somewhere else than alone.\n",
+          differ);
+      status = 1;
+    }
+  }
+
+  free(rays);
+  free(single);
+  free(batched);
+  destroy_world(&world);
+  return status;
+}
@@ -0,0 +1,139 @@
+// Measures simulation ticks without a window. Drives sim_tick() by hand with
+// scripted input (walking, jumping, sprinting, breaking and placing blocks)
+// in a headless world, and reports the time per tick against the tick
+// budget. Chunks stream in between ticks and the benchmark waits for them,
+// so every run sees the same world; the whole script is run twice and the
+// player's path must match
+//
+// Usage: bench_sim [ticks]
+//   ticks  Ticks in each run (default: 3000)
+
+#include "bench_util.h"
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SEED 3
+
+typedef struct {
+  double *tick_times; // Seconds each tick took
+  uint64_t hash;      // FNV-1a hash of the player's position after each tick
+} SimRun;
+
+static uint64_t rng_state;
+
+static uint32_t script_rand(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (uint32_t)rng_state;
+}
+
+static int compare_times(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Run the script for a number of ticks, returns false on failure
+static bool run_script(int ticks, SimRun *run) {
+  World *world   = create_world_headless(SEED, 1);
+  Player *player = create_player();
+  Sim *sim       = world && player ? create_sim(world, player) : NULL;
+  if (!sim) {
+    fprintf(stderr, "(run_script): Error: couldn't create the simulation.\n");
+    if (player) { destroy_player(&player); }
+    if (world) { destroy_world(&world); }
+    return false;
+  }
+  world->rdx          = 3;
+  world->rdy          = 2;
+  world->rdz          = 3;
+  player->position[1] = 110;
+  // The first tick loads the chunks around the player
+  sim_tick(sim);
+  wait_idle(world);
+
+  rng_state = 777;
+  run->hash = 1469598103934665603ull;
+  for (int i = 0; i < ticks; i++) {
+    // Walk in a slowly turning line, with the odd jump, sprint, break and
+    // place along the way
+    uint32_t r     = script_rand();
+    SimInput input = {
+        .hold  = r & (SIM_HOLD_FORWARDS | SIM_HOLD_LEFT | SIM_HOLD_RIGHT
+                        | SIM_HOLD_JUMP | SIM_HOLD_CROUCH),
+        .yaw   = (float)(i / 120) * 0.7f,
+        .pitch = -0.3f,
+    };
+    if (((r >> 8) & 63) == 0) { input.press |= SIM_PRESS_SPRINT; }
+    if (((r >> 14) & 31) == 0) { input.press |= SIM_PRESS_BREAK; }
+    if (((r >> 19) & 31) == 0) { input.press |= SIM_PRESS_PLACE; }
+    sim_push_input(sim, input);
+
+    double start = get_time();
+    sim_tick(sim);
+    run->tick_times[i] = get_time() - start;
+    wait_idle(world);
+
+    const unsigned char *bytes = (const unsigned char *)player->position;
+    for (size_t b = 0; b < sizeof(vec3); b++) {
+      run->hash = (run->hash ^ bytes[b]) * 1099511628211ull;
+    }
+  }
+
+  destroy_sim(&sim);
+  destroy_player(&player);
+  destroy_world(&world);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int ticks = argc > 1 ? atoi(argv[1]) : 3000;
+  if (argc > 2 || ticks < 1) {
+    fprintf(stderr, "Usage: %s [ticks]\n", argv[0]);
+    return 1;
+  }
+
+  SimRun runs[2];
+  for (int r = 0; r < 2; r++) {
+    runs[r].tick_times = malloc(sizeof(double) * ticks);
+    if (!runs[r].tick_times) {
+      fprintf(stderr, "(main): Error: malloc failed.\n");
+      return 1;
+    }
+    if (!run_script(ticks, &runs[r])) { return 1; }
+  }
+
+  // Both runs' ticks together
+  size_t num_times = (size_t)ticks * 2;
+  double *times    = malloc(sizeof(double) * num_times);
+  if (!times) {
+    fprintf(stderr, "(main): Error: malloc failed.\n");
+    return 1;
+  }
+  double total = 0;
+  for (int r = 0; r < 2; r++) {
+    for (int i = 0; i < ticks; i++) {
+      times[(size_t)r * ticks + i] = runs[r].tick_times[i];
+      total += runs[r].tick_times[i];
+    }
+  }
+  qsort(times, num_times, sizeof(double), compare_times);
+
+  double mean = total / (double)num_times;
+  printf("%d ticks at %d Hz, run twice\n", ticks, SIM_TICK_RATE);
+  printf("mean %8.1f us, %.2f%% of the tick budget\n",
+      mean * 1e6,
+      mean / SIM_TICK_TIME * 100.0);
+  printf("p50  %8.1f us\n", times[num_times / 2] * 1e6);
+  printf("p99  %8.1f us\n", times[num_times * 99 / 100] * 1e6);
+  printf("max  %8.1f us\n", times[num_times - 1] * 1e6);
+
+  bool same = runs[0].hash == runs[1].hash;
+  printf("player path %s\n", same ? "matched" : "DIFFERED between runs");
+
+  free(times);
+  free(runs[0].tick_times);
+  free(runs[1].tick_times);
+  return same ? 0 : 1;
+}
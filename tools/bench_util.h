@@ -0,0 +1,23 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+// Helpers shared by the headless tools, benchmarks and tests
+
+// Includes
+#include "world.h"
+#include <time.h>
+#include <unistd.h>
+
+// Seconds on a monotonic clock
+static inline double get_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Wait until every queued chunk has been generated (and meshed)
+static inline void wait_idle(World *world) {
+  while (!world_is_idle(world)) { usleep(100); }
+}
+
+#endif // bench_util.h
@@ -0,0 +1,134 @@
+// Headless world pregeneration. Generates (and optionally meshes) every chunk
+// in a box of chunk coords on all cores, then saves them to a directory
+//
+// Usage: pregen <seed> <x0> <y0> <z0> <x1> <y1> <z1> [-o dir] [-m] [-t threads]
+
+#include "bench_util.h"
+#include "noise.h"
+#include "world.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void print_usage(const char *name) {
+  fprintf(stderr,
+      "Usage: %s <seed> <x0> <y0> <z0> <x1> <y1> <z1> [-o dir] [-m] "
+      "[-t threads]\n"
+      "  Coordinates are inclusive chunk coordinates.\n"
+      "  -o dir      Save generated chunks to dir\n"
+      "  -m          Mesh chunks after generating them\n"
+      "  -t threads  Number of worker threads (default: all cores)\n",
+      name);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 8) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  uint32_t seed = (uint32_t)strtoul(argv[1], NULL, 10);
+  int box[6];
+  for (int i = 0; i < 6; i++) { box[i] = atoi(argv[i + 2]); }
+  const char *out_dir = NULL;
+  bool mesh           = false;
+  long threads        = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int i = 8; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      out_dir = argv[++i];
+    } else if (strcmp(argv[i], "-m") == 0) {
+      mesh = true;
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      threads = atol(argv[++i]);
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+  if (threads < 1) { threads = 1; }
+  for (int i = 0; i < 3; i++) {
+    if (box[i] > box[i + 3]) {
+      int tmp    = box[i];
+      box[i]     = box[i + 3];
+      box[i + 3] = tmp;
+    }
+  }
+  size_t num_chunks = (size_t)(box[3] - box[0] + 1) * (box[4] - box[1] + 1)
+                      * (box[5] - box[2] + 1);
+
+  World *world = create_world_headless(seed, (size_t)threads);
+  if (!world) {
+    fprintf(stderr, "(main): Error: create_world_headless() returned NULL.\n");
+    return 1;
+  }
+  world->mesh_chunks = mesh;
+  // Generate from the middle of the box outwards
+  world->cx = (box[0] + box[3]) / 2;
+  world->cy = (box[1] + box[4]) / 2;
+  world->cz = (box[2] + box[5]) / 2;
+
+  printf("Generating %zu chunks with seed %u on %ld threads...\n",
+      num_chunks,
+      seed,
+      threads);
+  double start = get_time();
+  world_load_box(world, box[0], box[1], box[2], box[3], box[4], box[5]);
+  wait_idle(world);
+  double elapsed = get_time() - start;
+
+  // Measure what the loaded chunks hold
+  size_t block_bytes  = 0;
+  size_t vertex_bytes = 0;
+  size_t num_vertices = 0;
+  for (size_t i = 0; i < HASHMAP_SIZE; i++) {
+    for (ChunkNode *node = world->map.buckets[i]; node; node = node->next) {
+      Chunk *chunk = node->chunk;
+      if (!chunk) { continue; }
+      if (chunk->blocks) { block_bytes += CHUNK_VOLUME * sizeof(Block); }
+      vertex_bytes += chunk->num_vertices * sizeof(Vertex);
+      num_vertices += chunk->num_vertices;
+    }
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  printf("Generated %zu chunks in %.3f s (%.1f chunks/s)\n",
+      num_chunks,
+      elapsed,
+      num_chunks / elapsed);
+  printf("Block data: %.1f MiB\n", block_bytes / (1024.0 * 1024.0));
+  if (mesh) {
+    printf("Mesh data: %.1f MiB (%zu vertices)\n",
+        vertex_bytes / (1024.0 * 1024.0),
+        num_vertices);
+  }
+  printf("Peak resident memory: %.1f MiB\n", usage.ru_maxrss / 1024.0);
+  // Only counted when built with -DNOISE_STATS
+  size_t hashes = noise_hash_count();
+  if (hashes > 0) {
+    printf("Noise hashes: %zu (%.1f per chunk)\n",
+        hashes,
+        (double)hashes / num_chunks);
+  }
+
+  int status = 0;
+  if (out_dir) {
+    if (mkdir(out_dir, 0755) != 0 && errno != EEXIST) {
+      fprintf(stderr, "(main): Error: couldn't create %s.\n", out_dir);
+      status = 1;
+    } else {
+      double save_start = get_time();
+      size_t saved      = world_save(world, out_dir);
+      printf("Saved %zu chunks to %s in %.3f s\n",
+          saved,
+          out_dir,
+          get_time() - save_start);
+      if (saved != num_chunks) { status = 1; }
+    }
+  }
+
+  destroy_world(&world);
+  return status;
+}